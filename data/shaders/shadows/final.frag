@@ -51,7 +51,7 @@ buffer readonly BWorldTransforms {
 
 layout (set = 0, binding = 4, rg32ui) uniform uimage2D u_visibility;
 
-layout (set = 0, binding = 5) uniform sampler2D[] u_textures;
+layout (set = 2, binding = 0) uniform sampler2D[] u_textures;
 
 layout (std430, set = 1, binding = 0)
 buffer readonly BPointLights {
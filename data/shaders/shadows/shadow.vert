@@ -32,10 +32,27 @@ buffer readonly BObjectData {
     SObjectData[] object_data;
 };
 
+layout (set = 0, binding = 4, scalar)
+buffer readonly BObjectIDRemap {
+    uint[] object_id_remap;
+};
+
+layout (set = 0, binding = 5, scalar)
+buffer readonly BInstanceOffsets {
+    uint[] instance_offsets;
+};
+
+layout (set = 0, binding = 6, scalar)
+buffer readonly BInstanceIDRemap {
+    uint[] instance_id_remap;
+};
+
 layout (push_constant)
 uniform UIndices {
     uint object_offset;
     uint shadow_layer;
+    uint object_count;
+    uint instance_count;
 };
 
 mat4 compute_current_transform(SObjectData object, uint instance_id) {
@@ -45,8 +62,11 @@ mat4 compute_current_transform(SObjectData object, uint instance_id) {
 }
 
 void main() {
-    const SObjectData constants = object_data[gl_DrawID + object_offset];
-    const mat4 current_model = compute_current_transform(constants, gl_InstanceIndex);
+    // Draws and instances were compacted per cascade by "shadow_cull.comp"
+    const uint object_id = object_id_remap[shadow_layer * object_count + object_offset + gl_DrawID];
+    const uint instance_id = instance_id_remap[shadow_layer * instance_count + instance_offsets[object_id] + gl_InstanceIndex];
+    const SObjectData constants = object_data[object_id];
+    const mat4 current_model = compute_current_transform(constants, instance_id);
     gl_Position = shadow_cascades[shadow_layer].proj_view * current_model * vec4(i_vertex, 1.0);
     gl_Layer = int(shadow_layer);
 }
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <utility>
+#include <atomic>
+
+namespace am {
+    // Lock-free multiple producer, single consumer queue. "push()" never blocks, "try_pop()"
+    // may report an empty queue while a producer is still linking its node in.
+    template <typename T>
+    class AM_MODULE CMPSCQueue {
+    public:
+        using Self = CMPSCQueue;
+        using ValueType = T;
+
+        CMPSCQueue() noexcept;
+        ~CMPSCQueue() noexcept;
+        AM_DELETE_COPY(CMPSCQueue);
+        AM_DELETE_MOVE(CMPSCQueue);
+
+        void push(T&&) noexcept;
+        AM_NODISCARD bool try_pop(T&) noexcept;
+        template <typename F>
+        uint32 drain(F&&) noexcept;
+
+    private:
+        struct SNode {
+            T value = {};
+            std::atomic<SNode*> next = nullptr;
+        };
+
+        alignas(64) std::atomic<SNode*> _head = nullptr;
+        alignas(64) SNode* _tail = nullptr;
+    };
+
+    template <typename T>
+    CMPSCQueue<T>::CMPSCQueue() noexcept {
+        AM_PROFILE_SCOPED();
+        auto* stub = new SNode();
+        _head.store(stub, std::memory_order_relaxed);
+        _tail = stub;
+    }
+
+    template <typename T>
+    CMPSCQueue<T>::~CMPSCQueue() noexcept {
+        AM_PROFILE_SCOPED();
+        T value;
+        while (try_pop(value));
+        delete _tail;
+    }
+
+    template <typename T>
+    void CMPSCQueue<T>::push(T&& value) noexcept {
+        AM_PROFILE_SCOPED();
+        auto* node = new SNode();
+        node->value = std::move(value);
+        auto* previous = _head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    template <typename T>
+    AM_NODISCARD bool CMPSCQueue<T>::try_pop(T& value) noexcept {
+        AM_PROFILE_SCOPED();
+        auto* next = _tail->next.load(std::memory_order_acquire);
+        AM_LIKELY_IF(!next) {
+            return false;
+        }
+        // "next" becomes the new stub, its value is moved out and left in a default state
+        value = std::move(next->value);
+        next->value = {};
+        delete std::exchange(_tail, next);
+        return true;
+    }
+
+    template <typename T>
+    template <typename F>
+    uint32 CMPSCQueue<T>::drain(F&& func) noexcept {
+        AM_PROFILE_SCOPED();
+        uint32 count = 0;
+        T value;
+        while (try_pop(value)) {
+            func(std::move(value));
+            count++;
+        }
+        return count;
+    }
+} // namespace am
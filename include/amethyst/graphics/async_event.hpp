@@ -0,0 +1,66 @@
+#pragma once
+
+#include <amethyst/core/mpsc_queue.hpp>
+#include <amethyst/core/rc_ptr.hpp>
+
+#include <amethyst/graphics/async_texture.hpp>
+#include <amethyst/graphics/async_model.hpp>
+#include <amethyst/graphics/async_mesh.hpp>
+#include <amethyst/graphics/device.hpp>
+
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <type_traits>
+
+namespace am {
+    enum class EAsyncResource {
+        Mesh,
+        Texture,
+        Model
+    };
+
+    // Published by the async loaders once their task is done, keeps the resource alive until drained.
+    struct SReadyEvent {
+        EAsyncResource type = {};
+        CRcPtr<CAsyncMesh> mesh;
+        CRcPtr<CAsyncTexture> texture;
+        CRcPtr<CAsyncModel> model;
+    };
+
+    using ReadyEventQueue = CMPSCQueue<SReadyEvent>;
+
+    namespace prv {
+        template <typename T>
+        AM_NODISCARD static inline CRcPtr<T> try_acquire(T* resource) noexcept {
+            AM_PROFILE_SCOPED();
+            // The resource may already be in its destructor, waiting for the very work that acquires it
+            AM_UNLIKELY_IF(resource->grab() == 1) {
+                resource->drop();
+                return nullptr;
+            }
+            return CRcPtr<T>::make(resource, dont_grab);
+        }
+
+        template <typename T>
+        static inline void publish_ready(CDevice* device, CRcPtr<T>&& resource) noexcept {
+            AM_PROFILE_SCOPED();
+            AM_UNLIKELY_IF(!resource) {
+                return;
+            }
+            SReadyEvent event = {};
+            if constexpr (std::is_same_v<T, CAsyncMesh>) {
+                event.type = EAsyncResource::Mesh;
+                event.mesh = std::move(resource);
+            } else if constexpr (std::is_same_v<T, CAsyncTexture>) {
+                event.type = EAsyncResource::Texture;
+                event.texture = std::move(resource);
+            } else if constexpr (std::is_same_v<T, CAsyncModel>) {
+                event.type = EAsyncResource::Model;
+                event.model = std::move(resource);
+            }
+            device->ready_events()->push(std::move(event));
+        }
+    } // namespace am::prv
+} // namespace am
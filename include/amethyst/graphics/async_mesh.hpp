@@ -19,6 +19,7 @@
 #include <glm/vec2.hpp>
 
 #include <vector>
+#include <atomic>
 
 namespace am {
     namespace prv {
@@ -59,6 +60,7 @@ namespace am {
         CBufferSlice _vertices;
         CBufferSlice _indices;
         mutable std::unique_ptr<enki::TaskSet> _task; // nullptr if it was not requested via "make()"
+        std::atomic<bool> _ready = false; // Set once the upload retired on the GPU
 
         CRcPtr<CDevice> _device;
     };
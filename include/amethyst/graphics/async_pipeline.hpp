@@ -0,0 +1,62 @@
+#pragma once
+
+#include <amethyst/core/rc_ptr.hpp>
+
+#include <amethyst/graphics/pipeline.hpp>
+#include <amethyst/graphics/device.hpp>
+
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <atomic>
+
+namespace am {
+    // Builds a "CPipeline" on an enki worker, its stages compiling concurrently. A reload keeps the current pipeline
+    // bound until the new one is built, "update()" then swaps it in and retires the old one once no frame uses it.
+    class AM_MODULE CAsyncPipeline : public IRefCounted {
+    public:
+        using Self = CAsyncPipeline;
+
+        ~CAsyncPipeline() noexcept;
+
+        AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>, CPipeline::SGraphicsCreateInfo&&) noexcept;
+        AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>, CPipeline::SComputeCreateInfo&&) noexcept;
+
+        // Null until the first build is done
+        AM_NODISCARD const CRcPtr<CPipeline>& handle() const noexcept;
+
+        AM_NODISCARD bool is_ready() const noexcept;
+        AM_NODISCARD bool is_pending() const noexcept;
+        // Rebuilds from the same create info along with every variant of the current pipeline, a reload requested
+        // during a build starts once it is done
+        void reload() noexcept;
+        // Swaps in a finished build and returns true if it did, must not race "handle()". A build that failed to
+        // compile is dropped and the current pipeline kept
+        AM_NODISCARD bool update() noexcept;
+        // Every shader file the pipeline was built from, includes excluded
+        AM_NODISCARD std::vector<std::filesystem::path> sources() const noexcept;
+        // Blocks until the pending build is done and swapped in
+        void wait() noexcept;
+
+    private:
+        CAsyncPipeline() noexcept;
+
+        void _build() noexcept;
+
+        CPipeline::SGraphicsCreateInfo _graphics_info;
+        CPipeline::SComputeCreateInfo _compute_info;
+        EPipelineType _type = {};
+
+        CRcPtr<CPipeline> _handle;
+        CRcPtr<CPipeline> _pending;
+        std::unique_ptr<enki::TaskSet> _task;
+        std::atomic<bool> _done = false;
+        bool _reload = false;
+
+        CRcPtr<CDevice> _device;
+    };
+} // namespace am
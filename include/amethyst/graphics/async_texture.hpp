@@ -17,6 +17,7 @@
 
 #include <filesystem>
 #include <vector>
+#include <atomic>
 
 namespace am {
     enum class ETextureType {
@@ -46,6 +47,14 @@ namespace am {
         struct SCreateInfo {
             std::filesystem::path path;
             ETextureType type = {};
+            // Sampler of the texture's "CTextureHeap" slot
+            SSamplerInfo sampler = {
+                .filter = EFilter::Linear,
+                .mip_mode = EMipMode::Linear,
+                .border_color = EBorderColor::FloatOpaqueBlack,
+                .address_mode = EAddressMode::Repeat,
+                .anisotropy = 16
+            };
         };
 
         ~CAsyncTexture() noexcept;
@@ -54,6 +63,9 @@ namespace am {
         AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>, SCreateInfo&&) noexcept;
 
         AM_NODISCARD const CImage* handle() const noexcept;
+        // Index into the device's "CTextureHeap", fixed once ready. "CTextureHeap::null_slot" before that or if the
+        // load failed, the slot's descriptor is written by the heap's next "flush()"
+        AM_NODISCARD uint32 slot() const noexcept;
 
         AM_NODISCARD bool is_ready() const noexcept;
         void wait() const noexcept;
@@ -62,8 +74,10 @@ namespace am {
         CAsyncTexture() noexcept;
 
         CRcPtr<CImage> _handle;
+        uint32 _slot = 0; // Published by "_ready"
 
         mutable std::unique_ptr<enki::TaskSet> _task; // nullptr if it was not requested via "make()"
+        std::atomic<bool> _ready = false; // Set once the upload retired on the GPU, or failed
 
         CRcPtr<CDevice> _device;
     };
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <amethyst/core/rc_ptr.hpp>
+
+#include <amethyst/graphics/command_buffer.hpp>
+#include <amethyst/graphics/device.hpp>
+#include <amethyst/graphics/queue.hpp>
+
+#include <amethyst/meta/constants.hpp>
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <vulkan/vulkan.h>
+#include <volk.h>
+
+#include <memory>
+#include <vector>
+#include <array>
+
+namespace am {
+    // One command pool per frame in flight and per scheduler thread. Command buffers are handed out linearly
+    // and the pools of a frame are reset in bulk once the frame retired, so steady state recording allocates nothing.
+    class AM_MODULE CCommandAllocator : public IRefCounted {
+    public:
+        using Self = CCommandAllocator;
+        struct SCreateInfo {
+            EQueueType queue = {};
+        };
+
+        ~CCommandAllocator() noexcept;
+
+        AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>, SCreateInfo&&) noexcept;
+
+        AM_NODISCARD uint32 frame() const noexcept;
+        AM_NODISCARD uint32 threads() const noexcept;
+
+        // The previous submission of this frame slot must have retired
+        void begin_frame(uint32) noexcept;
+        // Only valid until the next "begin_frame()" on the same slot, "thread" must be the calling enki thread
+        AM_NODISCARD CCommandBuffer& acquire(uint32, ECommandBufferLevel = ECommandBufferLevel::Primary) noexcept;
+
+    private:
+        struct alignas(64) SThreadPool {
+            VkCommandPool handle = {};
+            std::array<std::vector<CRcPtr<CCommandBuffer>>, 2> commands;
+            std::array<uint32, 2> used = {};
+        };
+
+        CCommandAllocator() noexcept;
+
+        AM_NODISCARD SThreadPool& _pool(uint32, uint32) noexcept;
+
+        std::vector<SThreadPool> _pools;
+        EQueueType _queue = {};
+        uint32 _threads = 0;
+        uint32 _frame = 0;
+
+        CRcPtr<CDevice> _device;
+    };
+} // namespace am
@@ -16,6 +16,7 @@
 #include <volk.h>
 
 #include <vector>
+#include <array>
 
 namespace am {
     struct SMemoryBarrier {
@@ -45,6 +46,39 @@ namespace am {
         uint32 mip = all_mips;
     };
 
+    // Collects barriers and issues them with a single "vkCmdPipelineBarrier2". Barriers on the same resource, range and
+    // layouts are merged into one entry. Storage is kept across flushes, reuse the batch to avoid reallocating
+    class AM_MODULE CBarrierBatch {
+    public:
+        using Self = CBarrierBatch;
+
+        Self& memory(const SMemoryBarrier&) noexcept;
+        Self& buffer(const SBufferMemoryBarrier&) noexcept;
+        Self& image(const SImageMemoryBarrier&) noexcept;
+        Self& transfer_ownership(const CQueue&, const CQueue&, const SBufferMemoryBarrier&) noexcept;
+        Self& transfer_ownership(const CQueue&, const CQueue&, const SImageMemoryBarrier&) noexcept;
+
+        AM_NODISCARD bool empty() const noexcept;
+        // Barriers left after merging
+        AM_NODISCARD uint32 size() const noexcept;
+        void clear() noexcept;
+
+    private:
+        friend class CCommandBuffer;
+
+        void _buffer(const SBufferMemoryBarrier&, uint32, uint32) noexcept;
+        void _image(const SImageMemoryBarrier&, uint32, uint32) noexcept;
+        void _flush_legacy(VkCommandBuffer) noexcept;
+
+        std::vector<VkMemoryBarrier2> _memory;
+        std::vector<VkBufferMemoryBarrier2> _buffers;
+        std::vector<VkImageMemoryBarrier2> _images;
+
+        // Devices without synchronization2 get the barriers translated
+        std::vector<VkBufferMemoryBarrier> _legacy_buffers;
+        std::vector<VkImageMemoryBarrier> _legacy_images;
+    };
+
     struct SDrawCommandIndirect {
         uint32 vertices = 0;
         uint32 instances = 0;
@@ -60,6 +94,11 @@ namespace am {
         uint32 first_instance = 0;
     };
 
+    enum class ECommandBufferLevel {
+        Primary,
+        Secondary
+    };
+
     class AM_MODULE CCommandBuffer : public IRefCounted {
     public:
         using Self = CCommandBuffer;
@@ -78,12 +117,18 @@ namespace am {
         AM_NODISCARD VkCommandPool pool() const noexcept;
 
         Self& begin() noexcept;
+        // Secondary command buffers only, continues the render pass of the given framebuffer. The statistics are those of
+        // any pipeline statistics query active in the primary executing it
+        Self& begin(const CFramebuffer*, const CRenderPass* = nullptr, EQueryPipelineStatistics = {}) noexcept;
         Self& begin_render_pass(const CFramebuffer*, const CRenderPass* = nullptr) noexcept;
+        Self& begin_render_pass(const CFramebuffer*, SSecondaryCommandsTag, const CRenderPass* = nullptr) noexcept;
         Self& bind_pipeline(const CPipeline*) noexcept;
         Self& set_viewport() noexcept;
         Self& set_viewport(SInvertedViewportTag) noexcept;
         Self& set_scissor() noexcept;
         Self& bind_descriptor_set(const CDescriptorSet*) noexcept;
+        // Binds the device's "CTextureHeap" at "CTextureHeap::set_index" of the active pipeline
+        Self& bind_texture_heap() noexcept;
         Self& bind_vertex_buffer(const SBufferInfo&) noexcept;
         Self& bind_index_buffer(const SBufferInfo&) noexcept;
         Self& bind_mesh(const CAsyncMesh*) noexcept;
@@ -93,13 +138,18 @@ namespace am {
         Self& draw_indirect(const SBufferInfo&, uint32) noexcept;
         Self& draw_indexed_indirect(const SBufferInfo&, uint32) noexcept;
         Self& draw_indexed_indirect_count(const SBufferInfo&, const SBufferInfo&, uint32) noexcept;
+        Self& execute(const std::vector<CCommandBuffer*>&) noexcept;
         Self& end_render_pass() noexcept;
         Self& dispatch(uint32 = 1, uint32 = 1, uint32 = 1) noexcept;
         Self& copy_buffer(const SBufferInfo&, const SBufferInfo&) noexcept;
+        // Size and offset must be multiples of 4, the buffer needs "TransferDST" usage
+        Self& fill_buffer(const SBufferInfo&, uint32 = 0) noexcept;
         Self& copy_buffer_to_image(const SBufferInfo&, const CImage*, uint32 = 0) noexcept;
         Self& barrier(const SBufferMemoryBarrier&) noexcept;
         Self& barrier(const SImageMemoryBarrier&) noexcept;
         Self& barrier(EPipelineStage, EPipelineStage) noexcept;
+        // Issues every barrier of the batch with a single command and clears it
+        Self& barrier(CBarrierBatch&) noexcept;
         Self& memory_barrier(const SMemoryBarrier&) noexcept;
         Self& copy_image(const CImage*, const CImage*) noexcept;
         Self& clear_image(const CImage*, CClearValue&&) noexcept;
@@ -109,16 +159,66 @@ namespace am {
         Self& set_checkpoint(const char*) noexcept;
         Self& begin_query(const CQueryPool*, uint32 = 0) noexcept;
         Self& end_query(const CQueryPool*, uint32 = 0) noexcept;
+        // GPU timestamps around the commands in between, collected by "CDevice::gpu_profiler()". Zones nest and end
+        // in the command buffer they began in, names must outlive the profiler (e.g. string literals)
+        Self& begin_zone(const char*) noexcept;
+        Self& end_zone() noexcept;
         Self& end() noexcept;
 
+        // Binds and dynamic state matching what is already bound are skipped. Anything recorded straight
+        // through "native()" must be followed by this
+        Self& invalidate_state() noexcept;
+        // Calls skipped since "begin()"
+        AM_NODISCARD uint32 elided_calls() const noexcept;
+
     private:
+        friend class CCommandAllocator;
+        friend class CRecycler;
+
+        struct SBindPointState {
+            VkPipeline pipeline = {};
+            VkPipelineLayout layout = {};
+            std::array<VkDescriptorSet, 8> sets = {};
+        };
+
+        struct SBoundState {
+            // Indexed by EPipelineType
+            std::array<SBindPointState, 3> bind_points = {};
+            SBufferInfo vertex_buffer = {};
+            SBufferInfo index_buffer = {};
+            VkViewport viewport = {};
+            VkRect2D scissor = {};
+            bool has_viewport = false;
+            bool has_scissor = false;
+            // Only the last push is remembered, 128 bytes is the minimum every device supports
+            std::array<uint8, 128> push_data = {};
+            VkPipelineLayout push_layout = {};
+            VkShaderStageFlags push_stages = 0;
+            uint32 push_size = 0;
+        };
+
         CCommandBuffer() noexcept;
 
+        // Dynamic rendering counterpart of "vkCmdBeginRenderPass", the pass transitions go through "_barriers"
+        Self& _begin_rendering(VkRenderingFlags) noexcept;
+        void _set_viewport(const VkViewport&) noexcept;
+
         VkCommandPool _pool = {};
         VkCommandBuffer _handle = {};
+        EQueueType _queue = {};
+        ECommandPoolType _pool_type = {};
+        uint32 _index = 0;
+        bool _recycled = false;
 
         const CFramebuffer* _active_framebuffer = nullptr;
+        const CRenderPass* _active_render_pass = nullptr;
         const CPipeline* _active_pipeline = nullptr;
+        // Backs the single barrier helpers
+        CBarrierBatch _barriers;
+        SBoundState _bound = {};
+        uint32 _elided_calls = 0;
+        // Open zones, their first query or "CGpuProfiler::invalid_zone"
+        std::vector<uint32> _zones;
 
         CRcPtr<CDevice> _device;
     };
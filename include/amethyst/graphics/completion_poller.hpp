@@ -0,0 +1,63 @@
+#pragma once
+
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+
+namespace am {
+    struct SCompletionStats {
+        uint64 pending = 0;
+        uint64 completed = 0;
+        float64 wait_time = 0; // Wall-clock seconds from submission to observed completion, not spent blocking a worker
+    };
+
+    // Waits on queue timeline values in place of the enki workers, continuations are then pinned back to
+    // the worker that recorded the work since its transient command pool is not externally synchronized.
+    class AM_MODULE CCompletionPoller {
+    public:
+        using Self = CCompletionPoller;
+        using Continuation = std::function<void()>;
+
+        ~CCompletionPoller() noexcept;
+
+        AM_NODISCARD static std::unique_ptr<Self> make(CDevice*) noexcept;
+
+        void enqueue(const CQueue*, uint64, uint32, Continuation&&) noexcept;
+        AM_NODISCARD SCompletionStats stats() const noexcept;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        struct SPendingWork {
+            const CQueue* queue = nullptr;
+            uint64 value = 0;
+            Continuation func;
+            uint32 thread = 0;
+            Clock::time_point start = {};
+        };
+        struct SContinuationTask;
+
+        CCompletionPoller() noexcept;
+
+        void _run(std::stop_token) noexcept;
+
+        std::vector<SPendingWork> _incoming;
+        std::vector<std::unique_ptr<SContinuationTask>> _running;
+        std::atomic<uint64> _pending = 0;
+        std::atomic<uint64> _completed = 0;
+        std::atomic<uint64> _wait_time = 0;
+        mutable std::mutex _lock;
+        std::condition_variable_any _signal;
+        std::jthread _thread;
+
+        CDevice* _device = nullptr;
+    };
+} // namespace am
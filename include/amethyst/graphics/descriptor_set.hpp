@@ -14,6 +14,7 @@
 #include <volk.h>
 
 #include <vector>
+#include <string>
 
 namespace am {
     class AM_MODULE CDescriptorSet : public IRefCounted {
@@ -29,6 +30,8 @@ namespace am {
             VkDescriptorSetLayout layout;
             uint32 index = 0;
             uint32 dynamic_count = 0;
+            // Bindings of "layout", required to bind through handles
+            std::vector<SDescriptorBinding> bindings;
         };
 
         ~CDescriptorSet() noexcept;
@@ -41,7 +44,21 @@ namespace am {
 
         AM_NODISCARD VkDescriptorSet native() const noexcept;
         AM_NODISCARD uint32 index() const noexcept;
-
+        // Resolves a binding of the set's pipeline, done once it lets every later bind skip the name lookup. Invalid for
+        // raw sets, which have no names
+        AM_NODISCARD SBindingHandle handle(const std::string&) const noexcept;
+        // Binding number in this set, for raw sets created with their bindings
+        AM_NODISCARD SBindingHandle handle(uint32) const noexcept;
+
+        Self& bind(SBindingHandle, SBufferInfo, uint32 = 0) noexcept;
+        Self& bind(SBindingHandle, const std::vector<SBufferInfo>&, uint32 = 0) noexcept;
+        Self& bind(SBindingHandle, const CImage*, uint32 = 0) noexcept;
+        Self& bind(SBindingHandle, const CImageView*, uint32 = 0) noexcept;
+        Self& bind(SBindingHandle, STextureInfo, uint32 = 0) noexcept;
+        Self& bind(SBindingHandle, const std::vector<CRcPtr<CImageView>>&, uint32 = 0) noexcept;
+        Self& bind(SBindingHandle, const std::vector<STextureInfo>&, uint32 = 0) noexcept;
+
+        // Look the name up on every call
         Self& bind(const std::string&, SBufferInfo, uint32 = 0) noexcept;
         Self& bind(const std::string&, const std::vector<SBufferInfo>&, uint32 = 0) noexcept;
         Self& bind(const std::string&, const CImage*, uint32 = 0) noexcept;
@@ -52,20 +69,60 @@ namespace am {
 
         Self& bind(const SDescriptorBinding&, STextureInfo, uint32 = 0) noexcept;
 
+        // Binds only queue their writes, a set must be flushed before it is bound. Returns how many writes reached the
+        // driver, a whole update template counting as one
+        uint32 flush() noexcept;
+        AM_NODISCARD bool has_pending_writes() const noexcept;
+
         void update_pipeline(CRcPtr<CPipeline>) noexcept;
 
     private:
-        struct SCachedDescriptors {
-            uint64 binding_hash = 0;
-            uint64 descriptor_hash = 0;
+        struct SCachedDescriptor {
+            uint64 hash = 0;
+            bool is_bound = false;
+        };
+        struct SPendingWrite {
+            uint32 binding = 0;
+            uint32 offset = 0;
+            // Into "_pending_images" or "_pending_buffers" depending on the type
+            uint32 first = 0;
+            uint32 count = 0;
+            VkDescriptorType type = {};
         };
 
         CDescriptorSet() noexcept;
 
+        void _make_slots(const std::vector<SDescriptorBinding>&, VkDescriptorUpdateTemplate) noexcept;
+        AM_NODISCARD const SDescriptorBinding* _binding(SBindingHandle) const noexcept;
+        // True if the binding already holds the descriptor, otherwise records it and the caller writes it
+        AM_NODISCARD bool _is_cached(const SDescriptorBinding&, uint64) noexcept;
+        // Templated bindings land in the template's data, everything else is queued as a write
+        void _write(const SDescriptorBinding&, uint32, const VkDescriptorBufferInfo*, uint32) noexcept;
+        void _write(const SDescriptorBinding&, uint32, const VkDescriptorImageInfo*, uint32) noexcept;
+        void _mark_dirty(uint32) noexcept;
+        void _queue(uint32, uint32, VkDescriptorType, const VkDescriptorBufferInfo*, uint32) noexcept;
+        void _queue(uint32, uint32, VkDescriptorType, const VkDescriptorImageInfo*, uint32) noexcept;
+
         VkDescriptorSet _handle = {};
         VkDescriptorPool _native_pool = {};
         uint32 _index = 0;
-        std::vector<SCachedDescriptors> _cache;
+        // Both indexed by binding number, a slot without a binding has a zero count
+        std::vector<SDescriptorBinding> _bindings;
+        std::vector<SCachedDescriptor> _cache;
+        std::vector<SPendingWrite> _pending;
+        std::vector<VkDescriptorImageInfo> _pending_images;
+        std::vector<VkDescriptorBufferInfo> _pending_buffers;
+        // Built by "flush()" from "_pending", like the vectors above it is only ever cleared so steady state flushes do
+        // not allocate
+        std::vector<VkWriteDescriptorSet> _updates;
+        struct {
+            VkDescriptorUpdateTemplate _handle = {};
+            // Template entry of every binding, indexed by binding number, "SBindingHandle::invalid" if not templated
+            std::vector<uint32> _slots;
+            std::vector<SDescriptorData> _data;
+            // Templated bindings written since the last flush
+            std::vector<uint32> _dirty;
+        } _template = {};
 
         CRcPtr<CDescriptorPool> _pool;
         CRcPtr<CPipeline> _pipeline;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <amethyst/core/mpsc_queue.hpp>
 #include <amethyst/core/rc_ptr.hpp>
 
 #include <amethyst/meta/debug_marker.hpp>
@@ -36,7 +37,9 @@
 #endif
 
 #include <unordered_map>
+#include <filesystem>
 #include <deque>
+#include <mutex>
 
 namespace am {
     enum class EDeviceExtension {
@@ -44,12 +47,19 @@ namespace am {
         Raytracing,
         ExternalMemory,
         BufferDeviceAddress,
-        FragmentShaderBarycentric
+        FragmentShaderBarycentric,
+        GraphicsPipelineLibrary
     };
 
     enum class EDeviceFeature {
         DebugNames,
-        BufferDeviceAddress
+        BufferDeviceAddress,
+        InheritedQueries,
+        Synchronization2,
+        DynamicRendering,
+        HostQueryReset,
+        GraphicsPipelineLibrary,
+        BindlessTextures
     };
 
     enum class EVirtualAllocatorKind : uint32 {
@@ -100,8 +110,22 @@ namespace am {
         using Self = CDevice;
         using DescriptorSetLayoutCache = std::unordered_map<uint64, VkDescriptorSetLayout>;
         using SamplerCache = std::unordered_map<uint64, VkSampler>;
+        struct SPipelineLibrary {
+            VkPipeline handle = {};
+            // Built for the part alone, the pipeline that first built it may be destroyed while others still link it
+            VkPipelineLayout layout = {};
+            // Second hash of the part's inputs, unrelated to the key, a hit with another check is a key collision
+            uint64 check = 0;
+            uint32 references = 0;
+        };
+        using PipelineLibraryCache = std::unordered_map<uint64, SPipelineLibrary>;
         struct SCreateInfo {
             std::vector<EDeviceExtension> extensions;
+            // See "CQueue::SCreateInfo::submission_thread"
+            bool submission_thread = false;
+            // Compiled shaders and the pipeline cache persist under this directory across runs, empty disables the
+            // on-disk caches
+            std::filesystem::path cache_directory = "cache";
         };
 
         ~CDevice() noexcept;
@@ -128,6 +152,17 @@ namespace am {
         AM_NODISCARD std::vector<SHeapBudget> heap_budgets() const noexcept;
 
         AM_NODISCARD CVirtualAllocator* virtual_allocator(EVirtualAllocatorKind) noexcept;
+        AM_NODISCARD CMPSCQueue<SReadyEvent>* ready_events() noexcept;
+        AM_NODISCARD CCompletionPoller* completion_poller() noexcept;
+        AM_NODISCARD CRecycler* recycler() noexcept;
+        AM_NODISCARD CImagePool* image_pool() noexcept;
+        AM_NODISCARD CGpuProfiler* gpu_profiler() noexcept;
+        // Null without "EDeviceFeature::BindlessTextures" or when its update-after-bind limits are too low, callers fall back
+        AM_NODISCARD CTextureHeap* texture_heap() noexcept;
+        AM_NODISCARD CShaderCache* shader_cache() noexcept;
+        // One cache per scheduler thread so pipeline creation never contends on the driver's lock, they are merged
+        // when the device saves them
+        AM_NODISCARD VkPipelineCache pipeline_cache() const noexcept;
         AM_NODISCARD uint32 memory_type_index(uint32, EMemoryProperty) noexcept;
         AM_NODISCARD const VkExportMemoryAllocateInfo* external_memory_attributes() noexcept;
 
@@ -136,11 +171,19 @@ namespace am {
         AM_NODISCARD STextureInfo sample(const CImage*, SSamplerInfo, bool = false) noexcept;
         AM_NODISCARD STextureInfo sample(const CImageView*, SSamplerInfo, bool = false) noexcept;
 
+        // Pipelines are built from worker threads, "set_cached_item" returns the item that won a concurrent insertion,
+        // the caller destroys its own if it lost
         AM_NODISCARD VkDescriptorSetLayout acquire_cached_item(const std::vector<SDescriptorBinding>&) noexcept;
-        void set_cached_item(const std::vector<SDescriptorBinding>&, VkDescriptorSetLayout) noexcept;
+        AM_NODISCARD VkDescriptorSetLayout set_cached_item(const std::vector<SDescriptorBinding>&, VkDescriptorSetLayout) noexcept;
 
         AM_NODISCARD VkSampler acquire_cached_item(const SSamplerInfo&) noexcept;
-        void set_cached_item(const SSamplerInfo&, VkSampler) noexcept;
+        AM_NODISCARD VkSampler set_cached_item(const SSamplerInfo&, VkSampler) noexcept;
+
+        // Graphics pipeline library parts, keyed by the hash of the state they were built from. Acquiring or setting a part
+        // takes a reference, it is destroyed along with its layout once every pipeline linking it released it
+        AM_NODISCARD VkPipeline acquire_pipeline_library(uint64, uint64) noexcept;
+        AM_NODISCARD VkPipeline set_pipeline_library(uint64, uint64, VkPipeline, VkPipelineLayout) noexcept;
+        void release_pipeline_library(uint64) noexcept;
 
         void cleanup_after(uint32, std::function<void(const Self*)>&&) noexcept;
         void update_cleanup() noexcept;
@@ -157,6 +200,8 @@ namespace am {
         CDevice() noexcept;
 
         AM_NODISCARD VkSampler _make_sampler(SSamplerInfo, bool) noexcept;
+        void _load_pipeline_caches(uint32) noexcept;
+        void _save_pipeline_caches() noexcept;
 
         VkDevice _handle = {};
         VkPhysicalDevice _gpu = {};
@@ -170,6 +215,7 @@ namespace am {
         VkPhysicalDeviceMemoryProperties _memory_props = {};
         struct {
             bool debug_names = false;
+            bool graphics_pipeline_library = false;
         } _features_custom;
 
         CQueue* _graphics = nullptr;
@@ -177,9 +223,20 @@ namespace am {
         CQueue* _compute = nullptr;
 
         std::vector<std::unique_ptr<CVirtualAllocator>> _virtual_allocators;
+        std::unique_ptr<CMPSCQueue<SReadyEvent>> _ready_events;
+        std::unique_ptr<CCompletionPoller> _completion_poller;
+        std::unique_ptr<CRecycler> _recycler;
+        std::unique_ptr<CImagePool> _image_pool;
+        std::unique_ptr<CGpuProfiler> _gpu_profiler;
+        std::unique_ptr<CTextureHeap> _texture_heap;
+        std::unique_ptr<CShaderCache> _shader_cache;
+        std::vector<VkPipelineCache> _pipeline_caches;
+        std::filesystem::path _pipeline_cache_path;
 
         DescriptorSetLayoutCache _set_layout_cache;
         SamplerCache _sampler_cache;
+        PipelineLibraryCache _pipeline_library_cache;
+        std::mutex _cache_lock;
 
         std::deque<SCleanupPayload> _to_delete;
 
@@ -31,9 +31,12 @@ namespace am {
         void wait_and_reset() const noexcept;
 
     private:
+        friend class CRecycler;
+
         CFence() noexcept;
 
         VkFence _handle;
+        bool _recycled = false;
 
         CRcPtr<CDevice> _device;
     };
@@ -55,6 +55,9 @@ namespace am {
         AM_NODISCARD const CRenderPass* render_pass() const noexcept;
 
         bool resize(uint32, uint32) noexcept;
+        // Points an attachment at an external image, e.g. a render graph transient, an owned one is released. Not
+        // thread-safe with command buffers being recorded against the framebuffer. Passes that aren't dynamic recreate
+        // the framebuffer whenever the image changes
         void update_attachment(uint32, const CImage*) noexcept;
 
     private:
@@ -65,6 +68,8 @@ namespace am {
 
         CFramebuffer() noexcept;
 
+        void _recreate(std::vector<CRcPtr<const CImage>>&&) noexcept;
+
         VkFramebuffer _handle = {};
         VkExtent2D _viewport = {};
         std::vector<CClearValue> _clears;
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <amethyst/graphics/queue.hpp>
+
+#include <amethyst/meta/constants.hpp>
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <vulkan/vulkan.h>
+#include <volk.h>
+
+#include <unordered_map>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <array>
+#include <deque>
+#include <mutex>
+
+namespace am {
+    struct SGpuZoneStats {
+        const char* name = nullptr;
+        EQueueType queue = {};
+        uint32 depth = 0;
+        // Zones recorded more than once per frame are summed up
+        float64 last_ms = 0;
+        float64 average_ms = 0;
+        float64 min_ms = 0;
+        float64 max_ms = 0;
+    };
+
+    struct SGpuProfilerStats {
+        uint64 frames = 0;
+        uint64 dropped_frames = 0;
+        uint64 dropped_zones = 0;
+    };
+
+    // Timestamp queries behind "CCommandBuffer::begin_zone()", every frame owns a query range of a small ring. Results
+    // are collected once the GPU made them available and never waited on, a frame whose range is still busy records no
+    // zones. "update()" closes the current frame and must not race recording.
+    class AM_MODULE CGpuProfiler {
+    public:
+        using Self = CGpuProfiler;
+        constexpr static auto invalid_zone = (uint32)-1;
+        constexpr static auto max_zones = 256u;
+        constexpr static auto ring_size = frames_in_flight + 1;
+        // Ranges still unavailable after this many "update()" calls are reported, they keep their slot until the GPU
+        // writes them, a zone recorded into a command buffer that is never submitted holds its slot for good
+        constexpr static auto max_pending_updates = 16u;
+        // Rolling window of the zone stats and frames kept for "write_chrome_trace()"
+        constexpr static auto history_frames = 64u;
+        constexpr static auto trace_frames = 32u;
+
+        ~CGpuProfiler() noexcept;
+
+        AM_NODISCARD static std::unique_ptr<Self> make(CDevice*) noexcept;
+
+        AM_NODISCARD VkQueryPool native() const noexcept;
+        // False if the device lacks host query resets or timestamps altogether
+        AM_NODISCARD bool is_supported() const noexcept;
+
+        // Returns the query of the zone's beginning, its end is the next one. Names must outlive the profiler
+        AM_NODISCARD uint32 begin_zone(EQueueType, const char*, uint32) noexcept;
+        void update() noexcept;
+
+        AM_NODISCARD std::vector<SGpuZoneStats> zones() const noexcept;
+        AM_NODISCARD SGpuProfilerStats stats() const noexcept;
+        // Writes the last "trace_frames" collected frames in the Chrome trace event format, one track per queue
+        bool write_chrome_trace(const std::filesystem::path&) const noexcept;
+
+    private:
+        struct SZone {
+            const char* name = nullptr;
+            EQueueType queue = {};
+            uint32 depth = 0;
+        };
+
+        struct SFrame {
+            std::array<SZone, max_zones> zones = {};
+            std::atomic<uint32> count = 0;
+            uint32 pending = 0;
+            bool busy = false;
+        };
+
+        struct SHistory {
+            SGpuZoneStats stats = {};
+            std::array<float64, history_frames> samples = {};
+            uint32 count = 0;
+            uint32 next = 0;
+            float64 frame_ms = 0;
+            bool touched = false;
+        };
+
+        struct STraceEvent {
+            const char* name = nullptr;
+            EQueueType queue = {};
+            float64 begin_ns = 0;
+            float64 end_ns = 0;
+        };
+
+        CGpuProfiler() noexcept;
+
+        AM_NODISCARD bool _collect(uint32) noexcept;
+
+        VkQueryPool _pool = {};
+        float64 _period = 0;
+        std::array<uint64, 3> _masks = {};
+        std::array<SFrame, ring_size> _frames;
+        std::atomic<uint32> _current = invalid_zone;
+        uint32 _slot = 0;
+        std::vector<uint64> _results;
+
+        std::vector<SHistory> _history;
+        std::unordered_map<std::string, uint32> _history_index;
+        std::deque<std::vector<STraceEvent>> _trace;
+        SGpuProfilerStats _stats = {};
+        std::atomic<uint64> _dropped_zones = 0;
+        mutable std::mutex _lock;
+
+        CDevice* _device = nullptr;
+    };
+} // namespace am
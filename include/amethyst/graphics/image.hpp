@@ -72,6 +72,8 @@ namespace am {
         AM_NODISCARD uint32 mips() const noexcept;
 
     private:
+        friend class CImagePool;
+
         CImage() noexcept;
 
         VkImage _handle = {};
@@ -89,6 +91,8 @@ namespace am {
         uint32 _width = 0;
         uint32 _height = 0;
         bool _owning = false;
+        // Set for pooled images, they return to the pool on their last drop
+        CImagePool* _pool = nullptr;
 
         CRcPtr<CDevice> _device;
     };
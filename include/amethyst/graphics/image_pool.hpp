@@ -0,0 +1,87 @@
+#pragma once
+
+#include <amethyst/core/rc_ptr.hpp>
+
+#include <amethyst/graphics/image.hpp>
+
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <vulkan/vulkan.h>
+#include <volk.h>
+
+#include <vk_mem_alloc.h>
+
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <mutex>
+
+namespace am {
+    struct SImagePoolStats {
+        uint64 hits = 0;
+        uint64 allocations = 0;
+        uint32 live_images = 0;
+        uint32 idle_blocks = 0;
+        uint64 allocated_bytes = 0;
+    };
+
+    // Render targets whose memory is pooled by size bucket. Images keep their exact size, the memory behind them is
+    // sized for the bucket, so any size rounding to the same bucket reuses a released allocation instead of a new one.
+    class AM_MODULE CImagePool {
+    public:
+        using Self = CImagePool;
+        constexpr static auto bucket_granularity = 256u;
+        // Idle blocks are freed after this many "update()" calls
+        constexpr static auto max_idle_frames = 120u;
+
+        ~CImagePool() noexcept;
+
+        AM_NODISCARD static std::unique_ptr<Self> make(CDevice*) noexcept;
+
+        // The initial layout is always "Undefined", contents of a reused block are garbage. The pool never holds the image,
+        // its block returns once every frame in flight is done with the last reference
+        AM_NODISCARD CRcPtr<CImage> acquire(const CImage::SCreateInfo&) noexcept;
+        void update() noexcept;
+
+        AM_NODISCARD SImagePoolStats stats() const noexcept;
+
+    private:
+        struct SBlock {
+            VmaAllocation allocation = {};
+            VkMemoryRequirements requirements = {};
+            uint32 memory_type = 0;
+            uint64 bucket = 0;
+            uint64 idle_since = 0;
+        };
+        struct SRetiredImage {
+            VkImage handle = {};
+            VkImageView view = {};
+            uint64 frame = 0;
+        };
+
+        friend class CImage;
+
+        CImagePool() noexcept;
+
+        AM_NODISCARD SBlock _allocate(const VkImageCreateInfo&, const VkMemoryRequirements&, uint64) noexcept;
+        // Called from the last drop of a pooled image, it is destroyed after the frames in flight
+        void _retire(VkImage, VkImageView) noexcept;
+        // Destroys the image, its block becomes idle
+        void _recycle(const SRetiredImage&) noexcept;
+        void _free(SBlock&) noexcept;
+
+        // Idle blocks per bucket, live blocks per image handle
+        std::unordered_map<uint64, std::vector<SBlock>> _idle;
+        std::unordered_map<VkImage, SBlock> _live;
+        std::vector<SRetiredImage> _retired;
+        mutable std::mutex _lock;
+        uint64 _frame = 0;
+        uint64 _hits = 0;
+        uint64 _allocations = 0;
+        uint64 _allocated_bytes = 0;
+
+        CDevice* _device = nullptr;
+    };
+} // namespace am
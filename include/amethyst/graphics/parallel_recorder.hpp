@@ -0,0 +1,63 @@
+#pragma once
+
+#include <amethyst/core/rc_ptr.hpp>
+
+#include <amethyst/graphics/command_allocator.hpp>
+#include <amethyst/graphics/command_buffer.hpp>
+#include <amethyst/graphics/device.hpp>
+
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/enums.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace am {
+    struct SRecordRangeInfo {
+        const CFramebuffer* framebuffer = nullptr;
+        const CRenderPass* render_pass = nullptr;
+        uint32 count = 0;
+        uint32 batch = 64; // Smallest range handed to a single worker
+        // Of the pipeline statistics query active while the job's secondaries are executed, if any
+        EQueryPipelineStatistics statistics = {};
+    };
+
+    // Records command buffers on the enki workers. A pass becomes one primary buffer, a range of draws inside
+    // a render pass is split into secondary buffers. "wait()" yields the buffers in submission/execution order.
+    class AM_MODULE CParallelRecorder : public IRefCounted {
+    public:
+        using Self = CParallelRecorder;
+        using PassFunc = std::function<void(CCommandBuffer&)>;
+        using RangeFunc = std::function<void(CCommandBuffer&, uint32, uint32)>;
+
+        ~CParallelRecorder() noexcept;
+
+        AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>, CRcPtr<CCommandAllocator>) noexcept;
+
+        // Every job of the previous frame must have been waited on
+        void reset() noexcept;
+
+        // "begin()" and "end()" are issued by the recorder
+        AM_NODISCARD uint32 record(PassFunc&&) noexcept;
+        AM_NODISCARD uint32 record(SRecordRangeInfo&&, RangeFunc&&) noexcept;
+
+        // The calling thread helps recording until the job is done
+        AM_NODISCARD const std::vector<CCommandBuffer*>& wait(uint32) noexcept;
+
+    private:
+        struct SJob;
+
+        CParallelRecorder() noexcept;
+
+        AM_NODISCARD SJob& _next_job() noexcept;
+
+        std::vector<std::unique_ptr<SJob>> _jobs;
+        uint32 _used = 0;
+
+        CRcPtr<CCommandAllocator> _allocator;
+        CRcPtr<CDevice> _device;
+    };
+} // namespace am
@@ -12,7 +12,12 @@
 #include <vulkan/vulkan.h>
 #include <volk.h>
 
+#include <unordered_map>
 #include <filesystem>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <mutex>
 #include <map>
 
 namespace am {
@@ -36,6 +41,8 @@ namespace am {
 
     struct SDescriptorBinding {
         bool dynamic = false;
+        // Set the binding was reflected from, not part of the layout so it takes no part in comparisons
+        uint32 set = 0;
         uint32 index = 0;
         uint32 count = 0;
         VkDescriptorType type = {};
@@ -48,12 +55,63 @@ namespace am {
                    type == rhs.type &&
                    stage == rhs.stage;
         }
+
+        // Single image or buffer descriptors are written through their set's update template
+        AM_NODISCARD constexpr bool is_templated() const noexcept {
+            AM_UNLIKELY_IF(dynamic || count != 1) {
+                return false;
+            }
+            switch (type) {
+                case VK_DESCRIPTOR_TYPE_SAMPLER:
+                case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+                case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+                    return true;
+                default: break;
+            }
+            return false;
+        }
+    };
+
+    // One update template entry, every entry has the same stride whatever its kind
+    union SDescriptorData {
+        VkDescriptorImageInfo image;
+        VkDescriptorBufferInfo buffer;
+    };
+
+    // A binding resolved once by name, its set and number in the set. Binds through a handle index the set's slots
+    // directly and stay valid across reloads as long as the shader keeps the binding number
+    struct SBindingHandle {
+        constexpr static auto invalid = (uint32)-1;
+        uint32 set = invalid;
+        uint32 index = invalid;
+
+        AM_NODISCARD constexpr bool is_valid() const noexcept {
+            return set != invalid && index != invalid;
+        }
     };
 
     struct SDescriptorSetLayout {
         VkDescriptorSetLayout handle = {};
         uint32 binds = 0;
         bool dynamic = false;
+        // Covers the templated bindings in declaration order, null if the set has none
+        VkDescriptorUpdateTemplate update_template = {};
+    };
+
+    // Specialization constants are passed as 32-bit words, GLSL bools included. Floats go through "std::bit_cast"
+    struct SSpecializationConstant {
+        uint32 id = 0;
+        uint32 value = 0;
+
+        AM_NODISCARD constexpr bool operator ==(const SSpecializationConstant& rhs) const noexcept {
+            return id == rhs.id && value == rhs.value;
+        }
     };
 
     class AM_MODULE CPipeline : public IRefCounted {
@@ -71,34 +129,81 @@ namespace am {
             bool depth_write = false;
             uint32 subpass = 0;
             const CFramebuffer* framebuffer = nullptr;
+            std::vector<SSpecializationConstant> constants;
         };
         struct SComputeCreateInfo {
             std::filesystem::path compute;
+            std::vector<SSpecializationConstant> constants;
         };
 
         ~CPipeline() noexcept;
 
+        // Null if any requested stage fails to compile. With "EDeviceFeature::GraphicsPipelineLibrary" graphics pipelines
+        // are fast-linked from cached parts and relinked with link-time optimization in the background
         AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>, SGraphicsCreateInfo&&) noexcept;
         AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>, SComputeCreateInfo&&) noexcept;
 
+        // The optimized pipeline once its background link finished, the fast-linked one until then
         AM_NODISCARD VkPipeline native() const noexcept;
         AM_NODISCARD EPipelineType type() const noexcept;
         AM_NODISCARD VkPipelineLayout main_layout() const noexcept;
         AM_NODISCARD SDescriptorSetLayout set_layout(uint32) const noexcept;
         AM_NODISCARD const SDescriptorBinding* bindings(const std::string&) const noexcept;
+        // Invalid if the pipeline has no such binding
+        AM_NODISCARD SBindingHandle binding_handle(const std::string&) const noexcept;
+        // Every binding of a set, in declaration order
+        AM_NODISCARD const std::vector<SDescriptorBinding>& set_bindings(uint32) const noexcept;
+        // Reflected from the shaders, the value is the default the shader declares
+        AM_NODISCARD const SSpecializationConstant* constant(const std::string&) const noexcept;
+
+        // Same pipeline built with the given constants in place of the create info's ones, sharing its shader modules and
+        // layout. The first request schedules the build on a worker and returns the pipeline itself until it is done, so
+        // the caller never compiles. Safe to call from any thread
+        AM_NODISCARD CRcPtr<Self> variant(std::vector<SSpecializationConstant>) noexcept;
+        // Builds the variant on the calling thread if it is not cached, for workers and load time prewarming
+        AM_NODISCARD CRcPtr<Self> build_variant(std::vector<SSpecializationConstant>) noexcept;
+        // Constants of every variant built so far, used to prewarm a reloaded pipeline
+        AM_NODISCARD std::vector<std::vector<SSpecializationConstant>> variants() const noexcept;
 
     private:
         CPipeline() noexcept;
 
+        struct SShared;
+        struct SVariant {
+            std::vector<SSpecializationConstant> constants;
+            // Null while its build is pending
+            CRcPtr<Self> handle;
+            std::unique_ptr<enki::TaskSet> task;
+        };
+
+        AM_NODISCARD static SVariant* _find_variant(std::vector<SVariant>&, const std::vector<SSpecializationConstant>&) noexcept;
+        // Creates the pipeline object from the shared modules and layout, the create info's constants specialize it
+        void _create_graphics() noexcept;
+        void _create_compute() noexcept;
+        AM_NODISCARD CRcPtr<Self> _make_variant(const std::vector<SSpecializationConstant>&) noexcept;
+
         VkPipeline _handle = {};
+        std::atomic<VkPipeline> _optimized = {};
+        std::unique_ptr<enki::TaskSet> _link_task;
+        // Keys of the library parts the pipeline was linked from, released on destruction
+        std::vector<uint64> _libraries;
         struct {
             VkPipelineLayout _pipeline = {};
             std::vector<SDescriptorSetLayout> _set;
+            std::vector<std::vector<SDescriptorBinding>> _bindings;
         } _layout = {};
 
         std::map<std::string, SDescriptorBinding> _bindings;
+        std::map<std::string, SSpecializationConstant> _constants;
+        SGraphicsCreateInfo _graphics_info;
+        SComputeCreateInfo _compute_info;
         EPipelineType _type = {};
 
+        CRcPtr<SShared> _shared;
+        // Keyed by the constants' hash, colliding constants share a bucket
+        std::unordered_map<uint64, std::vector<SVariant>> _variants;
+        mutable std::mutex _variant_lock;
+
         CRcPtr<CDevice> _device;
     };
 } // namespace am
@@ -28,6 +28,7 @@ namespace am {
 
         AM_NODISCARD VkQueryPool native() const noexcept;
         AM_NODISCARD uint64 count() const noexcept;
+        AM_NODISCARD EQueryPipelineStatistics statistics() const noexcept;
 
         AM_NODISCARD std::vector<uint64> results() const noexcept;
 
@@ -36,6 +37,7 @@ namespace am {
 
         VkQueryPool _handle = {};
         uint64 _count = 0;
+        EQueryPipelineStatistics _statistics = {};
 
         CRcPtr<CDevice> _device;
     };
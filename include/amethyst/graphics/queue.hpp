@@ -1,5 +1,7 @@
 #pragma once
 
+#include <amethyst/core/rc_ptr.hpp>
+
 #include <amethyst/graphics/semaphore.hpp>
 #include <amethyst/graphics/fence.hpp>
 
@@ -21,8 +23,16 @@
 #include <vulkan/vulkan.h>
 #include <volk.h>
 
+#include <condition_variable>
+#include <initializer_list>
+#include <functional>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <array>
 #include <mutex>
+#include <span>
 
 namespace am {
     struct SQueueFamily {
@@ -35,8 +45,21 @@ namespace am {
         CCommandBuffer* command = nullptr;
         CSemaphore* wait = nullptr;
         CSemaphore* signal = nullptr;
+        uint64 wait_value = 0; // Ignored for binary semaphores
+        uint64 signal_value = 0;
+        // Waits on another queue's timeline, e.g. graphics consuming the results of async compute
+        const CQueue* wait_queue = nullptr;
+        uint64 wait_queue_value = 0;
+        // Entries sharing a batch become one VkSubmitInfo2, batches must not decrease
+        uint32 batch = 0;
     };
 
+    // Upper bounds of a single "submit()" call, submissions are built on the stack
+    constexpr auto max_submit_infos = 16u;
+    constexpr auto max_submit_batches = 4u;
+    // Queued submissions a worker keeps alive until they retire, a full ring waits on its oldest one
+    constexpr auto max_in_flight_submits = 32u;
+
     struct SQueuePresentInfo {
         uint32 image = 0;
         CSwapchain* swapchain = nullptr;
@@ -62,6 +85,9 @@ namespace am {
             VkQueue handle = {};
             SQueueFamily family = {};
             EQueueType type = {};
+            uint32 threads = 0;
+            // Submissions are handed to a dedicated thread, callers never block on the queue lock
+            bool submission_thread = false;
         };
 
         ~CQueue() noexcept;
@@ -70,15 +96,31 @@ namespace am {
 
         AM_NODISCARD VkQueue native() const noexcept;
         AM_NODISCARD uint32 family() const noexcept;
+        AM_NODISCARD uint32 threads() const noexcept;
         AM_NODISCARD VkCommandPool main_pool() const noexcept;
         AM_NODISCARD VkCommandPool transient_pool(uint32) const noexcept;
 
         void lock_pool(uint32) const noexcept;
         void unlock_pool(uint32) const noexcept;
 
+        // Every batch advances the queue's timeline, "submit()" returns the value the last batch will signal.
+        // Earlier batches signal the values right before it
+        AM_NODISCARD VkSemaphore timeline() const noexcept;
+        AM_NODISCARD uint64 submitted() const noexcept;
+        AM_NODISCARD uint64 completed() const noexcept;
+        AM_NODISCARD bool is_complete(uint64) const noexcept;
+        void wait(uint64) const noexcept;
+
         void wait_idle() noexcept;
-        void submit(std::vector<SQueueSubmitInfo>&&, CFence*) noexcept;
+        uint64 submit(std::initializer_list<SQueueSubmitInfo>, CFence* = nullptr) noexcept;
+        uint64 submit(std::span<const SQueueSubmitInfo>, CFence* = nullptr) noexcept;
         void immediate_submit(std::function<void(CCommandBuffer&)>&&) noexcept;
+        // Acquire half of an ownership transfer the source queue released in the submission signaling the given value.
+        // Acquires whose release retired are recorded as one barrier batch at the start of the next "submit()"
+        void acquire(const CQueue&, uint64, const SBufferMemoryBarrier&) noexcept;
+        void acquire(const CQueue&, uint64, const SImageMemoryBarrier&) noexcept;
+        AM_NODISCARD uint32 pending_acquires() const noexcept;
+        // Pending submissions are flushed first, the swapchain is not handed to the submission thread
         void present(SQueuePresentInfo&&) noexcept;
 
     private:
@@ -87,15 +129,64 @@ namespace am {
             std::mutex _lock;
         };
 
+        struct SPendingSubmit {
+            std::array<SQueueSubmitInfo, max_submit_infos> info = {};
+            uint32 count = 0;
+            CFence* fence = nullptr;
+            uint64 value = 0;
+        };
+
+        // The submission thread may issue after the caller dropped its references, queued submissions hold their own
+        // until they retire
+        struct SInFlightSubmit {
+            std::array<CRcPtr<CCommandBuffer>, max_submit_infos> commands;
+            std::array<CRcPtr<CSemaphore>, max_submit_infos * 2> semaphores;
+            CRcPtr<CFence> fence;
+            uint64 value = 0;
+        };
+
+        // One per scheduler thread, only its own thread pushes and releases since it owns the command pool
+        struct SInFlightRing {
+            std::array<SInFlightSubmit, max_in_flight_submits> entries;
+            uint32 head = 0;
+            uint32 count = 0;
+        };
+
+        struct SAcquireState;
+
         CQueue() noexcept;
 
+        // Returns the submission with retired acquires prepended, "commands" keeps their command buffer alive
+        AM_NODISCARD std::span<const SQueueSubmitInfo> _prepend_acquires(
+            std::span<const SQueueSubmitInfo>,
+            CRcPtr<CCommandBuffer>&,
+            uint32) noexcept;
+        void _submit(std::span<const SQueueSubmitInfo>, CFence*, uint64) noexcept;
+        // Releases the thread's retired submissions, then holds references to the new one
+        void _track_in_flight(std::span<const SQueueSubmitInfo>, CFence*, uint64, uint32) noexcept;
+        void _flush_submissions() noexcept;
+        void _run(std::stop_token) noexcept;
+
         VkQueue _handle = {};
+        VkSemaphore _timeline = {};
+        std::atomic<uint64> _submitted = 0;
         VkCommandPool _pool = {};
         std::vector<std::unique_ptr<SThreadSafePool>> _transient;
         SQueueFamily _family = {};
         EQueueType _type = {};
         std::mutex _lock;
 
+        std::vector<SPendingSubmit> _incoming;
+        std::vector<std::unique_ptr<SInFlightRing>> _in_flight;
+        uint64 _flushed = 0;
+        std::mutex _pending_lock;
+        std::condition_variable_any _pending_signal;
+        std::condition_variable _flushed_signal;
+        std::jthread _thread;
+
+        std::unique_ptr<SAcquireState> _acquires;
+        std::atomic<uint32> _pending_acquires = 0;
+
         CDevice* _device = nullptr;
         std::shared_ptr<spdlog::logger> _logger;
     };
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <amethyst/core/mpsc_queue.hpp>
+#include <amethyst/core/rc_ptr.hpp>
+
+#include <amethyst/graphics/queue.hpp>
+
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <vulkan/vulkan.h>
+#include <volk.h>
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <array>
+
+namespace am {
+    struct SRecyclerCounters {
+        uint64 hits = 0;
+        uint64 creations = 0;
+    };
+
+    struct SRecyclerStats {
+        SRecyclerCounters fences = {};
+        SRecyclerCounters semaphores = {};
+        SRecyclerCounters commands = {};
+    };
+
+    // Keeps retired fences, binary semaphores and transient command buffers around for reuse. Handles are cached
+    // per enki thread so acquisition takes no lock, handles released from a foreign thread go through an inbox.
+    class AM_MODULE CRecycler {
+    public:
+        using Self = CRecycler;
+
+        ~CRecycler() noexcept;
+
+        AM_NODISCARD static std::unique_ptr<Self> make(CDevice*, uint32) noexcept;
+
+        // Fences are handed out unsignaled
+        AM_NODISCARD CRcPtr<CFence> acquire_fence() noexcept;
+        // Binary only, the previous user must have had its wait retired
+        AM_NODISCARD CRcPtr<CSemaphore> acquire_semaphore() noexcept;
+        // Allocated from the transient pool of the given thread and queue
+        AM_NODISCARD CRcPtr<CCommandBuffer> acquire_command_buffer(EQueueType, uint32) noexcept;
+
+        void recycle_fence(VkFence) noexcept;
+        void recycle_semaphore(VkSemaphore) noexcept;
+        void recycle_command_buffer(EQueueType, uint32, VkCommandBuffer) noexcept;
+
+        AM_NODISCARD SRecyclerStats stats() const noexcept;
+
+    private:
+        constexpr static auto queue_types = 3;
+        struct SCounters {
+            std::atomic<uint64> hits = 0;
+            std::atomic<uint64> creations = 0;
+        };
+        struct alignas(64) SThreadCache {
+            std::vector<VkFence> fences;
+            std::vector<VkSemaphore> semaphores;
+            std::array<std::vector<VkCommandBuffer>, queue_types> commands;
+            CMPSCQueue<VkFence> fence_inbox;
+            CMPSCQueue<VkSemaphore> semaphore_inbox;
+            std::array<CMPSCQueue<VkCommandBuffer>, queue_types> command_inbox;
+            SCounters fence_counters;
+            SCounters semaphore_counters;
+            SCounters command_counters;
+        };
+
+        CRecycler() noexcept;
+
+        AM_NODISCARD uint32 _current_thread() const noexcept;
+        AM_NODISCARD CQueue* _queue(EQueueType) const noexcept;
+
+        std::vector<std::unique_ptr<SThreadCache>> _caches;
+
+        CDevice* _device = nullptr;
+    };
+} // namespace am
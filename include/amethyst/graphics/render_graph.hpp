@@ -0,0 +1,194 @@
+#pragma once
+
+#include <amethyst/core/rc_ptr.hpp>
+
+#include <amethyst/graphics/command_buffer.hpp>
+#include <amethyst/graphics/typed_buffer.hpp>
+#include <amethyst/graphics/device.hpp>
+#include <amethyst/graphics/image.hpp>
+
+#include <amethyst/meta/constants.hpp>
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/enums.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <vulkan/vulkan.h>
+#include <volk.h>
+
+#include <vk_mem_alloc.h>
+
+#include <functional>
+#include <vector>
+
+namespace am {
+    struct SRenderGraphImageInfo {
+        const CImage* image = nullptr;
+        // State before the first pass, "None" means nothing has to be waited on
+        EPipelineStage stage = EPipelineStage::None;
+        EResourceAccess access = EResourceAccess::None;
+        EImageLayout layout = EImageLayout::Undefined;
+        // State after the last pass, an "Undefined" layout keeps whatever the last pass left
+        EPipelineStage final_stage = EPipelineStage::None;
+        EResourceAccess final_access = EResourceAccess::None;
+        EImageLayout final_layout = EImageLayout::Undefined;
+    };
+
+    struct SRenderGraphBufferInfo {
+        SBufferInfo buffer = {};
+        EPipelineStage stage = EPipelineStage::None;
+        EResourceAccess access = EResourceAccess::None;
+        EPipelineStage final_stage = EPipelineStage::None;
+        EResourceAccess final_access = EResourceAccess::None;
+    };
+
+    struct STransientImageInfo {
+        EImageSampleCount samples = EImageSampleCount::s1;
+        EImageUsage usage = {};
+        EResourceFormat format = {};
+        uint32 layers = 1;
+        uint32 mips = 1;
+        uint32 width = 0;
+        uint32 height = 0;
+    };
+
+    struct SRenderGraphAccess {
+        uint32 resource = 0;
+        EPipelineStage stage = {};
+        EResourceAccess access = {};
+        // "Undefined" leaves the layout to the pass (e.g. a render pass with its own transitions)
+        EImageLayout layout = EImageLayout::Undefined;
+        // Layout the pass leaves the image in, e.g. the final layout of its render pass
+        EImageLayout final_layout = EImageLayout::Undefined;
+    };
+
+    struct SRenderGraphPassInfo {
+        const char* name = nullptr;
+        std::vector<SRenderGraphAccess> reads;
+        std::vector<SRenderGraphAccess> writes;
+        // Never culled, even if nothing reads its results
+        bool side_effects = false;
+    };
+
+    struct SRenderGraphStats {
+        uint32 passes = 0;
+        uint32 culled = 0;
+        uint32 barriers = 0;
+        uint32 batches = 0;
+        uint32 transient_images = 0;
+        uint64 transient_bytes = 0;
+        uint64 allocated_bytes = 0;
+    };
+
+    // Passes declare what they read and write, the graph culls passes whose results are never observed and records
+    // the remaining ones with one batched barrier each. Transient images whose lifetimes don't overlap share memory.
+    // Transient memory is reused by the next frame recorded with the same graph, so keep one graph per frame in flight.
+    class AM_MODULE CRenderGraph : public IRefCounted {
+    public:
+        using Self = CRenderGraph;
+        using PassFunc = std::function<void(CCommandBuffer&, const CRenderGraph&)>;
+
+        ~CRenderGraph() noexcept;
+
+        AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>) noexcept;
+
+        // Imported resources outlive the graph, passes writing them are never culled. Imports no live pass uses are
+        // left alone, so several graphs may import the same resources (e.g. one graph per queue)
+        AM_NODISCARD uint32 import_image(SRenderGraphImageInfo&&) noexcept;
+        AM_NODISCARD uint32 import_buffer(SRenderGraphBufferInfo&&) noexcept;
+        AM_NODISCARD uint32 create_image(STransientImageInfo&&) noexcept;
+        void add_pass(SRenderGraphPassInfo&&, PassFunc&&) noexcept;
+
+        // Transient images are only available after "compile()"
+        AM_NODISCARD const CImage* image(uint32) const noexcept;
+        AM_NODISCARD const SBufferInfo& buffer(uint32) const noexcept;
+        AM_NODISCARD const SRenderGraphStats& stats() const noexcept;
+
+        // Transient images are only recreated if their descriptions or lifetimes changed since the last frame
+        void compile() noexcept;
+        void execute(CCommandBuffer&) noexcept;
+        // Forgets every resource and pass, transient memory is kept around
+        void reset() noexcept;
+
+    private:
+        struct SResource {
+            bool is_image = false;
+            bool is_transient = false;
+            const CImage* image = nullptr;
+            SBufferInfo buffer = {};
+            uint32 transient = 0;
+            SRenderGraphImageInfo state = {};
+        };
+
+        struct SPass {
+            SRenderGraphPassInfo info;
+            PassFunc func;
+            bool live = false;
+        };
+
+        struct STransient {
+            STransientImageInfo info = {};
+            uint32 resource = 0;
+            uint32 first = 0;
+            uint32 last = 0;
+            uint32 image = 0;
+        };
+
+        struct SAliasedImage {
+            VkImage handle = {};
+            CRcPtr<CImage> image;
+            uint32 slot = 0;
+        };
+
+        struct SMemorySlot {
+            VmaAllocation allocation = {};
+            VkMemoryRequirements requirements = {};
+            uint32 last = 0;
+            EPipelineStage stage = {};
+            EResourceAccess access = {};
+        };
+
+        struct SResourceState {
+            EPipelineStage write_stage = {};
+            EResourceAccess write_access = {};
+            EPipelineStage read_stage = {};
+            EPipelineStage visible_stage = {};
+            EResourceAccess visible_access = {};
+            EImageLayout layout = {};
+            bool touched = false;
+            bool used = false;
+        };
+
+        struct SPassUse {
+            SRenderGraphAccess access = {};
+            bool write = false;
+        };
+
+        CRenderGraph() noexcept;
+
+        void _allocate_transients() noexcept;
+        // Frames in flight may still use the old aliases, they are destroyed once those retire
+        void _retire_transients() noexcept;
+        void _destroy_transients() noexcept;
+        void _sync(const SResource&, SResourceState&, const SPassUse&) noexcept;
+        void _flush(CCommandBuffer&) noexcept;
+
+        std::vector<SResource> _resources;
+        std::vector<STransient> _transients;
+        std::vector<SPass> _passes;
+
+        std::vector<uint32> _signature;
+        std::vector<SAliasedImage> _images;
+        std::vector<SMemorySlot> _slots;
+        uint64 _transient_bytes = 0;
+        uint64 _allocated_bytes = 0;
+
+        std::vector<SResourceState> _states;
+        std::vector<SPassUse> _uses;
+        std::vector<bool> _needed;
+        CBarrierBatch _barriers;
+        SRenderGraphStats _stats = {};
+
+        CRcPtr<CDevice> _device;
+    };
+} // namespace am
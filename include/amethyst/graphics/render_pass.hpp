@@ -45,6 +45,18 @@ namespace am {
         EResourceAccess dest_access = {};
     };
 
+    // What "vkCmdBeginRendering" needs from an attachment of the subpass
+    struct SRenderingAttachment {
+        uint32 index = 0;
+        VkFormat format = {};
+        VkImageAspectFlags aspect = {};
+        EImageLayout layout = {};
+        VkAttachmentLoadOp load = {};
+        VkAttachmentStoreOp store = {};
+        VkAttachmentLoadOp stencil_load = {};
+        VkAttachmentStoreOp stencil_store = {};
+    };
+
     class AM_MODULE CRenderPass : public IRefCounted {
     public:
         using Self = CRenderPass;
@@ -52,6 +64,9 @@ namespace am {
             std::vector<SAttachmentDescription> attachments;
             std::vector<SSubpassDescription> subpasses;
             std::vector<SDependencyDescriptions> dependencies;
+            // Single subpass passes without input attachments skip the VkRenderPass when the device supports
+            // dynamic rendering, the external dependencies become barriers around "vkCmdBeginRendering"
+            bool dynamic_rendering = false;
         };
 
         ~CRenderPass() noexcept;
@@ -62,11 +77,20 @@ namespace am {
 
         AM_NODISCARD const SAttachmentDescription& attachment(uint32) const noexcept;
 
+        AM_NODISCARD bool is_dynamic() const noexcept;
+        AM_NODISCARD const std::vector<SRenderingAttachment>& rendering_attachments() const noexcept;
+        AM_NODISCARD const SDependencyDescriptions& begin_dependency() const noexcept;
+        AM_NODISCARD const SDependencyDescriptions& end_dependency() const noexcept;
+
     private:
         CRenderPass() noexcept;
 
         VkRenderPass _handle = {};
         std::vector<SAttachmentDescription> _attachments;
+        std::vector<SRenderingAttachment> _rendering;
+        SDependencyDescriptions _begin_dependency = {};
+        SDependencyDescriptions _end_dependency = {};
+        bool _is_dynamic = false;
 
         CRcPtr<CDevice> _device;
     };
@@ -17,21 +17,35 @@ namespace am {
     class AM_MODULE CSemaphore : public IRefCounted {
     public:
         using Self = CSemaphore;
+        struct SCreateInfo {
+            bool timeline = false;
+            uint64 initial = 0;
+        };
 
         ~CSemaphore() noexcept;
 
         AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>) noexcept;
+        AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>, SCreateInfo&&) noexcept;
         AM_NODISCARD static std::vector<CRcPtr<Self>> make(const CRcPtr<CDevice>&, uint32) noexcept;
+        AM_NODISCARD static std::vector<CRcPtr<Self>> make(const CRcPtr<CDevice>&, uint32, SCreateInfo&&) noexcept;
 
         AM_NODISCARD VkSemaphore native() const noexcept;
+        AM_NODISCARD bool is_timeline() const noexcept;
 
-        void wait() const noexcept;
-        void signal() const noexcept;
+        // Timeline semaphores only
+        AM_NODISCARD uint64 value() const noexcept;
+        AM_NODISCARD bool is_ready(uint64) const noexcept;
+        void wait(uint64) const noexcept;
+        void signal(uint64) const noexcept;
 
     private:
+        friend class CRecycler;
+
         CSemaphore() noexcept;
 
         VkSemaphore _handle;
+        bool _timeline = false;
+        bool _recycled = false;
 
         CRcPtr<CDevice> _device;
     };
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <amethyst/graphics/shader_reflection.hpp>
+
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/enums.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <unordered_map>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+
+namespace am {
+    struct SShaderCacheStats {
+        uint64 hits = 0;
+        uint64 misses = 0;
+        // Compilation time the hits would have cost, minus the time spent loading them
+        float64 saved_ms = 0;
+        float64 compile_ms = 0;
+    };
+
+    // GLSL to SPIR-V compilation backed by an on-disk cache. Entries are keyed by the source, every include resolved
+    // while preprocessing it, the shader stage and the compile options, so only shaders whose inputs changed are
+    // compiled again. An empty directory disables the disk and compiles every time.
+    //
+    // Runtime compilation only exists with "AM_RUNTIME_SHADERS", otherwise "load()" reads the "<shader>.spv" and
+    // "<shader>.refl" pair the "amethyst_shaders" target generates and nothing is compiled nor cached.
+    class AM_MODULE CShaderCache {
+    public:
+        using Self = CShaderCache;
+        // Bumped whenever the entry layout or the compile options change
+        constexpr static auto format_version = 1u;
+
+        ~CShaderCache() noexcept;
+
+        AM_NODISCARD static std::unique_ptr<Self> make(CDevice*, std::filesystem::path) noexcept;
+
+        // Returns an empty binary if the shader cannot be loaded or compiled, safe to call from any thread
+        AM_NODISCARD SShaderBinary load(const std::filesystem::path&, EShaderStage) noexcept;
+#if defined(AM_RUNTIME_SHADERS)
+        AM_NODISCARD std::vector<uint32> compile(const std::filesystem::path&, EShaderStage) noexcept;
+#endif
+
+        AM_NODISCARD const std::filesystem::path& directory() const noexcept;
+        // Canonical paths of every file the last compilation of a shader included, nested includes too
+        AM_NODISCARD std::vector<std::filesystem::path> dependencies(const std::filesystem::path&) const noexcept;
+        AM_NODISCARD SShaderCacheStats stats() const noexcept;
+
+    private:
+        CShaderCache() noexcept;
+
+#if defined(AM_RUNTIME_SHADERS)
+        AM_NODISCARD bool _load(uint64, std::vector<uint32>&, float64&) const noexcept;
+        void _store(uint64, const std::vector<uint32>&, float64) noexcept;
+#endif
+        void _record(const std::filesystem::path&, std::vector<std::filesystem::path>&&) noexcept;
+
+        std::filesystem::path _directory;
+        std::unordered_map<std::string, std::vector<std::filesystem::path>> _dependencies;
+        // Random per cache, processes sharing the directory never pick the same temporary file
+        uint64 _instance = 0;
+        std::atomic<uint64> _temporaries = 0;
+        SShaderCacheStats _stats = {};
+        mutable std::mutex _lock;
+
+        CDevice* _device = nullptr;
+    };
+} // namespace am
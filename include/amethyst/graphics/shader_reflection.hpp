@@ -0,0 +1,52 @@
+#pragma once
+
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <filesystem>
+#include <vector>
+#include <string>
+
+namespace am {
+    struct SShaderResource {
+        std::string name;
+        uint32 set = 0;
+        uint32 binding = 0;
+        // Declared array size, 0 for runtime sized arrays
+        uint32 count = 1;
+        VkDescriptorType type = {};
+    };
+
+    struct SShaderConstant {
+        std::string name;
+        uint32 id = 0;
+        uint32 value = 0;
+    };
+
+    // Everything "CPipeline" needs from a SPIR-V module to build its layouts. Reflected at runtime when GLSL is compiled
+    // at runtime, otherwise generated next to the binary at build time and loaded as is.
+    struct SShaderReflection {
+        using Self = SShaderReflection;
+        // Bumped whenever the serialized layout changes
+        constexpr static auto format_version = 1u;
+
+        std::vector<SShaderResource> resources;
+        std::vector<SShaderConstant> constants;
+        // Component count of every stage output, fragment shaders derive their attachments from them
+        std::vector<uint32> outputs;
+        std::string push_constant;
+        uint32 push_constant_size = 0;
+
+        AM_NODISCARD static Self make(const std::vector<uint32>&) noexcept;
+        // False if the file is missing, truncated or of another format version
+        AM_NODISCARD static bool load(const std::filesystem::path&, Self&) noexcept;
+        AM_NODISCARD bool save(const std::filesystem::path&) const noexcept;
+    };
+
+    struct SShaderBinary {
+        std::vector<uint32> code;
+        SShaderReflection reflection;
+    };
+} // namespace am
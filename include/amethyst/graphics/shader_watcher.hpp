@@ -0,0 +1,48 @@
+#pragma once
+
+#include <amethyst/core/rc_ptr.hpp>
+
+#include <amethyst/graphics/async_pipeline.hpp>
+#include <amethyst/graphics/device.hpp>
+
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <unordered_map>
+#include <filesystem>
+#include <vector>
+
+namespace am {
+    // Watches a shader directory tree and reloads the pipelines built from a changed file, includes resolved through
+    // the device's "CShaderCache" count as well, so does a rebuilt prebuilt shader. Backed by inotify, other platforms
+    // never report changes.
+    class AM_MODULE CShaderWatcher : public IRefCounted {
+    public:
+        using Self = CShaderWatcher;
+
+        ~CShaderWatcher() noexcept;
+
+        AM_NODISCARD static CRcPtr<Self> make(CRcPtr<CDevice>, const std::filesystem::path&) noexcept;
+
+        AM_NODISCARD bool is_supported() const noexcept;
+
+        void watch(CRcPtr<CAsyncPipeline>) noexcept;
+        // Drains the pending changes and calls "CAsyncPipeline::reload()" on every affected pipeline, returns how
+        // many. Builds finish in the background and are swapped in by "CAsyncPipeline::update()"
+        uint32 update() noexcept;
+
+    private:
+        CShaderWatcher() noexcept;
+
+        // Watches the directory and every directory below it, returns how many watches were added
+        uint32 _watch(const std::filesystem::path&) noexcept;
+
+        int32 _fd = -1;
+        std::unordered_map<int32, std::filesystem::path> _directories;
+        std::vector<CRcPtr<CAsyncPipeline>> _pipelines;
+        std::vector<uint8> _events;
+
+        CRcPtr<CDevice> _device;
+    };
+} // namespace am
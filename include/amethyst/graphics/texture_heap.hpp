@@ -0,0 +1,84 @@
+#pragma once
+
+#include <amethyst/graphics/async_texture.hpp>
+
+#include <amethyst/meta/forwards.hpp>
+#include <amethyst/meta/macros.hpp>
+#include <amethyst/meta/types.hpp>
+
+#include <vulkan/vulkan.h>
+#include <volk.h>
+
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <mutex>
+
+namespace am {
+    struct STextureHeapStats {
+        uint32 live_slots = 0;
+        uint32 capacity = 0;
+        // Slots written by the last "flush()"
+        uint32 writes = 0;
+    };
+
+    // Device-global bindless array of sampled textures, one update-after-bind set that is never rebuilt. Every ready
+    // "CAsyncTexture" owns a slot for its whole lifetime and only slots written since the last "flush()" reach the
+    // driver. Shaders declare it as "layout (set = 2, binding = 0) uniform sampler2D[] u_textures", pipelines take the
+    // heap's layout for that set instead of building their own.
+    class AM_MODULE CTextureHeap {
+    public:
+        using Self = CTextureHeap;
+        constexpr static auto set_index = 2u;
+        // Never handed out, shaders treat it as "no texture"
+        constexpr static auto null_slot = 0u;
+        constexpr static auto max_capacity = 4096u;
+        // Left out of the device's update-after-bind limits for the sampled images of the other sets
+        constexpr static auto reserved_descriptors = 64u;
+
+        ~CTextureHeap() noexcept;
+
+        // Null when the device lacks "EDeviceFeature::BindlessTextures"
+        AM_NODISCARD static std::unique_ptr<Self> make(CDevice*) noexcept;
+
+        AM_NODISCARD VkDescriptorSet native() const noexcept;
+        AM_NODISCARD VkDescriptorSetLayout layout() const noexcept;
+        AM_NODISCARD uint32 capacity() const noexcept;
+
+        // Safe from any thread. "null_slot" once the heap is full
+        AM_NODISCARD uint32 allocate(STextureInfo) noexcept;
+        void write(uint32, STextureInfo) noexcept;
+        // The slot is handed out again once every frame in flight is done with it
+        void free(uint32) noexcept;
+        // Writes the pending slots, must run before the frame using them is submitted. Returns how many were written
+        uint32 flush() noexcept;
+        // Ages freed slots, called once per frame by the device
+        void update() noexcept;
+
+        AM_NODISCARD STextureHeapStats stats() const noexcept;
+
+    private:
+        struct SRetiredSlot {
+            uint32 slot = 0;
+            uint64 frame = 0;
+        };
+
+        CTextureHeap() noexcept;
+
+        VkDescriptorPool _pool = {};
+        VkDescriptorSetLayout _layout = {};
+        VkDescriptorSet _handle = {};
+        uint32 _capacity = 0;
+
+        std::unordered_map<uint32, STextureInfo> _pending;
+        std::vector<uint32> _free;
+        std::vector<SRetiredSlot> _retired;
+        mutable std::mutex _lock;
+        uint32 _next = null_slot + 1;
+        uint32 _live = 0;
+        uint32 _writes = 0;
+        uint64 _frame = 0;
+
+        CDevice* _device = nullptr;
+    };
+} // namespace am
@@ -50,6 +50,7 @@ namespace am {
             SMemoryProperties memory = {};
             uint64 capacity = 0;
             bool staging = false;
+            // Concurrent sharing across queue families, exclusive buffers are released and acquired explicitly
             bool shared = false;
             bool external = false;
         };
@@ -450,8 +451,8 @@ namespace am {
     template <typename T>
     void CTypedBuffer<T>::insert(uint64 where, const T& value) noexcept {
         AM_PROFILE_SCOPED();
-        AM_UNLIKELY_IF(where > _capacity) {
-            reallocate(std::max(_capacity * 2, where));
+        AM_UNLIKELY_IF(where >= _capacity) {
+            reallocate(std::max(_capacity * 2, where + 1));
         }
         std::memcpy(data() + where, &value, sizeof(T));
         _size = std::max(where + 1, _size);
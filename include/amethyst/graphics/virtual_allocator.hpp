@@ -22,6 +22,8 @@ namespace am {
             EBufferUsage usage = {};
             uint64 capacity = 0;
             bool staging = false;
+            // Shared by every queue family, exclusive buffers need their ownership transferred between families
+            bool concurrent = false;
         };
 
         ~CRawBuffer() noexcept;
@@ -7,11 +7,14 @@
 
 namespace am {
     constexpr struct SInvertedViewportTag {} inverted_viewport_tag;
+    constexpr struct SSecondaryCommandsTag {} secondary_commands_tag;
 
     constexpr auto frames_in_flight = 3u;
     constexpr auto all_layers = static_cast<uint32>(-1);
     constexpr auto all_mips = static_cast<uint32>(-1);
     constexpr auto external_subpass = VK_SUBPASS_EXTERNAL;
+    // Dynamic passes with more color attachments fall back to a render pass object
+    constexpr auto max_color_attachments = 8u;
 #if _WIN64
     constexpr auto external_memory_handle_type = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT;
 #else
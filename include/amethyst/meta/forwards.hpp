@@ -18,8 +18,19 @@ namespace am {
     class CRenderPass;
     class CImage;
     class CImageView;
+    class CImagePool;
+    class CGpuProfiler;
+    class CTextureHeap;
+    class CShaderCache;
+    class CShaderWatcher;
     class CSwapchain;
     class CCommandBuffer;
+    class CBarrierBatch;
+    struct SBufferMemoryBarrier;
+    struct SImageMemoryBarrier;
+    class CCommandAllocator;
+    class CParallelRecorder;
+    class CRenderGraph;
     class CFence;
     class CSemaphore;
     struct SDescriptorBinding;
@@ -34,6 +45,11 @@ namespace am {
     struct SSamplerInfo;
     struct STextureInfo;
     class CAsyncTexture;
+    class CAsyncModel;
+    class CAsyncPipeline;
+    struct SReadyEvent;
+    class CCompletionPoller;
+    class CRecycler;
     class CVirtualAllocator;
     class CRawBuffer;
     class CBufferSlice;
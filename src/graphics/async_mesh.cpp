@@ -1,5 +1,8 @@
+#include <amethyst/graphics/completion_poller.hpp>
 #include <amethyst/graphics/command_buffer.hpp>
+#include <amethyst/graphics/async_event.hpp>
 #include <amethyst/graphics/async_mesh.hpp>
+#include <amethyst/graphics/recycler.hpp>
 #include <amethyst/graphics/context.hpp>
 #include <amethyst/graphics/queue.hpp>
 
@@ -12,6 +15,7 @@
 #include <numeric>
 #include <cstring>
 #include <vector>
+#include <thread>
 
 namespace am {
     CAsyncMesh::CAsyncMesh() noexcept = default;
@@ -105,27 +109,71 @@ namespace am {
                 index_staging.insert(opt_indices.data(), index_staging.size());
                 auto index_dest = index_allocator->allocate(index_staging.size(), alignof(uint32));
 
-                auto transfer_cmds = CCommandBuffer::make(device, {
-                    .queue = EQueueType::Transfer,
-                    .pool = ECommandPoolType::Transient,
-                    .index = thread
-                });
+                auto transfer_cmds = device->recycler()->acquire_command_buffer(EQueueType::Transfer, thread);
+                const SBufferMemoryBarrier vertex_release = {
+                    .buffer = vertex_dest.info(),
+                    .source_stage = EPipelineStage::Transfer,
+                    .dest_stage = EPipelineStage::BottomOfPipe,
+                    .source_access = EResourceAccess::TransferWrite,
+                    .dest_access = EResourceAccess::None
+                };
+                const SBufferMemoryBarrier index_release = {
+                    .buffer = index_dest.info(),
+                    .source_stage = EPipelineStage::Transfer,
+                    .dest_stage = EPipelineStage::BottomOfPipe,
+                    .source_access = EResourceAccess::TransferWrite,
+                    .dest_access = EResourceAccess::None
+                };
+                CBarrierBatch release;
+                release
+                    .transfer_ownership(*device->transfer_queue(), *device->graphics_queue(), vertex_release)
+                    .transfer_ownership(*device->transfer_queue(), *device->graphics_queue(), index_release);
                 transfer_cmds->begin()
                     .copy_buffer(vertex_staging.info(), vertex_dest.info())
                     .copy_buffer(index_staging.info(), index_dest.info())
+                    .barrier(release)
                     .end();
-                auto fence = CFence::make(device, false);
-                device->transfer_queue()->submit({ {
+                const auto value = device->transfer_queue()->submit({ {
                     .stage_mask = EPipelineStage::TopOfPipe,
                     .command = transfer_cmds.get(),
                     .wait = nullptr,
                     .signal = nullptr,
-                } }, fence.get());
+                } });
+                // Vertex and index pools are exclusive, graphics acquires both ranges in its next submission.
+                // Shaders also pull vertices through their device address
+                device->graphics_queue()->acquire(*device->transfer_queue(), value, {
+                    .buffer = vertex_release.buffer,
+                    .source_stage = EPipelineStage::TopOfPipe,
+                    .dest_stage = EPipelineStage::AllGraphics,
+                    .source_access = EResourceAccess::None,
+                    .dest_access = EResourceAccess::VertexAttributeRead | EResourceAccess::ShaderRead
+                });
+                device->graphics_queue()->acquire(*device->transfer_queue(), value, {
+                    .buffer = index_release.buffer,
+                    .source_stage = EPipelineStage::TopOfPipe,
+                    .dest_stage = EPipelineStage::AllGraphics,
+                    .source_access = EResourceAccess::None,
+                    .dest_access = EResourceAccess::IndexRead | EResourceAccess::ShaderRead
+                });
                 result->_vertices = vertex_dest;
                 result->_indices = index_dest;
-                fence->wait();
-                staging_allocator->free(std::move(vertex_staging));
-                staging_allocator->free(std::move(index_staging));
+                // Staging memory is released by the poller once the copy retires, the worker moves on
+                device->completion_poller()->enqueue(device->transfer_queue(), value, thread, [
+                    device,
+                    result,
+                    transfer_cmds = std::move(transfer_cmds),
+                    vertex_staging = std::move(vertex_staging),
+                    index_staging = std::move(index_staging)
+                ]() mutable noexcept {
+                    auto* staging_allocator = device->virtual_allocator(EVirtualAllocatorKind::StagingBuffer);
+                    staging_allocator->free(std::move(vertex_staging));
+                    staging_allocator->free(std::move(index_staging));
+                    transfer_cmds.reset();
+                    auto self = prv::try_acquire(result);
+                    // Last access to "result" unless it was acquired, a pending destructor may proceed from here
+                    result->_ready.store(true, std::memory_order_release);
+                    prv::publish_ready(device.get(), std::move(self));
+                });
             });
         device->context()->scheduler()->AddTaskSetToPipe(result->_task.get());
 
@@ -155,14 +203,7 @@ namespace am {
 
     AM_NODISCARD bool CAsyncMesh::is_ready() const noexcept {
         AM_PROFILE_SCOPED();
-        AM_LIKELY_IF(!_task) {
-            return true;
-        }
-        AM_LIKELY_IF(_task->GetIsComplete()) {
-            wait();
-            return true;
-        }
-        return false;
+        return _ready.load(std::memory_order_acquire);
     }
 
     void CAsyncMesh::wait() const noexcept {
@@ -171,5 +212,10 @@ namespace am {
             _device->context()->scheduler()->WaitforTask(_task.get());
             _task.reset();
         }
+        while (!_ready.load(std::memory_order_acquire)) {
+            // The continuation might be pinned to the calling thread
+            _device->context()->scheduler()->RunPinnedTasks();
+            std::this_thread::yield();
+        }
     }
 } // namespace am
@@ -1,6 +1,7 @@
 #include <amethyst/core/file_view.hpp>
 
 #include <amethyst/graphics/async_model.hpp>
+#include <amethyst/graphics/async_event.hpp>
 #include <amethyst/graphics/context.hpp>
 
 #include <TaskScheduler.h>
@@ -262,6 +263,7 @@ namespace am {
                     }
                     cgltf_free(model);
                 }
+                prv::publish_ready(device.get(), prv::try_acquire(result));
             });
         device->context()->scheduler()->AddTaskSetToPipe(result->_task.get());
 
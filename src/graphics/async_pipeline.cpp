@@ -0,0 +1,142 @@
+#include <amethyst/graphics/async_pipeline.hpp>
+#include <amethyst/graphics/context.hpp>
+
+#include <amethyst/meta/constants.hpp>
+
+#include <TaskScheduler.h>
+
+namespace am {
+    CAsyncPipeline::CAsyncPipeline() noexcept = default;
+
+    CAsyncPipeline::~CAsyncPipeline() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(_task) {
+            _device->context()->scheduler()->WaitforTask(_task.get());
+        }
+    }
+
+    AM_NODISCARD CRcPtr<CAsyncPipeline> CAsyncPipeline::make(CRcPtr<CDevice> device, CPipeline::SGraphicsCreateInfo&& info) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = CRcPtr<Self>::make(new Self());
+        result->_graphics_info = std::move(info);
+        result->_type = EPipelineType::Graphics;
+        result->_device = std::move(device);
+        result->_build();
+        return result;
+    }
+
+    AM_NODISCARD CRcPtr<CAsyncPipeline> CAsyncPipeline::make(CRcPtr<CDevice> device, CPipeline::SComputeCreateInfo&& info) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = CRcPtr<Self>::make(new Self());
+        result->_compute_info = std::move(info);
+        result->_type = EPipelineType::Compute;
+        result->_device = std::move(device);
+        result->_build();
+        return result;
+    }
+
+    AM_NODISCARD const CRcPtr<CPipeline>& CAsyncPipeline::handle() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _handle;
+    }
+
+    AM_NODISCARD bool CAsyncPipeline::is_ready() const noexcept {
+        AM_PROFILE_SCOPED();
+        return (bool)_handle;
+    }
+
+    AM_NODISCARD bool CAsyncPipeline::is_pending() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _task != nullptr;
+    }
+
+    void CAsyncPipeline::reload() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(_task) {
+            _reload = true;
+            return;
+        }
+        _build();
+    }
+
+    AM_NODISCARD bool CAsyncPipeline::update() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(!_task || !_done.load(std::memory_order_acquire)) {
+            return false;
+        }
+        // Completion is signalled last thing in the task, the wait only lets enki retire it
+        _device->context()->scheduler()->WaitforTask(_task.get());
+        _task.reset();
+        auto pending = std::move(_pending);
+        AM_UNLIKELY_IF(_reload) {
+            _reload = false;
+            _build();
+        }
+        AM_UNLIKELY_IF(!pending) {
+            AM_LOG_WARN(_device->logger(), "async pipeline: build failed, keeping the current pipeline");
+            return false;
+        }
+        AM_LIKELY_IF(_handle) {
+            _device->cleanup_after(frames_in_flight + 1, [old = std::move(_handle)](const CDevice*) mutable noexcept {});
+        }
+        _handle = std::move(pending);
+        return true;
+    }
+
+    AM_NODISCARD std::vector<std::filesystem::path> CAsyncPipeline::sources() const noexcept {
+        AM_PROFILE_SCOPED();
+        std::vector<std::filesystem::path> result;
+        switch (_type) {
+            case EPipelineType::Graphics:
+                for (const auto* each : { &_graphics_info.vertex, &_graphics_info.geometry, &_graphics_info.fragment }) {
+                    AM_LIKELY_IF(!each->empty()) {
+                        result.emplace_back(*each);
+                    }
+                }
+                break;
+            case EPipelineType::Compute:
+                result.emplace_back(_compute_info.compute);
+                break;
+            default: break;
+        }
+        return result;
+    }
+
+    void CAsyncPipeline::wait() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(_task) {
+            _device->context()->scheduler()->WaitforTask(_task.get());
+            (void)update();
+        }
+    }
+
+    void CAsyncPipeline::_build() noexcept {
+        AM_PROFILE_SCOPED();
+        _done.store(false, std::memory_order_relaxed);
+        // Variants the current pipeline handed out are rebuilt up front, a reload does not stall the first bind
+        auto variants = _handle ? _handle->variants() : std::vector<std::vector<SSpecializationConstant>>();
+        _task = std::make_unique<enki::TaskSet>(1, [this, variants = std::move(variants)](enki::TaskSetPartition, uint32) noexcept {
+            AM_PROFILE_SCOPED();
+            switch (_type) {
+                case EPipelineType::Graphics: {
+                    auto info = _graphics_info;
+                    _pending = CPipeline::make(_device, std::move(info));
+                    break;
+                }
+                case EPipelineType::Compute: {
+                    auto info = _compute_info;
+                    _pending = CPipeline::make(_device, std::move(info));
+                    break;
+                }
+                default: AM_UNREACHABLE();
+            }
+            AM_LIKELY_IF(_pending) {
+                for (const auto& each : variants) {
+                    (void)_pending->build_variant(each);
+                }
+            }
+            _done.store(true, std::memory_order_release);
+        });
+        _device->context()->scheduler()->AddTaskSetToPipe(_task.get());
+    }
+} // namespace am
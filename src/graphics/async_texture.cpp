@@ -1,9 +1,13 @@
 #include <amethyst/core/file_view.hpp>
 
+#include <amethyst/graphics/completion_poller.hpp>
 #include <amethyst/graphics/virtual_allocator.hpp>
 #include <amethyst/graphics/command_buffer.hpp>
+#include <amethyst/graphics/texture_heap.hpp>
 #include <amethyst/graphics/async_texture.hpp>
+#include <amethyst/graphics/async_event.hpp>
 #include <amethyst/graphics/typed_buffer.hpp>
+#include <amethyst/graphics/recycler.hpp>
 #include <amethyst/graphics/context.hpp>
 
 #include <amethyst/meta/constants.hpp>
@@ -12,12 +16,17 @@
 
 #include <ktx.h>
 
+#include <thread>
+
 namespace am {
     CAsyncTexture::CAsyncTexture() noexcept = default;
 
     CAsyncTexture::~CAsyncTexture() noexcept {
         AM_PROFILE_SCOPED();
         wait();
+        AM_LIKELY_IF(auto* heap = _device->texture_heap()) {
+            heap->free(_slot);
+        }
     }
 
     AM_NODISCARD CRcPtr<CAsyncTexture> CAsyncTexture::sync_make(CRcPtr<CDevice> device, SCreateInfo&& info) noexcept {
@@ -46,6 +55,7 @@ namespace am {
                             break;
                     }
                     // TODO: Do something useful
+                    result->_ready.store(true, std::memory_order_release);
                     return;
                 }
                 ktxTexture2* texture;
@@ -74,11 +84,7 @@ namespace am {
                     .width = texture->baseWidth,
                     .height = texture->baseHeight
                 });
-                auto transfer_cmds = CCommandBuffer::make(device, {
-                    .queue = EQueueType::Transfer,
-                    .pool = ECommandPoolType::Transient,
-                    .index = thread
-                });
+                auto transfer_cmds = device->recycler()->acquire_command_buffer(EQueueType::Transfer, thread);
 
                 transfer_cmds->begin()
                     .transition_layout({
@@ -108,44 +114,45 @@ namespace am {
                     .layer = all_layers,
                     .mip = all_mips
                 }).end();
-                auto transfer_done = CSemaphore::make(device);
-                device->transfer_queue()->submit({ {
+                const auto value = device->transfer_queue()->submit({ {
                     .stage_mask = EPipelineStage::TopOfPipe,
                     .command = transfer_cmds.get(),
                     .wait = nullptr,
-                    .signal = transfer_done.get(),
-                } }, nullptr);
-                auto ownership_cmds = CCommandBuffer::make(device, {
-                    .queue = EQueueType::Graphics,
-                    .pool = ECommandPoolType::Transient,
-                    .index = thread
-                });
-                ownership_cmds->begin();
-                AM_UNLIKELY_IF(device->transfer_queue()->family() != device->graphics_queue()->family()) {
-                    ownership_cmds->transfer_ownership(*device->transfer_queue(), *device->graphics_queue(), {
-                        .image = image.get(),
-                        .source_stage = EPipelineStage::TopOfPipe,
-                        .dest_stage = EPipelineStage::FragmentShader,
-                        .source_access = EResourceAccess::None,
-                        .dest_access = EResourceAccess::ShaderRead,
-                        .old_layout = EImageLayout::TransferDSTOptimal,
-                        .new_layout = EImageLayout::ShaderReadOnlyOptimal,
-                        .layer = all_layers,
-                        .mip = all_mips
-                    });
-                }
-                ownership_cmds->end();
-                auto fence = CFence::make(device, false);
-                device->graphics_queue()->submit({ {
-                    .stage_mask = EPipelineStage::Transfer,
-                    .command = ownership_cmds.get(),
-                    .wait = transfer_done.get(),
                     .signal = nullptr,
-                } }, fence.get());
+                } });
+                // Acquired in one batch with every other upload at the start of the next graphics submission
+                device->graphics_queue()->acquire(*device->transfer_queue(), value, {
+                    .image = image.get(),
+                    .source_stage = EPipelineStage::TopOfPipe,
+                    .dest_stage = EPipelineStage::FragmentShader,
+                    .source_access = EResourceAccess::None,
+                    .dest_access = EResourceAccess::ShaderRead,
+                    .old_layout = EImageLayout::TransferDSTOptimal,
+                    .new_layout = EImageLayout::ShaderReadOnlyOptimal,
+                    .layer = all_layers,
+                    .mip = all_mips
+                });
                 result->_handle = std::move(image);
                 ktxTexture_Destroy(ktxTexture(texture));
-                fence->wait();
-                staging_allocator->free(std::move(staging));
+                // Staging memory is released by the poller once the upload retires, the worker moves on
+                device->completion_poller()->enqueue(device->transfer_queue(), value, thread, [
+                    device,
+                    result,
+                    sampler = data.sampler,
+                    transfer_cmds = std::move(transfer_cmds),
+                    staging = std::move(staging)
+                ]() mutable noexcept {
+                    auto* staging_allocator = device->virtual_allocator(EVirtualAllocatorKind::StagingBuffer);
+                    staging_allocator->free(std::move(staging));
+                    transfer_cmds.reset();
+                    AM_LIKELY_IF(auto* heap = device->texture_heap()) {
+                        result->_slot = heap->allocate(device->sample(result->_handle.get(), sampler));
+                    }
+                    auto self = prv::try_acquire(result);
+                    // Last access to "result" unless it was acquired, a pending destructor may proceed from here
+                    result->_ready.store(true, std::memory_order_release);
+                    prv::publish_ready(device.get(), std::move(self));
+                });
             });
         device->context()->scheduler()->AddTaskSetToPipe(result->_task.get());
 
@@ -158,16 +165,17 @@ namespace am {
         return _handle.get();
     }
 
-    AM_NODISCARD bool CAsyncTexture::is_ready() const noexcept {
+    AM_NODISCARD uint32 CAsyncTexture::slot() const noexcept {
         AM_PROFILE_SCOPED();
-        AM_LIKELY_IF(!_task) {
-            return true;
+        AM_LIKELY_IF(_ready.load(std::memory_order_acquire)) {
+            return _slot;
         }
-        AM_LIKELY_IF(_task->GetIsComplete()) {
-            wait();
-            return true;
-        }
-        return false;
+        return CTextureHeap::null_slot;
+    }
+
+    AM_NODISCARD bool CAsyncTexture::is_ready() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _ready.load(std::memory_order_acquire);
     }
 
     void CAsyncTexture::wait() const noexcept {
@@ -176,5 +184,10 @@ namespace am {
             _device->context()->scheduler()->WaitforTask(_task.get());
             _task.reset();
         }
+        while (!_ready.load(std::memory_order_acquire)) {
+            // The continuation might be pinned to the calling thread
+            _device->context()->scheduler()->RunPinnedTasks();
+            std::this_thread::yield();
+        }
     }
 } // namespace am
@@ -0,0 +1,91 @@
+#include <amethyst/graphics/command_allocator.hpp>
+
+namespace am {
+    CCommandAllocator::CCommandAllocator() noexcept = default;
+
+    CCommandAllocator::~CCommandAllocator() noexcept {
+        AM_PROFILE_SCOPED();
+        for (auto& pool : _pools) {
+            pool.commands = {};
+            vkDestroyCommandPool(_device->native(), pool.handle, nullptr);
+        }
+    }
+
+    AM_NODISCARD CRcPtr<CCommandAllocator> CCommandAllocator::make(CRcPtr<CDevice> device, SCreateInfo&& info) noexcept {
+        AM_PROFILE_SCOPED();
+        auto* result = new Self();
+        const CQueue* queue = nullptr;
+        switch (info.queue) {
+            case EQueueType::Graphics: queue = device->graphics_queue(); break;
+            case EQueueType::Transfer: queue = device->transfer_queue(); break;
+            case EQueueType::Compute: queue = device->compute_queue(); break;
+        }
+        result->_threads = queue->threads();
+        result->_pools = std::vector<SThreadPool>(frames_in_flight * result->_threads);
+        VkCommandPoolCreateInfo command_pool_info = {};
+        command_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        command_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        command_pool_info.queueFamilyIndex = queue->family();
+        for (auto& pool : result->_pools) {
+            AM_VULKAN_CHECK(device->logger(), vkCreateCommandPool(device->native(), &command_pool_info, nullptr, &pool.handle));
+        }
+        AM_LOG_INFO(device->logger(), "command allocator: {} pools, {} threads", result->_pools.size(), result->_threads);
+        result->_queue = info.queue;
+        result->_device = std::move(device);
+        return CRcPtr<Self>::make(result);
+    }
+
+    AM_NODISCARD uint32 CCommandAllocator::frame() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _frame;
+    }
+
+    AM_NODISCARD uint32 CCommandAllocator::threads() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _threads;
+    }
+
+    void CCommandAllocator::begin_frame(uint32 frame) noexcept {
+        AM_PROFILE_SCOPED();
+        _frame = frame;
+        for (uint32 thread = 0; thread < _threads; ++thread) {
+            auto& pool = _pool(frame, thread);
+            AM_UNLIKELY_IF(pool.used[0] == 0 && pool.used[1] == 0) {
+                continue;
+            }
+            AM_VULKAN_CHECK(_device->logger(), vkResetCommandPool(_device->native(), pool.handle, 0));
+            pool.used = {};
+        }
+    }
+
+    AM_NODISCARD CCommandBuffer& CCommandAllocator::acquire(uint32 thread, ECommandBufferLevel level) noexcept {
+        AM_PROFILE_SCOPED();
+        auto& pool = _pool(_frame, thread);
+        auto& commands = pool.commands[(uint32)level];
+        auto& used = pool.used[(uint32)level];
+        AM_UNLIKELY_IF(used == commands.size()) {
+            VkCommandBufferAllocateInfo allocate_info = {};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = pool.handle;
+            allocate_info.level = level == ECommandBufferLevel::Primary ?
+                VK_COMMAND_BUFFER_LEVEL_PRIMARY :
+                VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocate_info.commandBufferCount = 1;
+            auto* result = new CCommandBuffer();
+            AM_VULKAN_CHECK(_device->logger(), vkAllocateCommandBuffers(_device->native(), &allocate_info, &result->_handle));
+            result->_pool = pool.handle;
+            result->_queue = _queue;
+            result->_pool_type = ECommandPoolType::Main;
+            result->_index = thread;
+            result->_device = _device;
+            commands.emplace_back(CRcPtr<CCommandBuffer>::make(result));
+        }
+        return *commands[used++];
+    }
+
+    AM_NODISCARD CCommandAllocator::SThreadPool& CCommandAllocator::_pool(uint32 frame, uint32 thread) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_ASSERT(thread < _threads, "thread index out of range");
+        return _pools[frame * _threads + thread];
+    }
+} // namespace am
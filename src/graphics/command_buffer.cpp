@@ -1,30 +1,35 @@
 #include <amethyst/graphics/command_buffer.hpp>
 #include <amethyst/graphics/descriptor_set.hpp>
+#include <amethyst/graphics/texture_heap.hpp>
+#include <amethyst/graphics/gpu_profiler.hpp>
 #include <amethyst/graphics/render_pass.hpp>
 #include <amethyst/graphics/framebuffer.hpp>
 #include <amethyst/graphics/query_pool.hpp>
 #include <amethyst/graphics/async_mesh.hpp>
+#include <amethyst/graphics/recycler.hpp>
 #include <amethyst/graphics/pipeline.hpp>
 #include <amethyst/graphics/image.hpp>
 
 #include <amethyst/meta/constants.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <array>
+
 namespace am {
-    AM_NODISCARD static inline VkCommandPool get_command_pool(CDevice* device, const CCommandBuffer::SCreateInfo& info) noexcept {
+    AM_NODISCARD static inline CQueue* get_queue(CDevice* device, EQueueType type) noexcept {
         AM_PROFILE_SCOPED();
-        CQueue* queue;
-        switch (info.queue) {
-            case EQueueType::Graphics:
-                queue = device->graphics_queue();
-                break;
-            case EQueueType::Transfer:
-                queue = device->transfer_queue();
-                break;
-            case EQueueType::Compute:
-                queue = device->compute_queue();
-                break;
-            default: AM_UNREACHABLE();
+        switch (type) {
+            case EQueueType::Graphics: return device->graphics_queue();
+            case EQueueType::Transfer: return device->transfer_queue();
+            case EQueueType::Compute: return device->compute_queue();
         }
+        AM_UNREACHABLE();
+    }
+
+    AM_NODISCARD static inline VkCommandPool get_command_pool(CDevice* device, const CCommandBuffer::SCreateInfo& info) noexcept {
+        AM_PROFILE_SCOPED();
+        auto* queue = get_queue(device, info.queue);
         VkCommandPool pool;
         switch (info.pool) {
             case ECommandPoolType::Main:
@@ -47,11 +52,103 @@ namespace am {
         AM_UNREACHABLE();
     }
 
+    // The low 32 bits of the synchronization2 flags match the legacy ones, the stages added with it are folded into the
+    // legacy stage covering them
+    AM_NODISCARD static inline VkPipelineStageFlags as_legacy_stages(VkPipelineStageFlags2 stages) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = (VkPipelineStageFlags)(stages & 0xffffffffull);
+        AM_LIKELY_IF(stages == result) {
+            return result;
+        }
+        constexpr auto transfer =
+            VK_PIPELINE_STAGE_2_COPY_BIT |
+            VK_PIPELINE_STAGE_2_RESOLVE_BIT |
+            VK_PIPELINE_STAGE_2_BLIT_BIT |
+            VK_PIPELINE_STAGE_2_CLEAR_BIT;
+        constexpr auto vertex_input =
+            VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT |
+            VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+        AM_UNLIKELY_IF(stages & transfer) {
+            result |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        }
+        AM_UNLIKELY_IF(stages & vertex_input) {
+            result |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        }
+        AM_UNLIKELY_IF(stages & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT) {
+            result |=
+                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+                VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT |
+                VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
+        }
+        const auto unmapped = (stages >> 32) & ~((transfer | vertex_input | VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT) >> 32);
+        AM_ASSERT(unmapped == 0, "pipeline stage without a legacy equivalent");
+        AM_UNLIKELY_IF(unmapped != 0) {
+            result |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        }
+        return result;
+    }
+
+    AM_NODISCARD static inline VkAccessFlags as_legacy_access(VkAccessFlags2 access) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = (VkAccessFlags)(access & 0xffffffffull);
+        AM_LIKELY_IF(access == result) {
+            return result;
+        }
+        constexpr auto reads =
+            VK_ACCESS_2_SHADER_SAMPLED_READ_BIT |
+            VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+        AM_UNLIKELY_IF(access & reads) {
+            result |= VK_ACCESS_SHADER_READ_BIT;
+        }
+        AM_UNLIKELY_IF(access & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT) {
+            result |= VK_ACCESS_SHADER_WRITE_BIT;
+        }
+        const auto unmapped = (access >> 32) & ~((reads | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT) >> 32);
+        AM_ASSERT(unmapped == 0, "access without a legacy equivalent");
+        AM_UNLIKELY_IF(unmapped != 0) {
+            result |= VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        }
+        return result;
+    }
+
+    AM_NODISCARD static inline VkImageSubresourceRange make_subresource_range(const SImageMemoryBarrier& info) noexcept {
+        AM_PROFILE_SCOPED();
+        VkImageSubresourceRange range = {};
+        range.aspectMask = info.image->aspect();
+        AM_UNLIKELY_IF(info.mip == all_mips) {
+            range.baseMipLevel = 0;
+            range.levelCount = info.image->mips();
+        } else {
+            range.baseMipLevel = info.mip;
+            range.levelCount = 1;
+        }
+        AM_UNLIKELY_IF(info.layer == all_layers) {
+            range.baseArrayLayer = 0;
+            range.layerCount = info.image->layers();
+        } else {
+            range.baseArrayLayer = info.layer;
+            range.layerCount = 1;
+        }
+        return range;
+    }
+
     CCommandBuffer::CCommandBuffer() noexcept = default;
 
     CCommandBuffer::~CCommandBuffer() noexcept {
         AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(_recycled) {
+            _device->recycler()->recycle_command_buffer(_queue, _index, _handle);
+            return;
+        }
         AM_LOG_INFO(_device->logger(), "deallocating command buffer: {}", (const void*)_handle);
+        AM_UNLIKELY_IF(_pool_type == ECommandPoolType::Transient) {
+            auto* queue = get_queue(_device.get(), _queue);
+            queue->lock_pool(_index);
+            vkFreeCommandBuffers(_device->native(), _pool, 1, &_handle);
+            queue->unlock_pool(_index);
+            return;
+        }
         vkFreeCommandBuffers(_device->native(), _pool, 1, &_handle);
     }
 
@@ -63,9 +160,20 @@ namespace am {
         allocate_info.commandPool = get_command_pool(device.get(), info);
         allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
         allocate_info.commandBufferCount = 1;
-        AM_VULKAN_CHECK(device->logger(), vkAllocateCommandBuffers(device->native(), &allocate_info, &result->_handle));
+        AM_UNLIKELY_IF(info.pool == ECommandPoolType::Transient) {
+            // Transient pools are shared with the recycler and allocators of the same thread
+            auto* queue = get_queue(device.get(), info.queue);
+            queue->lock_pool(info.index);
+            AM_VULKAN_CHECK(device->logger(), vkAllocateCommandBuffers(device->native(), &allocate_info, &result->_handle));
+            queue->unlock_pool(info.index);
+        } else {
+            AM_VULKAN_CHECK(device->logger(), vkAllocateCommandBuffers(device->native(), &allocate_info, &result->_handle));
+        }
         AM_LOG_DEBUG(device->logger(), "allocating command buffer: {}", (const void*)result->_handle);
         result->_pool = allocate_info.commandPool;
+        result->_queue = info.queue;
+        result->_pool_type = info.pool;
+        result->_index = info.index;
         result->_device = std::move(device);
         return CRcPtr<Self>::make(result);
     }
@@ -82,11 +190,21 @@ namespace am {
         allocate_info.commandPool = get_command_pool(device.get(), info);
         allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
         allocate_info.commandBufferCount = count;
-        AM_VULKAN_CHECK(device->logger(), vkAllocateCommandBuffers(device->native(), &allocate_info, allocated.data()));
+        AM_UNLIKELY_IF(info.pool == ECommandPoolType::Transient) {
+            auto* queue = get_queue(device.get(), info.queue);
+            queue->lock_pool(info.index);
+            AM_VULKAN_CHECK(device->logger(), vkAllocateCommandBuffers(device->native(), &allocate_info, allocated.data()));
+            queue->unlock_pool(info.index);
+        } else {
+            AM_VULKAN_CHECK(device->logger(), vkAllocateCommandBuffers(device->native(), &allocate_info, allocated.data()));
+        }
         for (uint32 i = 0; i < count; ++i) {
             auto& current = result.emplace_back(CRcPtr<Self>::make(new Self()));
             current->_handle = allocated[i];
             current->_pool = allocate_info.commandPool;
+            current->_queue = info.queue;
+            current->_pool_type = info.pool;
+            current->_index = info.index;
             current->_device = device;
         }
         AM_LOG_INFO(device->logger(), "allocating command buffer: {}, count: {}", (const void*)allocated[0], count);
@@ -99,18 +217,74 @@ namespace am {
         begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         AM_VULKAN_CHECK(_device->logger(), vkBeginCommandBuffer(_handle, &begin_info));
-        return *this;
+        _elided_calls = 0;
+        _zones.clear();
+        return invalidate_state();
+    }
+
+    CCommandBuffer& CCommandBuffer::begin(const CFramebuffer* framebuffer,
+                                          const CRenderPass* render_pass,
+                                          EQueryPipelineStatistics statistics) noexcept {
+        AM_PROFILE_SCOPED();
+        _active_framebuffer = framebuffer;
+        _active_pipeline = nullptr;
+        const auto* pass = render_pass ? render_pass : framebuffer->render_pass();
+        VkCommandBufferInheritanceInfo inheritance_info = {};
+        inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance_info.renderPass = pass->native();
+        inheritance_info.subpass = 0;
+        inheritance_info.framebuffer = framebuffer->native();
+        std::array<VkFormat, max_color_attachments> color_formats;
+        uint32 color_count = 0;
+        VkCommandBufferInheritanceRenderingInfo rendering_info = {};
+        rendering_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        AM_LIKELY_IF(pass->is_dynamic()) {
+            // Dynamic passes have no render pass object, the inheritance must not name one
+            inheritance_info.renderPass = VK_NULL_HANDLE;
+            inheritance_info.framebuffer = VK_NULL_HANDLE;
+            for (const auto& attachment : pass->rendering_attachments()) {
+                AM_UNLIKELY_IF(attachment.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) {
+                    rendering_info.depthAttachmentFormat = attachment.format;
+                    AM_UNLIKELY_IF(attachment.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) {
+                        rendering_info.stencilAttachmentFormat = attachment.format;
+                    }
+                } else {
+                    color_formats[color_count++] = attachment.format;
+                }
+                rendering_info.rasterizationSamples = framebuffer->image(attachment.index)->samples();
+            }
+            rendering_info.colorAttachmentCount = color_count;
+            rendering_info.pColorAttachmentFormats = color_formats.data();
+            inheritance_info.pNext = &rendering_info;
+        }
+        inheritance_info.pipelineStatistics = prv::as_vulkan(statistics);
+        AM_ASSERT(
+            !inheritance_info.pipelineStatistics || _device->feature_support(EDeviceFeature::InheritedQueries),
+            "inherited pipeline statistics require \"EDeviceFeature::InheritedQueries\"");
+
+        VkCommandBufferBeginInfo begin_info = {};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags =
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+            VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        begin_info.pInheritanceInfo = &inheritance_info;
+        AM_VULKAN_CHECK(_device->logger(), vkBeginCommandBuffer(_handle, &begin_info));
+        _elided_calls = 0;
+        _zones.clear();
+        return invalidate_state();
     }
 
     CCommandBuffer& CCommandBuffer::begin_render_pass(const CFramebuffer* framebuffer, const CRenderPass* render_pass) noexcept {
         AM_PROFILE_SCOPED();
         _active_framebuffer = framebuffer;
+        _active_render_pass = render_pass ? render_pass : framebuffer->render_pass();
+        AM_LIKELY_IF(_active_render_pass->is_dynamic()) {
+            return _begin_rendering(0);
+        }
         const auto clears = framebuffer->clears();
         VkRenderPassBeginInfo begin_info = {};
         begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        begin_info.renderPass = render_pass ?
-            render_pass->native() :
-            framebuffer->render_pass()->native();
+        begin_info.renderPass = _active_render_pass->native();
         begin_info.framebuffer = framebuffer->native();
         begin_info.renderArea = { {}, framebuffer->viewport() };
         begin_info.clearValueCount = (uint32)clears.size();
@@ -122,6 +296,24 @@ namespace am {
     CCommandBuffer& CCommandBuffer::bind_pipeline(const CPipeline* pipeline) noexcept {
         AM_PROFILE_SCOPED();
         _active_pipeline = pipeline;
+        auto& bound = _bound.bind_points[(uint32)pipeline->type()];
+        AM_UNLIKELY_IF(bound.pipeline == pipeline->native()) {
+            _elided_calls++;
+            return *this;
+        }
+        const auto layout = pipeline->main_layout();
+        AM_UNLIKELY_IF(bound.layout != layout) {
+            // Layout compatibility isn't tracked, sets bound through another layout are assumed disturbed
+            bound.layout = layout;
+            bound.sets = {};
+        }
+        AM_UNLIKELY_IF(_bound.push_layout != layout) {
+            _bound.push_size = 0;
+        }
+        // Static viewport or scissor state of the new pipeline would replace the dynamic one
+        _bound.has_viewport = false;
+        _bound.has_scissor = false;
+        bound.pipeline = pipeline->native();
         vkCmdBindPipeline(_handle, deduce_bind_point(pipeline), pipeline->native());
         return *this;
     }
@@ -136,7 +328,7 @@ namespace am {
         viewport.height = (float32)fb_viewport.height;
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(_handle, 0, 1, &viewport);
+        _set_viewport(viewport);
         return *this;
     }
 
@@ -150,7 +342,7 @@ namespace am {
         viewport.height = -(float32)fb_viewport.height;
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(_handle, 0, 1, &viewport);
+        _set_viewport(viewport);
         return *this;
     }
 
@@ -160,39 +352,99 @@ namespace am {
         VkRect2D scissor = {};
         scissor.offset = {};
         scissor.extent = fb_viewport;
+        AM_UNLIKELY_IF(_bound.has_scissor && std::memcmp(&_bound.scissor, &scissor, sizeof scissor) == 0) {
+            _elided_calls++;
+            return *this;
+        }
+        _bound.scissor = scissor;
+        _bound.has_scissor = true;
         vkCmdSetScissor(_handle, 0, 1, &scissor);
         return *this;
     }
 
     CCommandBuffer& CCommandBuffer::bind_descriptor_set(const CDescriptorSet* set) noexcept {
         AM_PROFILE_SCOPED();
+        AM_ASSERT(!set->has_pending_writes(), "descriptor set bound with pending writes, flush it first");
         const auto handle = set->native();
+        auto& bound = _bound.bind_points[(uint32)_active_pipeline->type()];
+        AM_LIKELY_IF(set->index() < bound.sets.size()) {
+            AM_UNLIKELY_IF(bound.sets[set->index()] == handle) {
+                _elided_calls++;
+                return *this;
+            }
+            bound.sets[set->index()] = handle;
+        }
         vkCmdBindDescriptorSets(_handle, deduce_bind_point(_active_pipeline), _active_pipeline->main_layout(), set->index(), 1, &handle, 0, nullptr);
         return *this;
     }
 
+    CCommandBuffer& CCommandBuffer::bind_texture_heap() noexcept {
+        AM_PROFILE_SCOPED();
+        const auto* heap = _device->texture_heap();
+        AM_UNLIKELY_IF(!heap) {
+            return *this;
+        }
+        const auto handle = heap->native();
+        auto& bound = _bound.bind_points[(uint32)_active_pipeline->type()];
+        AM_UNLIKELY_IF(bound.sets[CTextureHeap::set_index] == handle) {
+            _elided_calls++;
+            return *this;
+        }
+        bound.sets[CTextureHeap::set_index] = handle;
+        vkCmdBindDescriptorSets(_handle, deduce_bind_point(_active_pipeline), _active_pipeline->main_layout(), CTextureHeap::set_index, 1, &handle, 0, nullptr);
+        return *this;
+    }
+
     CCommandBuffer& CCommandBuffer::bind_vertex_buffer(const SBufferInfo& buffer) noexcept {
         AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(_bound.vertex_buffer.handle == buffer.handle && _bound.vertex_buffer.offset == buffer.offset) {
+            _elided_calls++;
+            return *this;
+        }
+        _bound.vertex_buffer = buffer;
         vkCmdBindVertexBuffers(_handle, 0, 1, &buffer.handle, &buffer.offset);
         return *this;
     }
 
     CCommandBuffer& CCommandBuffer::bind_index_buffer(const SBufferInfo& buffer) noexcept {
         AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(_bound.index_buffer.handle == buffer.handle && _bound.index_buffer.offset == buffer.offset) {
+            _elided_calls++;
+            return *this;
+        }
+        _bound.index_buffer = buffer;
         vkCmdBindIndexBuffer(_handle, buffer.handle, buffer.offset, VK_INDEX_TYPE_UINT32);
         return *this;
     }
 
     CCommandBuffer& CCommandBuffer::push_constants(EShaderStage stage, const void* data, uint32 size) noexcept {
         AM_PROFILE_SCOPED();
-        vkCmdPushConstants(_handle, _active_pipeline->main_layout(), prv::as_vulkan(stage), 0, size, data);
+        const auto layout = _active_pipeline->main_layout();
+        const VkShaderStageFlags stages = prv::as_vulkan(stage);
+        AM_UNLIKELY_IF(
+            _bound.push_size == size &&
+            _bound.push_layout == layout &&
+            _bound.push_stages == stages &&
+            std::memcmp(_bound.push_data.data(), data, size) == 0) {
+            _elided_calls++;
+            return *this;
+        }
+        vkCmdPushConstants(_handle, layout, stages, 0, size, data);
+        AM_LIKELY_IF(size <= _bound.push_data.size()) {
+            std::memcpy(_bound.push_data.data(), data, size);
+            _bound.push_layout = layout;
+            _bound.push_stages = stages;
+            _bound.push_size = size;
+        } else {
+            _bound.push_size = 0;
+        }
         return *this;
     }
 
     CCommandBuffer& CCommandBuffer::bind_mesh(const CAsyncMesh* mesh) noexcept {
         AM_PROFILE_SCOPED();
         bind_vertex_buffer(mesh->vertices()->info());
-        bind_vertex_buffer(mesh->indices()->info());
+        bind_index_buffer(mesh->indices()->info());
         return *this;
     }
 
@@ -233,11 +485,71 @@ namespace am {
         return *this;
     }
 
+    CCommandBuffer& CCommandBuffer::begin_render_pass(const CFramebuffer* framebuffer, SSecondaryCommandsTag, const CRenderPass* render_pass) noexcept {
+        AM_PROFILE_SCOPED();
+        _active_framebuffer = framebuffer;
+        _active_render_pass = render_pass ? render_pass : framebuffer->render_pass();
+        AM_LIKELY_IF(_active_render_pass->is_dynamic()) {
+            return _begin_rendering(VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT);
+        }
+        const auto clears = framebuffer->clears();
+        VkRenderPassBeginInfo begin_info = {};
+        begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        begin_info.renderPass = _active_render_pass->native();
+        begin_info.framebuffer = framebuffer->native();
+        begin_info.renderArea = { {}, framebuffer->viewport() };
+        begin_info.clearValueCount = (uint32)clears.size();
+        begin_info.pClearValues = clears.data();
+        vkCmdBeginRenderPass(_handle, &begin_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        return *this;
+    }
+
+    CCommandBuffer& CCommandBuffer::execute(const std::vector<CCommandBuffer*>& commands) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(commands.empty()) {
+            return *this;
+        }
+        // Handed to the driver in chunks, a frame only has a handful of secondaries per pass
+        std::array<VkCommandBuffer, 32> handles;
+        for (uint64 first = 0; first < commands.size(); first += handles.size()) {
+            const auto count = std::min<uint64>(commands.size() - first, handles.size());
+            for (uint64 i = 0; i < count; ++i) {
+                handles[i] = commands[first + i]->native();
+            }
+            vkCmdExecuteCommands(_handle, (uint32)count, handles.data());
+        }
+        // Bound state is undefined after executing secondaries
+        return invalidate_state();
+    }
+
     CCommandBuffer& CCommandBuffer::end_render_pass() noexcept {
         AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(_active_render_pass && _active_render_pass->is_dynamic()) {
+            vkCmdEndRendering(_handle);
+            // Final layouts and the outgoing external dependency of the pass
+            const auto& dependency = _active_render_pass->end_dependency();
+            for (const auto& attachment : _active_render_pass->rendering_attachments()) {
+                const auto final_layout = _active_render_pass->attachment(attachment.index).layout.final;
+                _barriers.image({
+                    .image = _active_framebuffer->image(attachment.index),
+                    .source_stage = dependency.source_stage,
+                    .dest_stage = dependency.dest_stage,
+                    .source_access = dependency.source_access,
+                    .dest_access = dependency.dest_access,
+                    .old_layout = attachment.layout,
+                    .new_layout =
+                        final_layout == EImageLayout::Undefined ?
+                            attachment.layout :
+                            final_layout
+                });
+            }
+            barrier(_barriers);
+        } else {
+            vkCmdEndRenderPass(_handle);
+        }
         _active_framebuffer = nullptr;
+        _active_render_pass = nullptr;
         _active_pipeline = nullptr;
-        vkCmdEndRenderPass(_handle);
         return *this;
     }
 
@@ -257,6 +569,12 @@ namespace am {
         return *this;
     }
 
+    CCommandBuffer& CCommandBuffer::fill_buffer(const SBufferInfo& buffer, uint32 value) noexcept {
+        AM_PROFILE_SCOPED();
+        vkCmdFillBuffer(_handle, buffer.handle, buffer.offset, buffer.size, value);
+        return *this;
+    }
+
     CCommandBuffer& CCommandBuffer::copy_buffer_to_image(const SBufferInfo& buffer, const CImage* image, uint32 mip) noexcept {
         AM_PROFILE_SCOPED();
         VkBufferImageCopy region = {};
@@ -279,91 +597,53 @@ namespace am {
 
     CCommandBuffer& CCommandBuffer::barrier(const SBufferMemoryBarrier& info) noexcept {
         AM_PROFILE_SCOPED();
-        VkBufferMemoryBarrier barrier = {};
-        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-        barrier.srcAccessMask = prv::as_vulkan(info.source_access);
-        barrier.dstAccessMask = prv::as_vulkan(info.dest_access);
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.buffer = info.buffer.handle;
-        barrier.offset = info.buffer.offset;
-        barrier.size = info.buffer.size;
-        vkCmdPipelineBarrier(
-            _handle,
-            prv::as_vulkan(info.source_stage),
-            prv::as_vulkan(info.dest_stage),
-            VK_DEPENDENCY_BY_REGION_BIT,
-            0, nullptr,
-            1, &barrier,
-            0, nullptr);
-        return *this;
+        _barriers.buffer(info);
+        return barrier(_barriers);
     }
 
     CCommandBuffer& CCommandBuffer::barrier(const SImageMemoryBarrier& info) noexcept {
         AM_PROFILE_SCOPED();
-        VkImageMemoryBarrier barrier = {};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.srcAccessMask = prv::as_vulkan(info.source_access);
-        barrier.dstAccessMask = prv::as_vulkan(info.dest_access);
-        barrier.oldLayout = prv::as_vulkan(info.old_layout);
-        barrier.newLayout = prv::as_vulkan(info.new_layout);
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = info.image->native();
-        barrier.subresourceRange.aspectMask = info.image->aspect();
-        AM_UNLIKELY_IF(info.mip == all_mips) {
-            barrier.subresourceRange.baseMipLevel = 0;
-            barrier.subresourceRange.levelCount = info.image->mips();
-        } else {
-            barrier.subresourceRange.baseMipLevel = info.mip;
-            barrier.subresourceRange.levelCount = 1;
-        }
-        AM_UNLIKELY_IF(info.layer == all_layers) {
-            barrier.subresourceRange.baseArrayLayer = 0;
-            barrier.subresourceRange.layerCount = info.image->layers();
-        } else {
-            barrier.subresourceRange.baseArrayLayer = info.layer;
-            barrier.subresourceRange.layerCount = 1;
-        }
-        vkCmdPipelineBarrier(
-            _handle,
-            prv::as_vulkan(info.source_stage),
-            prv::as_vulkan(info.dest_stage),
-            VK_DEPENDENCY_BY_REGION_BIT,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier);
-        return *this;
+        _barriers.image(info);
+        return barrier(_barriers);
     }
 
     CCommandBuffer& CCommandBuffer::barrier(EPipelineStage source_stage, EPipelineStage dest_stage) noexcept {
         AM_PROFILE_SCOPED();
-        vkCmdPipelineBarrier(
-            _handle,
-            prv::as_vulkan(source_stage),
-            prv::as_vulkan(dest_stage),
-            VK_DEPENDENCY_BY_REGION_BIT,
-            0, nullptr,
-            0, nullptr,
-            0, nullptr);
+        _barriers.memory({
+            .source_stage = source_stage,
+            .dest_stage = dest_stage
+        });
+        return barrier(_barriers);
+    }
+
+    CCommandBuffer& CCommandBuffer::barrier(CBarrierBatch& batch) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(batch.empty()) {
+            return *this;
+        }
+        AM_UNLIKELY_IF(!_device->feature_support(EDeviceFeature::Synchronization2)) {
+            batch._flush_legacy(_handle);
+            batch.clear();
+            return *this;
+        }
+        VkDependencyInfo dependency = {};
+        dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+        dependency.memoryBarrierCount = (uint32)batch._memory.size();
+        dependency.pMemoryBarriers = batch._memory.data();
+        dependency.bufferMemoryBarrierCount = (uint32)batch._buffers.size();
+        dependency.pBufferMemoryBarriers = batch._buffers.data();
+        dependency.imageMemoryBarrierCount = (uint32)batch._images.size();
+        dependency.pImageMemoryBarriers = batch._images.data();
+        vkCmdPipelineBarrier2(_handle, &dependency);
+        batch.clear();
         return *this;
     }
 
     CCommandBuffer& CCommandBuffer::memory_barrier(const SMemoryBarrier& info) noexcept {
         AM_PROFILE_SCOPED();
-        VkMemoryBarrier barrier = {};
-        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-        barrier.srcAccessMask = prv::as_vulkan(info.source_access);
-        barrier.dstAccessMask = prv::as_vulkan(info.dest_access);
-        vkCmdPipelineBarrier(
-            _handle,
-            prv::as_vulkan(info.source_stage),
-            prv::as_vulkan(info.dest_stage),
-            VK_DEPENDENCY_BY_REGION_BIT,
-            1, &barrier,
-            0, nullptr,
-            0, nullptr);
-        return *this;
+        _barriers.memory(info);
+        return barrier(_barriers);
     }
 
     CCommandBuffer& CCommandBuffer::copy_image(const CImage* source, const CImage* dest) noexcept {
@@ -422,99 +702,20 @@ namespace am {
 
     CCommandBuffer& CCommandBuffer::transfer_ownership(const CQueue& source, const CQueue& dest, const SBufferMemoryBarrier& info) noexcept {
         AM_PROFILE_SCOPED();
-        VkBufferMemoryBarrier barrier = {};
-        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-        barrier.pNext = nullptr;
-        barrier.srcAccessMask = prv::as_vulkan(info.source_access);
-        barrier.dstAccessMask = prv::as_vulkan(info.dest_access);
-        barrier.srcQueueFamilyIndex = source.family();
-        barrier.dstQueueFamilyIndex = dest.family();
-        barrier.buffer = info.buffer.handle;
-        barrier.offset = info.buffer.offset;
-        barrier.size = info.buffer.size;
-        vkCmdPipelineBarrier(
-            _handle,
-            prv::as_vulkan(info.source_stage),
-            prv::as_vulkan(info.dest_stage),
-            VK_DEPENDENCY_BY_REGION_BIT,
-            0, nullptr,
-            1, &barrier,
-            0, nullptr);
-        return *this;
+        _barriers.transfer_ownership(source, dest, info);
+        return barrier(_barriers);
     }
 
     CCommandBuffer& CCommandBuffer::transfer_ownership(const CQueue& source, const CQueue& dest, const SImageMemoryBarrier& info) noexcept {
         AM_PROFILE_SCOPED();
-        VkImageMemoryBarrier barrier = {};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.srcAccessMask = prv::as_vulkan(info.source_access);
-        barrier.dstAccessMask = prv::as_vulkan(info.dest_access);
-        barrier.oldLayout = prv::as_vulkan(info.old_layout);
-        barrier.newLayout = prv::as_vulkan(info.new_layout);
-        barrier.srcQueueFamilyIndex = source.family();
-        barrier.dstQueueFamilyIndex = dest.family();
-        barrier.image = info.image->native();
-        barrier.subresourceRange.aspectMask = info.image->aspect();
-        AM_UNLIKELY_IF(info.mip == all_mips) {
-            barrier.subresourceRange.baseMipLevel = 0;
-            barrier.subresourceRange.levelCount = info.image->mips();
-        } else {
-            barrier.subresourceRange.baseMipLevel = info.mip;
-            barrier.subresourceRange.levelCount = 1;
-        }
-        AM_UNLIKELY_IF(info.layer == all_layers) {
-            barrier.subresourceRange.baseArrayLayer = 0;
-            barrier.subresourceRange.layerCount = info.image->layers();
-        } else {
-            barrier.subresourceRange.baseArrayLayer = info.layer;
-            barrier.subresourceRange.layerCount = 1;
-        }
-        vkCmdPipelineBarrier(
-            _handle,
-            prv::as_vulkan(info.source_stage),
-            prv::as_vulkan(info.dest_stage),
-            VK_DEPENDENCY_BY_REGION_BIT,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier);
-        return *this;
+        _barriers.transfer_ownership(source, dest, info);
+        return barrier(_barriers);
     }
 
     CCommandBuffer& CCommandBuffer::transition_layout(const SImageMemoryBarrier& info) noexcept {
         AM_PROFILE_SCOPED();
-        VkImageMemoryBarrier barrier = {};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.srcAccessMask = prv::as_vulkan(info.source_access);
-        barrier.dstAccessMask = prv::as_vulkan(info.dest_access);
-        barrier.oldLayout = prv::as_vulkan(info.old_layout);
-        barrier.newLayout = prv::as_vulkan(info.new_layout);
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = info.image->native();
-        barrier.subresourceRange.aspectMask = info.image->aspect();
-        AM_UNLIKELY_IF(info.mip == all_mips) {
-            barrier.subresourceRange.baseMipLevel = 0;
-            barrier.subresourceRange.levelCount = info.image->mips();
-        } else {
-            barrier.subresourceRange.baseMipLevel = info.mip;
-            barrier.subresourceRange.levelCount = 1;
-        }
-        AM_UNLIKELY_IF(info.layer == all_layers) {
-            barrier.subresourceRange.baseArrayLayer = 0;
-            barrier.subresourceRange.layerCount = info.image->layers();
-        } else {
-            barrier.subresourceRange.baseArrayLayer = info.layer;
-            barrier.subresourceRange.layerCount = 1;
-        }
-        vkCmdPipelineBarrier(
-            _handle,
-            prv::as_vulkan(info.source_stage),
-            prv::as_vulkan(info.dest_stage),
-            VK_DEPENDENCY_BY_REGION_BIT,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier);
-        return *this;
+        _barriers.image(info);
+        return barrier(_barriers);
     }
 
     CCommandBuffer& CCommandBuffer::set_checkpoint(const char* name) noexcept {
@@ -542,6 +743,123 @@ namespace am {
         return *this;
     }
 
+    CCommandBuffer& CCommandBuffer::begin_zone(const char* name) noexcept {
+        AM_PROFILE_SCOPED();
+        auto* profiler = _device->gpu_profiler();
+        const auto query = profiler->begin_zone(_queue, name, (uint32)_zones.size());
+        _zones.emplace_back(query);
+        AM_UNLIKELY_IF(query == CGpuProfiler::invalid_zone) {
+            return *this;
+        }
+        AM_LIKELY_IF(_device->feature_support(EDeviceFeature::Synchronization2)) {
+            vkCmdWriteTimestamp2(_handle, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, profiler->native(), query);
+        } else {
+            vkCmdWriteTimestamp(_handle, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, profiler->native(), query);
+        }
+        return *this;
+    }
+
+    CCommandBuffer& CCommandBuffer::end_zone() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_ASSERT(!_zones.empty(), "end_zone() without a matching begin_zone()");
+        const auto query = _zones.back();
+        _zones.pop_back();
+        AM_UNLIKELY_IF(query == CGpuProfiler::invalid_zone) {
+            return *this;
+        }
+        auto* profiler = _device->gpu_profiler();
+        AM_LIKELY_IF(_device->feature_support(EDeviceFeature::Synchronization2)) {
+            vkCmdWriteTimestamp2(_handle, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, profiler->native(), query + 1);
+        } else {
+            vkCmdWriteTimestamp(_handle, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, profiler->native(), query + 1);
+        }
+        return *this;
+    }
+
+    CCommandBuffer& CCommandBuffer::invalidate_state() noexcept {
+        AM_PROFILE_SCOPED();
+        _bound = {};
+        return *this;
+    }
+
+    AM_NODISCARD uint32 CCommandBuffer::elided_calls() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _elided_calls;
+    }
+
+    CCommandBuffer& CCommandBuffer::_begin_rendering(VkRenderingFlags flags) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto* pass = _active_render_pass;
+        const auto* framebuffer = _active_framebuffer;
+        // Initial layouts and the incoming external dependency of the pass
+        const auto& dependency = pass->begin_dependency();
+        for (const auto& attachment : pass->rendering_attachments()) {
+            _barriers.image({
+                .image = framebuffer->image(attachment.index),
+                .source_stage = dependency.source_stage,
+                .dest_stage = dependency.dest_stage,
+                .source_access = dependency.source_access,
+                .dest_access = dependency.dest_access,
+                .old_layout = pass->attachment(attachment.index).layout.initial,
+                .new_layout = attachment.layout
+            });
+        }
+        barrier(_barriers);
+
+        const auto clears = framebuffer->clears();
+        // "CRenderPass" only makes passes dynamic up to "max_color_attachments"
+        std::array<VkRenderingAttachmentInfo, max_color_attachments> colors;
+        uint32 color_count = 0;
+        VkRenderingAttachmentInfo depth = {};
+        VkRenderingAttachmentInfo stencil = {};
+        uint32 layers = 1;
+        for (const auto& attachment : pass->rendering_attachments()) {
+            const auto* image = framebuffer->image(attachment.index);
+            VkRenderingAttachmentInfo info = {};
+            info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            info.imageView = image->view();
+            info.imageLayout = prv::as_vulkan(attachment.layout);
+            info.resolveMode = VK_RESOLVE_MODE_NONE;
+            info.loadOp = attachment.load;
+            info.storeOp = attachment.store;
+            info.clearValue = clears[attachment.index];
+            layers = image->layers();
+            AM_UNLIKELY_IF(attachment.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) {
+                depth = info;
+                AM_UNLIKELY_IF(attachment.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) {
+                    stencil = info;
+                    stencil.loadOp = attachment.stencil_load;
+                    stencil.storeOp = attachment.stencil_store;
+                }
+            } else {
+                colors[color_count++] = info;
+            }
+        }
+        VkRenderingInfo rendering_info = {};
+        rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        rendering_info.flags = flags;
+        rendering_info.renderArea = { {}, framebuffer->viewport() };
+        rendering_info.layerCount = layers;
+        rendering_info.viewMask = 0;
+        rendering_info.colorAttachmentCount = color_count;
+        rendering_info.pColorAttachments = colors.data();
+        rendering_info.pDepthAttachment = depth.imageView ? &depth : nullptr;
+        rendering_info.pStencilAttachment = stencil.imageView ? &stencil : nullptr;
+        vkCmdBeginRendering(_handle, &rendering_info);
+        return *this;
+    }
+
+    void CCommandBuffer::_set_viewport(const VkViewport& viewport) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(_bound.has_viewport && std::memcmp(&_bound.viewport, &viewport, sizeof viewport) == 0) {
+            _elided_calls++;
+            return;
+        }
+        _bound.viewport = viewport;
+        _bound.has_viewport = true;
+        vkCmdSetViewport(_handle, 0, 1, &viewport);
+    }
+
     AM_NODISCARD VkCommandBuffer CCommandBuffer::native() const noexcept {
         AM_PROFILE_SCOPED();
         return _handle;
@@ -551,4 +869,196 @@ namespace am {
         AM_PROFILE_SCOPED();
         return _pool;
     }
+
+    CBarrierBatch& CBarrierBatch::memory(const SMemoryBarrier& info) noexcept {
+        AM_PROFILE_SCOPED();
+        // A single global barrier covers every memory dependency of the batch
+        AM_UNLIKELY_IF(_memory.empty()) {
+            auto& barrier = _memory.emplace_back();
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        }
+        auto& barrier = _memory.front();
+        barrier.srcStageMask |= prv::as_vulkan(info.source_stage);
+        barrier.srcAccessMask |= prv::as_vulkan(info.source_access);
+        barrier.dstStageMask |= prv::as_vulkan(info.dest_stage);
+        barrier.dstAccessMask |= prv::as_vulkan(info.dest_access);
+        return *this;
+    }
+
+    CBarrierBatch& CBarrierBatch::buffer(const SBufferMemoryBarrier& info) noexcept {
+        AM_PROFILE_SCOPED();
+        _buffer(info, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+        return *this;
+    }
+
+    CBarrierBatch& CBarrierBatch::image(const SImageMemoryBarrier& info) noexcept {
+        AM_PROFILE_SCOPED();
+        _image(info, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+        return *this;
+    }
+
+    CBarrierBatch& CBarrierBatch::transfer_ownership(const CQueue& source, const CQueue& dest, const SBufferMemoryBarrier& info) noexcept {
+        AM_PROFILE_SCOPED();
+        _buffer(info, source.family(), dest.family());
+        return *this;
+    }
+
+    CBarrierBatch& CBarrierBatch::transfer_ownership(const CQueue& source, const CQueue& dest, const SImageMemoryBarrier& info) noexcept {
+        AM_PROFILE_SCOPED();
+        _image(info, source.family(), dest.family());
+        return *this;
+    }
+
+    AM_NODISCARD bool CBarrierBatch::empty() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _memory.empty() && _buffers.empty() && _images.empty();
+    }
+
+    AM_NODISCARD uint32 CBarrierBatch::size() const noexcept {
+        AM_PROFILE_SCOPED();
+        return (uint32)(_memory.size() + _buffers.size() + _images.size());
+    }
+
+    void CBarrierBatch::clear() noexcept {
+        AM_PROFILE_SCOPED();
+        _memory.clear();
+        _buffers.clear();
+        _images.clear();
+    }
+
+    void CBarrierBatch::_buffer(const SBufferMemoryBarrier& info, uint32 source_family, uint32 dest_family) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto range_end = [](VkDeviceSize offset, VkDeviceSize size) noexcept {
+            return size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : offset + size;
+        };
+        // Release and acquire must describe the same range, ownership transfers are only merged when identical
+        const auto exact = source_family != dest_family;
+        const auto end = range_end(info.buffer.offset, info.buffer.size);
+        for (auto& barrier : _buffers) {
+            AM_LIKELY_IF(
+                barrier.buffer != info.buffer.handle ||
+                barrier.srcQueueFamilyIndex != source_family ||
+                barrier.dstQueueFamilyIndex != dest_family) {
+                continue;
+            }
+            const auto barrier_end = range_end(barrier.offset, barrier.size);
+            AM_UNLIKELY_IF(exact && (barrier.offset != info.buffer.offset || barrier.size != info.buffer.size)) {
+                continue;
+            }
+            // Overlapping or adjacent ranges become one
+            AM_UNLIKELY_IF(info.buffer.offset > barrier_end || barrier.offset > end) {
+                continue;
+            }
+            const auto merged_end = std::max(end, barrier_end);
+            barrier.offset = std::min(barrier.offset, info.buffer.offset);
+            barrier.size = merged_end == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : merged_end - barrier.offset;
+            barrier.srcStageMask |= prv::as_vulkan(info.source_stage);
+            barrier.srcAccessMask |= prv::as_vulkan(info.source_access);
+            barrier.dstStageMask |= prv::as_vulkan(info.dest_stage);
+            barrier.dstAccessMask |= prv::as_vulkan(info.dest_access);
+            return;
+        }
+        auto& barrier = _buffers.emplace_back();
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+        barrier.srcStageMask = prv::as_vulkan(info.source_stage);
+        barrier.srcAccessMask = prv::as_vulkan(info.source_access);
+        barrier.dstStageMask = prv::as_vulkan(info.dest_stage);
+        barrier.dstAccessMask = prv::as_vulkan(info.dest_access);
+        barrier.srcQueueFamilyIndex = source_family;
+        barrier.dstQueueFamilyIndex = dest_family;
+        barrier.buffer = info.buffer.handle;
+        barrier.offset = info.buffer.offset;
+        barrier.size = info.buffer.size;
+    }
+
+    void CBarrierBatch::_image(const SImageMemoryBarrier& info, uint32 source_family, uint32 dest_family) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto range = make_subresource_range(info);
+        const auto old_layout = prv::as_vulkan(info.old_layout);
+        const auto new_layout = prv::as_vulkan(info.new_layout);
+        for (auto& barrier : _images) {
+            const auto& other = barrier.subresourceRange;
+            AM_LIKELY_IF(
+                barrier.image != info.image->native() ||
+                barrier.oldLayout != old_layout ||
+                barrier.newLayout != new_layout ||
+                barrier.srcQueueFamilyIndex != source_family ||
+                barrier.dstQueueFamilyIndex != dest_family ||
+                other.baseMipLevel != range.baseMipLevel ||
+                other.levelCount != range.levelCount ||
+                other.baseArrayLayer != range.baseArrayLayer ||
+                other.layerCount != range.layerCount) {
+                continue;
+            }
+            barrier.srcStageMask |= prv::as_vulkan(info.source_stage);
+            barrier.srcAccessMask |= prv::as_vulkan(info.source_access);
+            barrier.dstStageMask |= prv::as_vulkan(info.dest_stage);
+            barrier.dstAccessMask |= prv::as_vulkan(info.dest_access);
+            return;
+        }
+        auto& barrier = _images.emplace_back();
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        barrier.srcStageMask = prv::as_vulkan(info.source_stage);
+        barrier.srcAccessMask = prv::as_vulkan(info.source_access);
+        barrier.dstStageMask = prv::as_vulkan(info.dest_stage);
+        barrier.dstAccessMask = prv::as_vulkan(info.dest_access);
+        barrier.oldLayout = old_layout;
+        barrier.newLayout = new_layout;
+        barrier.srcQueueFamilyIndex = source_family;
+        barrier.dstQueueFamilyIndex = dest_family;
+        barrier.image = info.image->native();
+        barrier.subresourceRange = range;
+    }
+
+    void CBarrierBatch::_flush_legacy(VkCommandBuffer commands) noexcept {
+        AM_PROFILE_SCOPED();
+        // Per-barrier stages don't exist without synchronization2, every stage is merged instead
+        VkPipelineStageFlags source_stage = 0;
+        VkPipelineStageFlags dest_stage = 0;
+        VkMemoryBarrier memory = {};
+        memory.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        for (const auto& barrier : _memory) {
+            memory.srcAccessMask |= as_legacy_access(barrier.srcAccessMask);
+            memory.dstAccessMask |= as_legacy_access(barrier.dstAccessMask);
+            source_stage |= as_legacy_stages(barrier.srcStageMask);
+            dest_stage |= as_legacy_stages(barrier.dstStageMask);
+        }
+        _legacy_buffers.clear();
+        for (const auto& barrier : _buffers) {
+            auto& legacy = _legacy_buffers.emplace_back();
+            legacy.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            legacy.srcAccessMask = as_legacy_access(barrier.srcAccessMask);
+            legacy.dstAccessMask = as_legacy_access(barrier.dstAccessMask);
+            legacy.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+            legacy.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+            legacy.buffer = barrier.buffer;
+            legacy.offset = barrier.offset;
+            legacy.size = barrier.size;
+            source_stage |= as_legacy_stages(barrier.srcStageMask);
+            dest_stage |= as_legacy_stages(barrier.dstStageMask);
+        }
+        _legacy_images.clear();
+        for (const auto& barrier : _images) {
+            auto& legacy = _legacy_images.emplace_back();
+            legacy.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            legacy.srcAccessMask = as_legacy_access(barrier.srcAccessMask);
+            legacy.dstAccessMask = as_legacy_access(barrier.dstAccessMask);
+            legacy.oldLayout = barrier.oldLayout;
+            legacy.newLayout = barrier.newLayout;
+            legacy.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+            legacy.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+            legacy.image = barrier.image;
+            legacy.subresourceRange = barrier.subresourceRange;
+            source_stage |= as_legacy_stages(barrier.srcStageMask);
+            dest_stage |= as_legacy_stages(barrier.dstStageMask);
+        }
+        vkCmdPipelineBarrier(
+            commands,
+            source_stage ? source_stage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            dest_stage ? dest_stage : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            VK_DEPENDENCY_BY_REGION_BIT,
+            _memory.empty() ? 0 : 1, &memory,
+            (uint32)_legacy_buffers.size(), _legacy_buffers.data(),
+            (uint32)_legacy_images.size(), _legacy_images.data());
+    }
 } // namespace am
@@ -0,0 +1,134 @@
+#include <amethyst/graphics/completion_poller.hpp>
+#include <amethyst/graphics/context.hpp>
+#include <amethyst/graphics/device.hpp>
+#include <amethyst/graphics/queue.hpp>
+
+#include <TaskScheduler.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace am {
+    struct CCompletionPoller::SContinuationTask : enki::IPinnedTask {
+        SContinuationTask(uint32 thread, Continuation&& continuation) noexcept
+            : enki::IPinnedTask(thread),
+              func(std::move(continuation)) {}
+
+        void Execute() override {
+            AM_PROFILE_NAMED_SCOPE("completion poller: continuation");
+            func();
+            // Captures are released here as well, not on the poller thread
+            func = nullptr;
+        }
+
+        Continuation func;
+    };
+
+    CCompletionPoller::CCompletionPoller() noexcept = default;
+
+    CCompletionPoller::~CCompletionPoller() noexcept {
+        AM_PROFILE_SCOPED();
+        _thread.request_stop();
+        _signal.notify_all();
+        _thread.join();
+    }
+
+    AM_NODISCARD std::unique_ptr<CCompletionPoller> CCompletionPoller::make(CDevice* device) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = std::unique_ptr<Self>(new Self());
+        result->_device = device;
+        result->_thread = std::jthread([poller = result.get()](std::stop_token token) noexcept {
+            poller->_run(std::move(token));
+        });
+        return result;
+    }
+
+    void CCompletionPoller::enqueue(const CQueue* queue, uint64 value, uint32 thread, Continuation&& func) noexcept {
+        AM_PROFILE_SCOPED();
+        {
+            std::lock_guard lock(_lock);
+            _incoming.push_back({
+                .queue = queue,
+                .value = value,
+                .func = std::move(func),
+                .thread = thread,
+                .start = Clock::now()
+            });
+        }
+        _pending++;
+        _signal.notify_one();
+    }
+
+    AM_NODISCARD SCompletionStats CCompletionPoller::stats() const noexcept {
+        AM_PROFILE_SCOPED();
+        return {
+            .pending = _pending.load(std::memory_order_relaxed),
+            .completed = _completed.load(std::memory_order_relaxed),
+            .wait_time = (float64)_wait_time.load(std::memory_order_relaxed) / 1'000'000'000.0
+        };
+    }
+
+    void CCompletionPoller::_run(std::stop_token token) noexcept {
+        AM_PROFILE_SCOPED();
+        auto* scheduler = _device->context()->scheduler();
+        std::vector<SPendingWork> active;
+        std::vector<VkSemaphore> handles;
+        std::vector<uint64> values;
+        while (true) {
+            std::erase_if(_running, [](const auto& task) noexcept {
+                return task->GetIsComplete();
+            });
+            {
+                std::unique_lock lock(_lock);
+                AM_LIKELY_IF(active.empty() && _running.empty()) {
+                    _signal.wait(lock, token, [this]() noexcept {
+                        return !_incoming.empty();
+                    });
+                }
+                std::move(_incoming.begin(), _incoming.end(), std::back_inserter(active));
+                _incoming.clear();
+            }
+            // Outstanding work is always retired, resources waiting on it would otherwise never be released
+            AM_UNLIKELY_IF(active.empty() && _running.empty() && token.stop_requested()) {
+                break;
+            }
+            AM_UNLIKELY_IF(active.empty()) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            handles.clear();
+            values.clear();
+            for (const auto& each : active) {
+                handles.emplace_back(each.queue->timeline());
+                values.emplace_back(each.value);
+            }
+            VkSemaphoreWaitInfo wait_info = {};
+            wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            wait_info.flags = VK_SEMAPHORE_WAIT_ANY_BIT;
+            wait_info.semaphoreCount = (uint32)handles.size();
+            wait_info.pSemaphores = handles.data();
+            wait_info.pValues = values.data();
+            constexpr auto timeout = 1'000'000; // 1ms, new work is picked up at this granularity
+            const auto status = vkWaitSemaphores(_device->native(), &wait_info, timeout);
+            AM_UNLIKELY_IF(status == VK_TIMEOUT) {
+                continue;
+            }
+            AM_VULKAN_CHECK(_device->logger(), status);
+            const auto now = Clock::now();
+            for (uint32 i = 0; i < active.size();) {
+                AM_LIKELY_IF(!active[i].queue->is_complete(active[i].value)) {
+                    ++i;
+                    continue;
+                }
+                auto work = std::move(active[i]);
+                active[i] = std::move(active.back());
+                active.pop_back();
+                auto& task = _running.emplace_back(std::make_unique<SContinuationTask>(work.thread, std::move(work.func)));
+                scheduler->AddPinnedTask(task.get());
+                _wait_time += std::chrono::duration_cast<std::chrono::nanoseconds>(now - work.start).count();
+                _completed++;
+                _pending--;
+            }
+        }
+    }
+} // namespace am
@@ -8,6 +8,18 @@
 #include <algorithm>
 
 namespace am {
+    AM_NODISCARD static inline bool is_buffer_descriptor(VkDescriptorType type) noexcept {
+        switch (type) {
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+                return true;
+            default: break;
+        }
+        return false;
+    }
+
     CDescriptorSet::CDescriptorSet() noexcept = default;
 
     CDescriptorSet::~CDescriptorSet() noexcept {
@@ -34,12 +46,12 @@ namespace am {
         }
 
         AM_VULKAN_CHECK(device->logger(), vkAllocateDescriptorSets(device->native(), &allocate_info, &result->_handle));
-        result->_cache.reserve(1024);
         result->_index = info.index;
         result->_native_pool = allocate_info.descriptorPool;
         result->_pipeline = std::move(info.pipeline);
         result->_pool = std::move(info.pool);
         result->_device = std::move(device);
+        result->_make_slots(result->_pipeline->set_bindings(result->_index), layout.update_template);
         return CRcPtr<Self>::make(result);
     }
 
@@ -71,12 +83,12 @@ namespace am {
         }
 
         AM_VULKAN_CHECK(device->logger(), vkAllocateDescriptorSets(device->native(), &allocate_info, &result->_handle));
-        result->_cache.reserve(1024);
         result->_index = info.index;
         result->_native_pool = allocate_info.descriptorPool;
         result->_pipeline = nullptr;
         result->_pool = std::move(info.pool);
         result->_device = std::move(device);
+        result->_make_slots(info.bindings, {});
         return CRcPtr<Self>::make(result);
     }
 
@@ -100,283 +112,369 @@ namespace am {
         return _index;
     }
 
-    CDescriptorSet& CDescriptorSet::bind(const std::string& name, SBufferInfo info, uint32 offset) noexcept {
+    AM_NODISCARD SBindingHandle CDescriptorSet::handle(const std::string& name) const noexcept {
         AM_PROFILE_SCOPED();
-        const auto* binding = _pipeline->bindings(name);
-        AM_UNLIKELY_IF(!binding) {
+        AM_UNLIKELY_IF(!_pipeline) {
+            AM_LOG_ERROR(_device->logger(), "raw descriptor set has no named bindings: {}", name);
+            return {};
+        }
+        return _pipeline->binding_handle(name);
+    }
+
+    AM_NODISCARD SBindingHandle CDescriptorSet::handle(uint32 binding) const noexcept {
+        AM_PROFILE_SCOPED();
+        return { _index, binding };
+    }
+
+    CDescriptorSet& CDescriptorSet::bind(SBindingHandle handle, SBufferInfo info, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto* binding = _binding(handle);
+        AM_UNLIKELY_IF(!binding || _is_cached(*binding, prv::hash(offset, info))) {
             return *this;
         }
-        const auto binding_hash = prv::hash(0, binding);
-        const auto descriptor_hash = prv::hash(0, info);
-        const auto is_bound = std::find_if(_cache.begin(), _cache.end(), [=](const auto& each) {
-            return each.binding_hash == binding_hash;
-        });
-        const auto found_binding = is_bound != _cache.end();
-        AM_UNLIKELY_IF(!found_binding || is_bound->descriptor_hash != descriptor_hash) {
+        VkDescriptorBufferInfo descriptor = {};
+        descriptor.buffer = info.handle;
+        descriptor.offset = info.offset;
+        descriptor.range = info.size;
+        _write(*binding, offset, &descriptor, 1);
+        return *this;
+    }
+
+    CDescriptorSet& CDescriptorSet::bind(SBindingHandle handle, const std::vector<SBufferInfo>& buffers, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto* binding = _binding(handle);
+        AM_UNLIKELY_IF(!binding || _is_cached(*binding, prv::hash(offset, buffers))) {
+            return *this;
+        }
+        AM_LOG_WARN(_device->logger(), "updating dynamic buffer descriptor: size: {}", buffers.size());
+        std::vector<VkDescriptorBufferInfo> descriptors;
+        descriptors.reserve(buffers.size());
+        for (const auto& buffer : buffers) {
             VkDescriptorBufferInfo descriptor = {};
-            descriptor.buffer = info.handle;
-            descriptor.offset = info.offset;
-            descriptor.range = info.size;
-            VkWriteDescriptorSet update = {};
-            update.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            update.dstSet = _handle;
-            update.dstBinding = binding->index;
-            update.dstArrayElement = offset;
-            update.descriptorCount = 1;
-            update.descriptorType = binding->type;
-            update.pBufferInfo = &descriptor;
-            vkUpdateDescriptorSets(_device->native(), 1, &update, 0, nullptr);
-            AM_LIKELY_IF(!found_binding) {
-                _cache.push_back({ binding_hash, descriptor_hash });
-            } else {
-                is_bound->descriptor_hash = descriptor_hash;
-            }
+            descriptor.buffer = buffer.handle;
+            descriptor.offset = buffer.offset;
+            descriptor.range = buffer.size;
+            descriptors.emplace_back(descriptor);
         }
+        _write(*binding, offset, descriptors.data(), (uint32)descriptors.size());
         return *this;
     }
 
-    CDescriptorSet& CDescriptorSet::bind(const std::string& name, const std::vector<SBufferInfo>& buffers, uint32 offset) noexcept {
+    CDescriptorSet& CDescriptorSet::bind(SBindingHandle handle, const CImage* image, uint32 offset) noexcept {
         AM_PROFILE_SCOPED();
-        const auto* binding = _pipeline->bindings(name);
-        AM_UNLIKELY_IF(!binding) {
+        const auto* binding = _binding(handle);
+        AM_UNLIKELY_IF(!binding || _is_cached(*binding, prv::hash(offset, image))) {
             return *this;
         }
-        const auto binding_hash = prv::hash(0, binding);
-        const auto descriptor_hash = prv::hash(0, buffers);
-        const auto is_bound = std::find_if(_cache.begin(), _cache.end(), [=](const auto& each) {
-            return each.binding_hash == binding_hash;
-        });
-        const auto found_binding = is_bound != _cache.end();
-        AM_UNLIKELY_IF(!found_binding || is_bound->descriptor_hash != descriptor_hash) {
-            AM_LOG_WARN(_device->logger(), "updating dynamic buffer descriptor: size: {}", buffers.size());
-            std::vector<VkDescriptorBufferInfo> descriptors;
-            descriptors.reserve(descriptors.size());
-            for (const auto& buffer : buffers) {
-                VkDescriptorBufferInfo descriptor = {};
-                descriptor.buffer = buffer.handle;
-                descriptor.offset = buffer.offset;
-                descriptor.range = buffer.size;
-                descriptors.emplace_back(descriptor);
-            }
-            VkWriteDescriptorSet update = {};
-            update.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            update.dstSet = _handle;
-            update.dstBinding = binding->index;
-            update.dstArrayElement = offset;
-            update.descriptorCount = (uint32)descriptors.size();
-            update.descriptorType = binding->type;
-            update.pBufferInfo = descriptors.data();
-            vkUpdateDescriptorSets(_device->native(), 1, &update, 0, nullptr);
-            AM_LIKELY_IF(!found_binding) {
-                _cache.push_back({ binding_hash, descriptor_hash });
-            } else {
-                is_bound->descriptor_hash = descriptor_hash;
-            }
+        VkDescriptorImageInfo descriptor = {};
+        descriptor.sampler = nullptr;
+        descriptor.imageView = image->view();
+        descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        _write(*binding, offset, &descriptor, 1);
+        return *this;
+    }
+
+    CDescriptorSet& CDescriptorSet::bind(SBindingHandle handle, const CImageView* view, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto* binding = _binding(handle);
+        AM_UNLIKELY_IF(!binding || _is_cached(*binding, prv::hash(offset, view))) {
+            return *this;
         }
+        VkDescriptorImageInfo descriptor = {};
+        descriptor.sampler = nullptr;
+        descriptor.imageView = view->native();
+        descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        _write(*binding, offset, &descriptor, 1);
         return *this;
     }
 
-    CDescriptorSet& CDescriptorSet::bind(const std::string& name, const CImage* image, uint32 offset) noexcept {
+    CDescriptorSet& CDescriptorSet::bind(SBindingHandle handle, STextureInfo texture, uint32 offset) noexcept {
         AM_PROFILE_SCOPED();
-        const auto* binding = _pipeline->bindings(name);
+        const auto* binding = _binding(handle);
         AM_UNLIKELY_IF(!binding) {
             return *this;
         }
-        const auto binding_hash = prv::hash(0, binding);
-        const auto descriptor_hash = prv::hash(0, image);
-        const auto is_bound = std::find_if(_cache.begin(), _cache.end(), [=](const auto& each) {
-            return each.binding_hash == binding_hash;
-        });
-        const auto found_binding = is_bound != _cache.end();
-        AM_UNLIKELY_IF(!found_binding || is_bound->descriptor_hash != descriptor_hash) {
+        return bind(*binding, texture, offset);
+    }
+
+    CDescriptorSet& CDescriptorSet::bind(SBindingHandle handle, const std::vector<CRcPtr<CImageView>>& views, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto* binding = _binding(handle);
+        AM_UNLIKELY_IF(!binding || _is_cached(*binding, prv::hash(offset, views))) {
+            return *this;
+        }
+        AM_LOG_WARN(_device->logger(), "updating dynamic image descriptor: size: {}", views.size());
+        std::vector<VkDescriptorImageInfo> descriptors;
+        descriptors.reserve(views.size());
+        for (auto& view : views) {
             VkDescriptorImageInfo descriptor = {};
             descriptor.sampler = nullptr;
-            descriptor.imageView = image->view();
+            descriptor.imageView = view->native();
             descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-            VkWriteDescriptorSet update = {};
-            update.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            update.dstSet = _handle;
-            update.dstBinding = binding->index;
-            update.dstArrayElement = offset;
-            update.descriptorCount = 1;
-            update.descriptorType = binding->type;
-            update.pImageInfo = &descriptor;
-            vkUpdateDescriptorSets(_device->native(), 1, &update, 0, nullptr);
-            AM_LIKELY_IF(!found_binding) {
-                _cache.push_back({ binding_hash, descriptor_hash });
-            } else {
-                is_bound->descriptor_hash = descriptor_hash;
-            }
+            descriptors.emplace_back(descriptor);
         }
+        _write(*binding, offset, descriptors.data(), (uint32)descriptors.size());
         return *this;
     }
 
-    CDescriptorSet& CDescriptorSet::bind(const std::string& name, const CImageView* view, uint32 offset) noexcept {
+    CDescriptorSet& CDescriptorSet::bind(SBindingHandle handle, const std::vector<STextureInfo>& textures, uint32 offset) noexcept {
         AM_PROFILE_SCOPED();
-        const auto* binding = _pipeline->bindings(name);
-        AM_UNLIKELY_IF(!binding) {
+        const auto* binding = _binding(handle);
+        AM_UNLIKELY_IF(!binding || _is_cached(*binding, prv::hash(offset, textures))) {
             return *this;
         }
-        const auto binding_hash = prv::hash(0, binding);
-        const auto descriptor_hash = prv::hash(0, view);
-        const auto is_bound = std::find_if(_cache.begin(), _cache.end(), [=](const auto& each) {
-            return each.binding_hash == binding_hash;
-        });
-        const auto found_binding = is_bound != _cache.end();
-        AM_UNLIKELY_IF(!found_binding || is_bound->descriptor_hash != descriptor_hash) {
+        AM_LOG_WARN(_device->logger(), "updating dynamic texture descriptor: size: {}", textures.size());
+        std::vector<VkDescriptorImageInfo> descriptors;
+        descriptors.reserve(textures.size());
+        for (auto [view, sampler, layout] : textures) {
             VkDescriptorImageInfo descriptor = {};
-            descriptor.sampler = nullptr;
-            descriptor.imageView = view->native();
-            descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-            VkWriteDescriptorSet update = {};
-            update.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            update.dstSet = _handle;
-            update.dstBinding = binding->index;
-            update.dstArrayElement = offset;
-            update.descriptorCount = 1;
-            update.descriptorType = binding->type;
-            update.pImageInfo = &descriptor;
-            vkUpdateDescriptorSets(_device->native(), 1, &update, 0, nullptr);
-            AM_LIKELY_IF(!found_binding) {
-                _cache.push_back({ binding_hash, descriptor_hash });
-            } else {
-                is_bound->descriptor_hash = descriptor_hash;
-            }
+            descriptor.sampler = sampler;
+            descriptor.imageView = view;
+            descriptor.imageLayout = layout;
+            descriptors.emplace_back(descriptor);
         }
+        _write(*binding, offset, descriptors.data(), (uint32)descriptors.size());
         return *this;
     }
 
+    CDescriptorSet& CDescriptorSet::bind(const std::string& name, SBufferInfo info, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        return bind(handle(name), info, offset);
+    }
+
+    CDescriptorSet& CDescriptorSet::bind(const std::string& name, const std::vector<SBufferInfo>& buffers, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        return bind(handle(name), buffers, offset);
+    }
+
+    CDescriptorSet& CDescriptorSet::bind(const std::string& name, const CImage* image, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        return bind(handle(name), image, offset);
+    }
+
+    CDescriptorSet& CDescriptorSet::bind(const std::string& name, const CImageView* view, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        return bind(handle(name), view, offset);
+    }
+
     CDescriptorSet& CDescriptorSet::bind(const std::string& name, STextureInfo texture, uint32 offset) noexcept {
         AM_PROFILE_SCOPED();
-        const auto* binding = _pipeline->bindings(name);
-        AM_UNLIKELY_IF(!binding) {
-            return *this;
-        }
-        return bind(*binding, texture, offset);
+        return bind(handle(name), texture, offset);
     }
 
     CDescriptorSet& CDescriptorSet::bind(const std::string& name, const std::vector<CRcPtr<CImageView>>& views, uint32 offset) noexcept {
         AM_PROFILE_SCOPED();
-        const auto* binding = _pipeline->bindings(name);
-        AM_UNLIKELY_IF(!binding) {
+        return bind(handle(name), views, offset);
+    }
+
+    CDescriptorSet& CDescriptorSet::bind(const std::string& name, const std::vector<STextureInfo>& textures, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        return bind(handle(name), textures, offset);
+    }
+
+    CDescriptorSet& CDescriptorSet::bind(const SDescriptorBinding& binding, STextureInfo texture, uint32 offset) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(_is_cached(binding, prv::hash(offset, texture))) {
             return *this;
         }
-        const auto binding_hash = prv::hash(0, binding);
-        const auto descriptor_hash = prv::hash(0, views);
-        const auto is_bound = std::find_if(_cache.begin(), _cache.end(), [=](const auto& each) {
-            return each.binding_hash == binding_hash;
-        });
-        const auto found_binding = is_bound != _cache.end();
-        AM_UNLIKELY_IF(!found_binding || is_bound->descriptor_hash != descriptor_hash) {
-            AM_LOG_WARN(_device->logger(), "updating dynamic image descriptor: size: {}", views.size());
-            std::vector<VkDescriptorImageInfo> descriptors;
-            descriptors.reserve(descriptors.size());
-            for (auto& view : views) {
-                VkDescriptorImageInfo descriptor = {};
-                descriptor.sampler = nullptr;
-                descriptor.imageView = view->native();
-                descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-                descriptors.emplace_back(descriptor);
+        AM_LOG_WARN(_device->logger(), "updating texture descriptor: handle: {}", (const void*)texture.handle);
+        VkDescriptorImageInfo descriptor = {};
+        descriptor.sampler = texture.sampler;
+        descriptor.imageView = texture.handle;
+        descriptor.imageLayout = texture.layout;
+        _write(binding, offset, &descriptor, 1);
+        return *this;
+    }
+
+    uint32 CDescriptorSet::flush() noexcept {
+        AM_PROFILE_SCOPED();
+        uint32 writes = 0;
+        AM_UNLIKELY_IF(!_template._dirty.empty()) {
+            bool is_complete = true;
+            for (uint32 binding = 0; binding < _template._slots.size(); ++binding) {
+                AM_UNLIKELY_IF(_template._slots[binding] != SBindingHandle::invalid && !_cache[binding].is_bound) {
+                    is_complete = false;
+                    break;
+                }
             }
+            // A template rewrites every entry, it only pays off once each templated binding holds a descriptor and most
+            // of them changed. Otherwise only the changed ones are written
+            if (is_complete && _template._dirty.size() * 2 >= _template._data.size()) {
+                vkUpdateDescriptorSetWithTemplate(_device->native(), _handle, _template._handle, _template._data.data());
+                writes++;
+            } else {
+                for (const auto binding : _template._dirty) {
+                    const auto slot = binding < _template._slots.size() ? _template._slots[binding] : SBindingHandle::invalid;
+                    AM_UNLIKELY_IF(slot == SBindingHandle::invalid) {
+                        continue;
+                    }
+                    const auto type = _bindings[binding].type;
+                    AM_LIKELY_IF(is_buffer_descriptor(type)) {
+                        _queue(binding, 0, type, &_template._data[slot].buffer, 1);
+                    } else {
+                        _queue(binding, 0, type, &_template._data[slot].image, 1);
+                    }
+                }
+            }
+            _template._dirty.clear();
+        }
+        AM_LIKELY_IF(_pending.empty()) {
+            return writes;
+        }
+        _updates.clear();
+        _updates.reserve(_pending.size());
+        for (const auto& each : _pending) {
             VkWriteDescriptorSet update = {};
             update.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
             update.dstSet = _handle;
-            update.dstBinding = binding->index;
-            update.dstArrayElement = offset;
-            update.descriptorCount = (uint32)descriptors.size();
-            update.descriptorType = binding->type;
-            update.pImageInfo = descriptors.data();
-            vkUpdateDescriptorSets(_device->native(), 1, &update, 0, nullptr);
-            AM_LIKELY_IF(!found_binding) {
-                _cache.push_back({ binding_hash, descriptor_hash });
+            update.dstBinding = each.binding;
+            update.dstArrayElement = each.offset;
+            update.descriptorCount = each.count;
+            update.descriptorType = each.type;
+            AM_LIKELY_IF(is_buffer_descriptor(each.type)) {
+                update.pBufferInfo = &_pending_buffers[each.first];
             } else {
-                is_bound->descriptor_hash = descriptor_hash;
+                update.pImageInfo = &_pending_images[each.first];
             }
+            _updates.emplace_back(update);
         }
-        return *this;
+        vkUpdateDescriptorSets(_device->native(), (uint32)_updates.size(), _updates.data(), 0, nullptr);
+        writes += (uint32)_updates.size();
+        _pending.clear();
+        _pending_images.clear();
+        _pending_buffers.clear();
+        return writes;
     }
 
-    CDescriptorSet& CDescriptorSet::bind(const std::string& name, const std::vector<STextureInfo>& textures, uint32 offset) noexcept {
+    AM_NODISCARD bool CDescriptorSet::has_pending_writes() const noexcept {
         AM_PROFILE_SCOPED();
-        const auto* binding = _pipeline->bindings(name);
-        AM_UNLIKELY_IF(!binding) {
-            return *this;
+        return !_template._dirty.empty() || !_pending.empty();
+    }
+
+    void CDescriptorSet::update_pipeline(CRcPtr<CPipeline> pipeline) noexcept {
+        AM_PROFILE_SCOPED();
+        _pipeline = std::move(pipeline);
+        // The set keeps its descriptors, only the binding types may have changed
+        _make_slots(_pipeline->set_bindings(_index), _pipeline->set_layout(_index).update_template);
+    }
+
+    void CDescriptorSet::_make_slots(const std::vector<SDescriptorBinding>& bindings, VkDescriptorUpdateTemplate update_template) noexcept {
+        AM_PROFILE_SCOPED();
+        _bindings.clear();
+        for (const auto& binding : bindings) {
+            AM_UNLIKELY_IF(binding.index >= _bindings.size()) {
+                _bindings.resize(binding.index + 1);
+            }
+            _bindings[binding.index] = binding;
         }
-        const auto binding_hash = prv::hash(0, binding);
-        const auto descriptor_hash = prv::hash(0, textures);
-        const auto is_bound = std::find_if(_cache.begin(), _cache.end(), [=](const auto& each) {
-            return each.binding_hash == binding_hash;
-        });
-        const auto found_binding = is_bound != _cache.end();
-        AM_UNLIKELY_IF(!found_binding || is_bound->descriptor_hash != descriptor_hash) {
-            AM_LOG_WARN(_device->logger(), "updating dynamic texture descriptor: size: {}", textures.size());
-            std::vector<VkDescriptorImageInfo> descriptors;
-            descriptors.reserve(descriptors.size());
-            for (auto [handle, sampler, layout] : textures) {
-                VkDescriptorImageInfo descriptor = {};
-                descriptor.sampler = sampler;
-                descriptor.imageView = handle;
-                descriptor.imageLayout = layout;
-                descriptors.emplace_back(descriptor);
+        _cache.resize(std::max(_cache.size(), _bindings.size()));
+        // Entries follow the declaration order of the templated bindings, descriptors carry over to a reloaded pipeline
+        std::vector<uint32> slots(_bindings.size(), SBindingHandle::invalid);
+        std::vector<SDescriptorData> data;
+        for (const auto& binding : bindings) {
+            // Raw sets have no template, all their bindings are written one by one
+            AM_LIKELY_IF(update_template && binding.is_templated()) {
+                slots[binding.index] = (uint32)data.size();
+                const auto previous = binding.index < _template._slots.size() ?
+                    _template._slots[binding.index] :
+                    SBindingHandle::invalid;
+                data.emplace_back(previous != SBindingHandle::invalid ? _template._data[previous] : SDescriptorData());
             }
-            VkWriteDescriptorSet update = {};
-            update.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            update.dstSet = _handle;
-            update.dstBinding = binding->index;
-            update.dstArrayElement = offset;
-            update.descriptorCount = (uint32)descriptors.size();
-            update.descriptorType = binding->type;
-            update.pImageInfo = descriptors.data();
-            vkUpdateDescriptorSets(_device->native(), 1, &update, 0, nullptr);
-            AM_LIKELY_IF(!found_binding) {
-                _cache.push_back({ binding_hash, descriptor_hash });
-            } else {
-                is_bound->descriptor_hash = descriptor_hash;
+        }
+        _template._handle = update_template;
+        _template._slots = std::move(slots);
+        _template._data = std::move(data);
+    }
+
+    AM_NODISCARD const SDescriptorBinding* CDescriptorSet::_binding(SBindingHandle handle) const noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(!handle.is_valid()) {
+            return nullptr;
+        }
+        AM_ASSERT(handle.set == _index, "binding handle resolved for another descriptor set");
+        AM_UNLIKELY_IF(handle.set != _index || handle.index >= _bindings.size() || _bindings[handle.index].count == 0) {
+            return nullptr;
+        }
+        return &_bindings[handle.index];
+    }
+
+    AM_NODISCARD bool CDescriptorSet::_is_cached(const SDescriptorBinding& binding, uint64 hash) noexcept {
+        AM_PROFILE_SCOPED();
+        // Raw sets have no slots up front, they grow with the bindings written to
+        AM_UNLIKELY_IF(binding.index >= _cache.size()) {
+            _cache.resize(binding.index + 1);
+        }
+        auto& cached = _cache[binding.index];
+        AM_LIKELY_IF(cached.is_bound && cached.hash == hash) {
+            return true;
+        }
+        cached = { hash, true };
+        return false;
+    }
+
+    void CDescriptorSet::_write(const SDescriptorBinding& binding, uint32 offset, const VkDescriptorBufferInfo* descriptors, uint32 count) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(offset == 0 && count == 1 && binding.index < _template._slots.size()) {
+            const auto slot = _template._slots[binding.index];
+            AM_LIKELY_IF(slot != SBindingHandle::invalid) {
+                _template._data[slot].buffer = *descriptors;
+                _mark_dirty(binding.index);
+                return;
             }
         }
-        return *this;
+        _queue(binding.index, offset, binding.type, descriptors, count);
     }
 
-    CDescriptorSet& CDescriptorSet::bind(const SDescriptorBinding& binding, STextureInfo texture, uint32 offset) noexcept {
-        const auto binding_hash = prv::hash(0, binding);
-        const auto descriptor_hash = prv::hash(0, texture);
-        const auto is_bound = std::find_if(_cache.begin(), _cache.end(), [=](const auto& each) {
-            return each.binding_hash == binding_hash;
-        });
-        const auto found_binding = is_bound != _cache.end();
-        AM_UNLIKELY_IF(!found_binding || is_bound->descriptor_hash != descriptor_hash) {
-            AM_LOG_WARN(_device->logger(), "updating texture descriptor: handle: {}", (const void*)texture.handle);
-            VkDescriptorImageInfo descriptor = {};
-            descriptor.sampler = texture.sampler;
-            descriptor.imageView = texture.handle;
-            descriptor.imageLayout = texture.layout;
-            VkWriteDescriptorSet update = {};
-            update.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            update.dstSet = _handle;
-            update.dstBinding = binding.index;
-            update.dstArrayElement = offset;
-            update.descriptorCount = 1;
-            update.descriptorType = binding.type;
-            update.pImageInfo = &descriptor;
-            vkUpdateDescriptorSets(_device->native(), 1, &update, 0, nullptr);
-            AM_LIKELY_IF(!found_binding) {
-                _cache.push_back({ binding_hash, descriptor_hash });
-            } else {
-                is_bound->descriptor_hash = descriptor_hash;
+    void CDescriptorSet::_write(const SDescriptorBinding& binding, uint32 offset, const VkDescriptorImageInfo* descriptors, uint32 count) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(offset == 0 && count == 1 && binding.index < _template._slots.size()) {
+            const auto slot = _template._slots[binding.index];
+            AM_LIKELY_IF(slot != SBindingHandle::invalid) {
+                _template._data[slot].image = *descriptors;
+                _mark_dirty(binding.index);
+                return;
             }
         }
-        return *this;
+        _queue(binding.index, offset, binding.type, descriptors, count);
     }
 
-    void CDescriptorSet::update_pipeline(CRcPtr<CPipeline> pipeline) noexcept {
+    void CDescriptorSet::_mark_dirty(uint32 binding) noexcept {
         AM_PROFILE_SCOPED();
-        _pipeline = std::move(pipeline);
+        auto& dirty = _template._dirty;
+        AM_LIKELY_IF(std::find(dirty.begin(), dirty.end(), binding) == dirty.end()) {
+            dirty.emplace_back(binding);
+        }
+    }
+
+    void CDescriptorSet::_queue(uint32 binding, uint32 offset, VkDescriptorType type, const VkDescriptorBufferInfo* descriptors, uint32 count) noexcept {
+        AM_PROFILE_SCOPED();
+        _pending.push_back({
+            .binding = binding,
+            .offset = offset,
+            .first = (uint32)_pending_buffers.size(),
+            .count = count,
+            .type = type
+        });
+        _pending_buffers.insert(_pending_buffers.end(), descriptors, descriptors + count);
+    }
+
+    void CDescriptorSet::_queue(uint32 binding, uint32 offset, VkDescriptorType type, const VkDescriptorImageInfo* descriptors, uint32 count) noexcept {
+        AM_PROFILE_SCOPED();
+        _pending.push_back({
+            .binding = binding,
+            .offset = offset,
+            .first = (uint32)_pending_images.size(),
+            .count = count,
+            .type = type
+        });
+        _pending_images.insert(_pending_images.end(), descriptors, descriptors + count);
     }
 
     AM_NODISCARD AM_MODULE SDescriptorBinding make_descriptor_binding(uint32 index, EDescriptorType type) noexcept {
         AM_PROFILE_SCOPED();
         SDescriptorBinding binding = {};
         binding.index = index;
+        binding.count = 1;
         binding.type = prv::as_vulkan(type);
         return binding;
     }
@@ -1,7 +1,14 @@
+#include <amethyst/graphics/completion_poller.hpp>
 #include <amethyst/graphics/virtual_allocator.hpp>
 #include <amethyst/graphics/async_texture.hpp>
+#include <amethyst/graphics/shader_cache.hpp>
+#include <amethyst/graphics/gpu_profiler.hpp>
+#include <amethyst/graphics/async_event.hpp>
+#include <amethyst/graphics/texture_heap.hpp>
+#include <amethyst/graphics/image_pool.hpp>
 #include <amethyst/graphics/semaphore.hpp>
 #include <amethyst/graphics/swapchain.hpp>
+#include <amethyst/graphics/recycler.hpp>
 #include <amethyst/graphics/pipeline.hpp>
 #include <amethyst/graphics/context.hpp>
 #include <amethyst/graphics/device.hpp>
@@ -10,11 +17,15 @@
 #include <amethyst/meta/constants.hpp>
 #include <amethyst/meta/hash.hpp>
 
+#include <TaskScheduler.h>
+
 #if _WIN64
     #include <vulkan/vulkan_win32.h>
 #endif
 
+#include <algorithm>
 #include <optional>
+#include <cstring>
 #include <fstream>
 #include <chrono>
 #include <cmath>
@@ -32,6 +43,18 @@
 #endif
 
 namespace am {
+    // Prepended to the driver's blob, the driver validates its own header but not against a driver update
+    struct SPipelineCacheHeader {
+        uint32 magic = 0;
+        uint32 vendor_id = 0;
+        uint32 device_id = 0;
+        uint32 driver_version = 0;
+        uint8 uuid[VK_UUID_SIZE] = {};
+        uint64 size = 0;
+    };
+
+    constexpr static auto pipeline_cache_magic = 0x43504d41u; // "AMPC"
+
     template <typename T, typename U>
     static inline void insert_chain(T* self, U* object) noexcept {
         auto* old = self->pNext;
@@ -108,16 +131,29 @@ namespace am {
 #if defined(AM_ENABLE_AFTERMATH)
         GFSDK_Aftermath_DisableGpuCrashDumps();
 #endif
+        _completion_poller.reset();
+        _ready_events.reset();
+        _recycler.reset();
         while (!_to_delete.empty()) {
             _to_delete.front()._func(this);
             _to_delete.pop_front();
         }
+        // Cleanup payloads may still drop pooled images, the pool destroys every image retired to it
+        _image_pool.reset();
+        _gpu_profiler.reset();
+        _texture_heap.reset();
+        _shader_cache.reset();
+        _save_pipeline_caches();
         for (const auto& [_, layout] : _set_layout_cache) {
             vkDestroyDescriptorSetLayout(_handle, layout, nullptr);
         }
         for (const auto& [_, sampler] : _sampler_cache) {
             vkDestroySampler(_handle, sampler, nullptr);
         }
+        for (const auto& [_, library] : _pipeline_library_cache) {
+            vkDestroyPipeline(_handle, library.handle, nullptr);
+            vkDestroyPipelineLayout(_handle, library.layout, nullptr);
+        }
         AM_LOG_INFO(_logger, "terminating allocator");
         _virtual_allocators.clear();
         vmaDestroyAllocator(_allocator);
@@ -137,6 +173,9 @@ namespace am {
         auto* result = new Self();
         auto logger = spdlog::stdout_color_mt("device");
         AM_LOG_INFO(logger, "initializing device");
+        // Queues, the recycler and the completion poller start threads that call back into the device right away
+        result->_context = std::move(context);
+        result->_logger = logger;
         VkPhysicalDeviceVulkan11Features features_11 = {};
         features_11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
         VkPhysicalDeviceVulkan12Features features_12 = {};
@@ -151,9 +190,9 @@ namespace am {
         AM_VULKAN_CHECK(logger, vkEnumerateInstanceVersion(&api_version));
         { // Physical Device selection
             uint32 count;
-            vkEnumeratePhysicalDevices(context->native(), &count, nullptr);
+            vkEnumeratePhysicalDevices(result->_context->native(), &count, nullptr);
             std::vector<VkPhysicalDevice> devices(count);
-            vkEnumeratePhysicalDevices(context->native(), &count, devices.data());
+            vkEnumeratePhysicalDevices(result->_context->native(), &count, devices.data());
             for (const auto gpu : devices) {
                 result->_gpu_id.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
                 VkPhysicalDeviceProperties2 properties2 = {};
@@ -282,6 +321,7 @@ namespace am {
             VkPhysicalDeviceRayTracingPipelineFeaturesKHR raytracing_features = {};
             VkPhysicalDeviceBufferDeviceAddressFeaturesKHR bda_features = {};
             VkPhysicalDeviceFragmentShaderBarycentricFeaturesNV barycentric_features = {};
+            VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT library_features = {};
             for (const auto each : info.extensions) {
                 switch (each) {
                     case EDeviceExtension::Swapchain: {
@@ -329,6 +369,38 @@ namespace am {
                         }
                     } break;
 
+                    case EDeviceExtension::GraphicsPipelineLibrary: {
+                        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT supported = {};
+                        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+                        VkPhysicalDeviceFeatures2 query = {};
+                        query.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                        query.pNext = &supported;
+                        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT properties = {};
+                        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+                        VkPhysicalDeviceProperties2 properties2 = {};
+                        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+                        properties2.pNext = &properties;
+                        AM_LIKELY_IF(has_extension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+                                     has_extension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+                            vkGetPhysicalDeviceFeatures2(result->_gpu, &query);
+                            vkGetPhysicalDeviceProperties2(result->_gpu, &properties2);
+                        }
+                        // Pipelines link on the calling thread, without fast linking that costs as much as a monolithic build
+                        if (supported.graphicsPipelineLibrary && properties.graphicsPipelineLibraryFastLinking) {
+                            AM_LOG_INFO(logger, "graphics pipeline library enabled");
+                            library_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+                            library_features.graphicsPipelineLibrary = true;
+                            insert_chain(&features2, &library_features);
+                            enabled_extensions.emplace_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+                            enabled_extensions.emplace_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+                            result->_features_custom.graphics_pipeline_library = true;
+                        } else if (supported.graphicsPipelineLibrary) {
+                            AM_LOG_WARN(logger, "graphics pipeline library has no fast linking, pipelines are built monolithically");
+                        } else {
+                            AM_LOG_WARN(logger, "graphics pipeline library extension is not supported, pipelines are built monolithically");
+                        }
+                    } break;
+
                     default: AM_UNREACHABLE();
                 }
             }
@@ -381,12 +453,17 @@ namespace am {
             AM_VULKAN_CHECK(logger, vkCreateDevice(result->_gpu, &device_info, nullptr, &result->_handle));
             volkLoadDevice(result->_handle);
 
+            // One transient pool per scheduler thread, pools are indexed by enki thread number
+            const auto threads = result->_context->scheduler()->GetNumTaskThreads();
             VkQueue handle;
             vkGetDeviceQueue(result->_handle, graphics_family.family, graphics_family.index, &handle);
             result->_graphics = CQueue::make(result, {
                 .name = "graphics",
                 .handle = handle,
-                .family = graphics_family
+                .family = graphics_family,
+                .type = EQueueType::Graphics,
+                .threads = threads,
+                .submission_thread = info.submission_thread
             });
             result->_transfer = result->_graphics;
             result->_compute = result->_transfer;
@@ -395,7 +472,10 @@ namespace am {
                 result->_transfer = CQueue::make(result, {
                     .name = "transfer",
                     .handle = handle,
-                    .family = transfer_family
+                    .family = transfer_family,
+                    .type = EQueueType::Transfer,
+                    .threads = threads,
+                    .submission_thread = info.submission_thread
                 });
             }
 
@@ -404,7 +484,10 @@ namespace am {
                 result->_compute = CQueue::make(result, {
                     .name = "compute",
                     .handle = handle,
-                    .family = compute_family
+                    .family = compute_family,
+                    .type = EQueueType::Compute,
+                    .threads = threads,
+                    .submission_thread = info.submission_thread
                 });
             }
         }
@@ -422,7 +505,7 @@ namespace am {
             allocator_info.physicalDevice = result->_gpu;
             allocator_info.device = result->_handle;
             allocator_info.pVulkanFunctions = &vulkan_functions;
-            allocator_info.instance = context->native();
+            allocator_info.instance = result->_context->native();
             allocator_info.vulkanApiVersion = api_version;
             AM_VULKAN_CHECK(logger, vmaCreateAllocator(&allocator_info, &result->_allocator));
         }
@@ -435,8 +518,20 @@ namespace am {
             result->_virtual_allocators[(uint32)EVirtualAllocatorKind::StagingBuffer] =
                 CVirtualAllocator::make(result, EBufferUsage::TransferSRC, true);
         }
-        result->_logger = std::move(logger);
-        result->_context = std::move(context);
+        result->_ready_events = std::make_unique<CMPSCQueue<SReadyEvent>>();
+        result->_completion_poller = CCompletionPoller::make(result);
+        result->_recycler = CRecycler::make(result, result->_graphics->threads());
+        result->_image_pool = CImagePool::make(result);
+        result->_gpu_profiler = CGpuProfiler::make(result);
+        // Optional, a device without bindless support runs without it
+        result->_texture_heap = CTextureHeap::make(result);
+        result->_shader_cache = CShaderCache::make(
+            result,
+            info.cache_directory.empty() ? info.cache_directory : info.cache_directory / "shaders");
+        AM_LIKELY_IF(!info.cache_directory.empty()) {
+            result->_pipeline_cache_path = info.cache_directory / "pipelines.bin";
+        }
+        result->_load_pipeline_caches(result->_graphics->threads());
         return CRcPtr<Self>::make(result);
     }
 
@@ -505,6 +600,51 @@ namespace am {
         return _virtual_allocators[(uint32)kind].get();
     }
 
+    AM_NODISCARD CMPSCQueue<SReadyEvent>* CDevice::ready_events() noexcept {
+        AM_PROFILE_SCOPED();
+        return _ready_events.get();
+    }
+
+    AM_NODISCARD CCompletionPoller* CDevice::completion_poller() noexcept {
+        AM_PROFILE_SCOPED();
+        return _completion_poller.get();
+    }
+
+    AM_NODISCARD CRecycler* CDevice::recycler() noexcept {
+        AM_PROFILE_SCOPED();
+        return _recycler.get();
+    }
+
+    AM_NODISCARD CImagePool* CDevice::image_pool() noexcept {
+        AM_PROFILE_SCOPED();
+        return _image_pool.get();
+    }
+
+    AM_NODISCARD CGpuProfiler* CDevice::gpu_profiler() noexcept {
+        AM_PROFILE_SCOPED();
+        return _gpu_profiler.get();
+    }
+
+    AM_NODISCARD CTextureHeap* CDevice::texture_heap() noexcept {
+        AM_PROFILE_SCOPED();
+        return _texture_heap.get();
+    }
+
+    AM_NODISCARD CShaderCache* CDevice::shader_cache() noexcept {
+        AM_PROFILE_SCOPED();
+        return _shader_cache.get();
+    }
+
+    AM_NODISCARD VkPipelineCache CDevice::pipeline_cache() const noexcept {
+        AM_PROFILE_SCOPED();
+        const auto thread = _context->scheduler()->GetThreadNum();
+        // Threads outside the scheduler share the first cache, caches are internally synchronized
+        AM_UNLIKELY_IF(thread >= _pipeline_caches.size()) {
+            return _pipeline_caches[0];
+        }
+        return _pipeline_caches[thread];
+    }
+
     AM_NODISCARD uint32 CDevice::memory_type_index(uint32 filter, EMemoryProperty flags) noexcept {
         AM_PROFILE_SCOPED();
         const auto v_flags = prv::as_vulkan(flags);
@@ -525,6 +665,28 @@ namespace am {
             case EDeviceFeature::BufferDeviceAddress:
                  return _features_12.bufferDeviceAddress;
 
+            case EDeviceFeature::InheritedQueries:
+                return _features.features.inheritedQueries && _features.features.pipelineStatisticsQuery;
+
+            case EDeviceFeature::Synchronization2:
+                return _features_13.synchronization2;
+
+            case EDeviceFeature::DynamicRendering:
+                return _features_13.dynamicRendering;
+
+            case EDeviceFeature::HostQueryReset:
+                return _features_12.hostQueryReset;
+
+            case EDeviceFeature::GraphicsPipelineLibrary:
+                return _features_custom.graphics_pipeline_library;
+
+            case EDeviceFeature::BindlessTextures:
+                return _features_12.descriptorIndexing &&
+                       _features_12.runtimeDescriptorArray &&
+                       _features_12.descriptorBindingPartiallyBound &&
+                       _features_12.shaderSampledImageArrayNonUniformIndexing &&
+                       _features_12.descriptorBindingSampledImageUpdateAfterBind;
+
             default: AM_UNREACHABLE();
         }
         AM_UNREACHABLE();
@@ -586,22 +748,65 @@ namespace am {
 
     AM_NODISCARD VkDescriptorSetLayout CDevice::acquire_cached_item(const std::vector<SDescriptorBinding>& bindings) noexcept {
         AM_PROFILE_SCOPED();
-        return _set_layout_cache[prv::hash(0, bindings)];
+        std::lock_guard guard(_cache_lock);
+        const auto found = _set_layout_cache.find(prv::hash(0, bindings));
+        return found != _set_layout_cache.end() ? found->second : nullptr;
     }
 
-    void CDevice::set_cached_item(const std::vector<SDescriptorBinding>& bindings, VkDescriptorSetLayout layout) noexcept {
+    AM_NODISCARD VkDescriptorSetLayout CDevice::set_cached_item(const std::vector<SDescriptorBinding>& bindings, VkDescriptorSetLayout layout) noexcept {
         AM_PROFILE_SCOPED();
-        _set_layout_cache[prv::hash(0, bindings)] = layout;
+        std::lock_guard guard(_cache_lock);
+        return _set_layout_cache.try_emplace(prv::hash(0, bindings), layout).first->second;
     }
 
     AM_NODISCARD VkSampler CDevice::acquire_cached_item(const SSamplerInfo& info) noexcept {
         AM_PROFILE_SCOPED();
-        return _sampler_cache[prv::hash(0, info)];
+        std::lock_guard guard(_cache_lock);
+        const auto found = _sampler_cache.find(prv::hash(0, info));
+        return found != _sampler_cache.end() ? found->second : nullptr;
+    }
+
+    AM_NODISCARD VkSampler CDevice::set_cached_item(const SSamplerInfo& info, VkSampler sampler) noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_cache_lock);
+        return _sampler_cache.try_emplace(prv::hash(0, info), sampler).first->second;
+    }
+
+    AM_NODISCARD VkPipeline CDevice::acquire_pipeline_library(uint64 key, uint64 check) noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_cache_lock);
+        const auto found = _pipeline_library_cache.find(key);
+        AM_UNLIKELY_IF(found == _pipeline_library_cache.end() || found->second.check != check) {
+            return nullptr;
+        }
+        found->second.references++;
+        return found->second.handle;
+    }
+
+    AM_NODISCARD VkPipeline CDevice::set_pipeline_library(uint64 key, uint64 check, VkPipeline library, VkPipelineLayout layout) noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_cache_lock);
+        auto& cached = _pipeline_library_cache.try_emplace(key, SPipelineLibrary{ library, layout, check, 0 }).first->second;
+        AM_UNLIKELY_IF(cached.check != check) {
+            AM_LOG_WARN(_logger, "pipeline library key collision: {}", key);
+            return nullptr;
+        }
+        cached.references++;
+        return cached.handle;
     }
 
-    void CDevice::set_cached_item(const SSamplerInfo& info, VkSampler sampler) noexcept {
+    void CDevice::release_pipeline_library(uint64 key) noexcept {
         AM_PROFILE_SCOPED();
-        _sampler_cache[prv::hash(0, info)] = sampler;
+        std::lock_guard guard(_cache_lock);
+        const auto found = _pipeline_library_cache.find(key);
+        AM_ASSERT(found != _pipeline_library_cache.end() && found->second.references > 0, "releasing an unknown pipeline library");
+        AM_LIKELY_IF(found == _pipeline_library_cache.end() || --found->second.references > 0) {
+            return;
+        }
+        // Linked pipelines do not depend on their parts, nothing in flight references them anymore
+        vkDestroyPipeline(_handle, found->second.handle, nullptr);
+        vkDestroyPipelineLayout(_handle, found->second.layout, nullptr);
+        _pipeline_library_cache.erase(found);
     }
 
     void CDevice::cleanup_after(uint32 frames, std::function<void(const Self*)>&& func) noexcept {
@@ -616,6 +821,13 @@ namespace am {
 
     void CDevice::update_cleanup() noexcept {
         AM_PROFILE_SCOPED();
+        // Loader continuations pinned to the main thread only run when it asks for them
+        _context->scheduler()->RunPinnedTasks();
+        _image_pool->update();
+        _gpu_profiler->update();
+        AM_LIKELY_IF(_texture_heap) {
+            _texture_heap->update();
+        }
         AM_LIKELY_IF(_to_delete.empty()) {
             return;
         }
@@ -676,8 +888,118 @@ namespace am {
                 sampler_info.pNext = &reduction_mode_info;
             }
             AM_VULKAN_CHECK(_logger, vkCreateSampler(_handle, &sampler_info, nullptr, &sampler));
-            set_cached_item(info, sampler);
+            const auto cached = set_cached_item(info, sampler);
+            AM_UNLIKELY_IF(cached != sampler) {
+                vkDestroySampler(_handle, sampler, nullptr);
+                sampler = cached;
+            }
         }
         return sampler;
     }
+
+    void CDevice::_load_pipeline_caches(uint32 threads) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto& properties = _properties.properties;
+        std::vector<uint8> data;
+        AM_LIKELY_IF(!_pipeline_cache_path.empty()) {
+            std::ifstream file(_pipeline_cache_path, std::ios::binary);
+            SPipelineCacheHeader header = {};
+            AM_LIKELY_IF(file && file.read((char*)&header, sizeof header)) {
+                // The recorded size is only trusted up to what the file holds, a corrupt one must not drive the allocation
+                std::error_code error;
+                const auto file_size = std::filesystem::file_size(_pipeline_cache_path, error);
+                const auto available = !error && file_size > sizeof header ? file_size - sizeof header : 0;
+                const bool is_valid =
+                    header.magic == pipeline_cache_magic &&
+                    header.vendor_id == properties.vendorID &&
+                    header.device_id == properties.deviceID &&
+                    header.driver_version == properties.driverVersion &&
+                    std::memcmp(header.uuid, uuid(), VK_UUID_SIZE) == 0 &&
+                    header.size >= sizeof(VkPipelineCacheHeaderVersionOne) &&
+                    header.size <= available;
+                AM_LIKELY_IF(is_valid) {
+                    data.resize(header.size);
+                    file.read((char*)data.data(), data.size());
+                }
+                // Drivers reject a foreign blob anyway, checking its header spares them a truncated or corrupt one
+                VkPipelineCacheHeaderVersionOne driver = {};
+                AM_LIKELY_IF(is_valid && file) {
+                    std::memcpy(&driver, data.data(), sizeof driver);
+                }
+                AM_UNLIKELY_IF(!is_valid ||
+                               !file ||
+                               driver.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+                               std::memcmp(driver.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+                    AM_LOG_INFO(_logger, "pipeline cache: \"{}\" is stale, starting empty", _pipeline_cache_path.string());
+                    data.clear();
+                }
+            }
+        }
+        AM_LOG_INFO(_logger, "pipeline cache: loaded {} bytes for {} threads", data.size(), threads);
+        _pipeline_caches.resize(std::max(threads, 1u));
+        for (auto& each : _pipeline_caches) {
+            VkPipelineCacheCreateInfo cache_info = {};
+            cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            cache_info.initialDataSize = data.size();
+            cache_info.pInitialData = data.data();
+            AM_VULKAN_CHECK(_logger, vkCreatePipelineCache(_handle, &cache_info, nullptr, &each));
+        }
+    }
+
+    void CDevice::_save_pipeline_caches() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(_pipeline_caches.empty()) {
+            return;
+        }
+        auto main = _pipeline_caches[0];
+        AM_LIKELY_IF(_pipeline_caches.size() > 1) {
+            AM_VULKAN_CHECK(_logger, vkMergePipelineCaches(
+                _handle,
+                main,
+                (uint32)_pipeline_caches.size() - 1,
+                _pipeline_caches.data() + 1));
+        }
+        AM_LIKELY_IF(!_pipeline_cache_path.empty()) {
+            std::size_t size = 0;
+            AM_VULKAN_CHECK(_logger, vkGetPipelineCacheData(_handle, main, &size, nullptr));
+            std::vector<uint8> data(size);
+            AM_VULKAN_CHECK(_logger, vkGetPipelineCacheData(_handle, main, &size, data.data()));
+            const auto& properties = _properties.properties;
+            SPipelineCacheHeader header = {
+                .magic = pipeline_cache_magic,
+                .vendor_id = properties.vendorID,
+                .device_id = properties.deviceID,
+                .driver_version = properties.driverVersion,
+                .size = size
+            };
+            std::memcpy(header.uuid, uuid(), VK_UUID_SIZE);
+            // Written aside and renamed, a crash while saving keeps the previous cache
+            auto temporary = _pipeline_cache_path;
+            temporary += ".tmp";
+            std::error_code error;
+            std::filesystem::create_directories(_pipeline_cache_path.parent_path(), error);
+            bool is_written = false;
+            {
+                std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+                file.write((const char*)&header, sizeof header);
+                file.write((const char*)data.data(), size);
+                // A short write must not replace the good cache, closing flushes and can fail as well
+                file.close();
+                is_written = file.good();
+            }
+            AM_LIKELY_IF(is_written) {
+                std::filesystem::rename(temporary, _pipeline_cache_path, error);
+            }
+            AM_UNLIKELY_IF(!is_written || error) {
+                AM_LOG_WARN(_logger, "pipeline cache: cannot write \"{}\"", _pipeline_cache_path.string());
+                std::filesystem::remove(temporary, error);
+            } else {
+                AM_LOG_INFO(_logger, "pipeline cache: saved {} bytes", size);
+            }
+        }
+        for (auto each : _pipeline_caches) {
+            vkDestroyPipelineCache(_handle, each, nullptr);
+        }
+        _pipeline_caches.clear();
+    }
 } // namespace am
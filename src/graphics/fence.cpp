@@ -1,3 +1,4 @@
+#include <amethyst/graphics/recycler.hpp>
 #include <amethyst/graphics/fence.hpp>
 
 namespace am {
@@ -5,6 +6,10 @@ namespace am {
 
     CFence::~CFence() noexcept {
         AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(_recycled) {
+            _device->recycler()->recycle_fence(_handle);
+            return;
+        }
         vkDestroyFence(_device->native(), _handle, nullptr);
     }
 
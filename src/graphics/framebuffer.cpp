@@ -1,8 +1,23 @@
 #include <amethyst/graphics/framebuffer.hpp>
+#include <amethyst/graphics/image_pool.hpp>
 
 #include <amethyst/meta/constants.hpp>
 
+#include <algorithm>
+
 namespace am {
+    // Dynamic passes take their render targets from the pool, resizing within a bucket keeps the memory
+    AM_NODISCARD static CRcPtr<const CImage> make_owning_image(
+        const CRcPtr<CDevice>& device,
+        const CRenderPass* pass,
+        CImage::SCreateInfo&& info) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(pass->is_dynamic()) {
+            return device->image_pool()->acquire(info).as_const();
+        }
+        return CImage::make(device, std::move(info)).as_const();
+    }
+
     CFramebuffer::CFramebuffer() noexcept = default;
 
     CFramebuffer::~CFramebuffer() noexcept {
@@ -25,7 +40,7 @@ namespace am {
                 const auto& attachment = each.attachment.info;
                 const auto& description = info.pass->attachment(attachment.index);
                 result->_images.push_back({
-                    CImage::make(device, {
+                    make_owning_image(device, info.pass.get(), {
                         .queue = EQueueType::Graphics,
                         .samples = description.samples,
                         .usage = attachment.usage,
@@ -38,7 +53,7 @@ namespace am {
                         .mips = attachment.mips,
                         .width = info.width,
                         .height = info.height
-                    }).as_const(),
+                    }),
                     each.is_owning
                 });
                 const auto& [image, _] = result->_images.back();
@@ -58,6 +73,12 @@ namespace am {
             }
         }
 
+        AM_LIKELY_IF(info.pass->is_dynamic()) {
+            result->_device = std::move(device);
+            result->_pass = std::move(info.pass);
+            return CRcPtr<Self>::make(result);
+        }
+
         VkFramebufferCreateInfo framebuffer_info = {};
         framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebuffer_info.renderPass = info.pass->native();
@@ -112,7 +133,7 @@ namespace am {
         for (auto& [image, is_owning] : _images) {
             auto&& old = std::move(image);
             if (is_owning) {
-                auto new_image = CImage::make(_device, {
+                auto new_image = make_owning_image(_device, _pass.get(), {
                     .queue = EQueueType::Graphics,
                     .samples = (EImageSampleCount)old->samples(),
                     .usage = (EImageUsage)old->usage(),
@@ -125,26 +146,56 @@ namespace am {
                     .mips = old->mips(),
                     .width = width,
                     .height = height
-                }).as_const();
+                });
                 old_images.emplace_back(std::move(old));
                 image = std::move(new_image);
             }
         }
         _viewport = { width, height };
+        _recreate(std::move(old_images));
+        return true;
+    }
+
+    void CFramebuffer::update_attachment(uint32 index, const CImage* image) noexcept {
+        AM_PROFILE_SCOPED();
+        auto& [current, is_owning] = _images[index];
+        AM_LIKELY_IF(current.get() == image) {
+            return;
+        }
+        std::vector<CRcPtr<const CImage>> old_images;
+        AM_UNLIKELY_IF(is_owning) {
+            old_images.emplace_back(std::move(current));
+        }
+        current = CRcPtr<const CImage>::make(image);
+        is_owning = false;
+        _viewport = { image->width(), image->height() };
+        _recreate(std::move(old_images));
+    }
+
+    void CFramebuffer::_recreate(std::vector<CRcPtr<const CImage>>&& old_images) noexcept {
+        AM_PROFILE_SCOPED();
+        // Pooled images return to the pool as "old_images" drops them
+        AM_LIKELY_IF(_pass->is_dynamic()) {
+            return;
+        }
         uint32 layers = 0;
+        // A referenced image is only swapped for one of the new size after a resize, never exceed any attachment
+        auto extent = _viewport;
         std::vector<VkImageView> references;
         references.reserve(_images.size());
         for (const auto& [image, _] : _images) {
             references.emplace_back(image->view());
             layers = image->layers();
+            extent.width = std::min(extent.width, image->width());
+            extent.height = std::min(extent.height, image->height());
         }
         VkFramebufferCreateInfo framebuffer_info = {};
         framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebuffer_info.renderPass = _pass->native();
         framebuffer_info.attachmentCount = (uint32)references.size();
         framebuffer_info.pAttachments = references.data();
-        framebuffer_info.width = _viewport.width;
-        framebuffer_info.height = _viewport.height;
+        framebuffer_info.width = extent.width;
+        framebuffer_info.height = extent.height;
         framebuffer_info.layers = layers;
         _device->cleanup_after(
             frames_in_flight,
@@ -155,12 +206,6 @@ namespace am {
                 vkDestroyFramebuffer(device->native(), handle, nullptr);
             });
         AM_VULKAN_CHECK(_device->logger(), vkCreateFramebuffer(_device->native(), &framebuffer_info, nullptr, &_handle));
-        return true;
-    }
-
-    void CFramebuffer::update_attachment(uint32 index, const CImage* image) noexcept {
-        AM_PROFILE_SCOPED();
-        _images[index].image = CRcPtr<const CImage>::make(image);
     }
 
     AM_NODISCARD SFramebufferAttachment make_attachment(SFramebufferAttachmentInfo&& info) noexcept {
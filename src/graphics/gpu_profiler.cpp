@@ -0,0 +1,248 @@
+#include <amethyst/graphics/gpu_profiler.hpp>
+#include <amethyst/graphics/device.hpp>
+#include <amethyst/graphics/queue.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+namespace am {
+    CGpuProfiler::CGpuProfiler() noexcept = default;
+
+    CGpuProfiler::~CGpuProfiler() noexcept {
+        AM_PROFILE_SCOPED();
+        vkDestroyQueryPool(_device->native(), _pool, nullptr);
+    }
+
+    AM_NODISCARD std::unique_ptr<CGpuProfiler> CGpuProfiler::make(CDevice* device) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = std::unique_ptr<Self>(new Self());
+        result->_device = device;
+        result->_period = device->limits().timestampPeriod;
+        AM_UNLIKELY_IF(!device->feature_support(EDeviceFeature::HostQueryReset) || result->_period == 0) {
+            AM_LOG_WARN(device->logger(), "gpu profiler: timestamps or host query resets unsupported, zones are ignored");
+            return result;
+        }
+        uint32 families_count;
+        vkGetPhysicalDeviceQueueFamilyProperties(device->gpu(), &families_count, nullptr);
+        std::vector<VkQueueFamilyProperties> families(families_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(device->gpu(), &families_count, families.data());
+        const CQueue* queues[3] = {
+            device->graphics_queue(),
+            device->transfer_queue(),
+            device->compute_queue()
+        };
+        for (uint32 i = 0; i < result->_masks.size(); ++i) {
+            // Queues without valid bits keep a zero mask, their zones are ignored
+            const auto bits = families[queues[i]->family()].timestampValidBits;
+            result->_masks[i] = bits >= 64 ? (uint64)-1 : (1ull << bits) - 1;
+        }
+
+        VkQueryPoolCreateInfo query_pool_info = {};
+        query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        query_pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_pool_info.queryCount = ring_size * max_zones * 2;
+        AM_VULKAN_CHECK(device->logger(), vkCreateQueryPool(device->native(), &query_pool_info, nullptr, &result->_pool));
+        vkResetQueryPool(device->native(), result->_pool, 0, query_pool_info.queryCount);
+        result->_results.resize(max_zones * 4);
+        result->_current.store(0, std::memory_order_release);
+        return result;
+    }
+
+    AM_NODISCARD VkQueryPool CGpuProfiler::native() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _pool;
+    }
+
+    AM_NODISCARD bool CGpuProfiler::is_supported() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _pool != nullptr;
+    }
+
+    AM_NODISCARD uint32 CGpuProfiler::begin_zone(EQueueType queue, const char* name, uint32 depth) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto slot = _current.load(std::memory_order_acquire);
+        AM_UNLIKELY_IF(slot == invalid_zone || _masks[(uint32)queue] == 0) {
+            return invalid_zone;
+        }
+        auto& frame = _frames[slot];
+        const auto index = frame.count.fetch_add(1, std::memory_order_relaxed);
+        AM_UNLIKELY_IF(index >= max_zones) {
+            _dropped_zones.fetch_add(1, std::memory_order_relaxed);
+            return invalid_zone;
+        }
+        frame.zones[index] = { name, queue, depth };
+        return (slot * max_zones + index) * 2;
+    }
+
+    void CGpuProfiler::update() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(!_pool) {
+            return;
+        }
+        std::lock_guard guard(_lock);
+        const auto current = _current.load(std::memory_order_relaxed);
+        AM_LIKELY_IF(current != invalid_zone) {
+            _frames[current].busy = _frames[current].count.load(std::memory_order_relaxed) != 0;
+        }
+        for (uint32 i = 0; i < ring_size; ++i) {
+            AM_LIKELY_IF(i != current && _frames[i].busy) {
+                _frames[i].busy = !_collect(i);
+            }
+        }
+        _slot = (_slot + 1) % ring_size;
+        AM_UNLIKELY_IF(_frames[_slot].busy) {
+            _stats.dropped_frames++;
+            _current.store(invalid_zone, std::memory_order_release);
+            return;
+        }
+        _current.store(_slot, std::memory_order_release);
+    }
+
+    AM_NODISCARD std::vector<SGpuZoneStats> CGpuProfiler::zones() const noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        std::vector<SGpuZoneStats> result;
+        result.reserve(_history.size());
+        for (const auto& each : _history) {
+            result.emplace_back(each.stats);
+        }
+        return result;
+    }
+
+    AM_NODISCARD SGpuProfilerStats CGpuProfiler::stats() const noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        auto result = _stats;
+        result.dropped_zones = _dropped_zones.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    bool CGpuProfiler::write_chrome_trace(const std::filesystem::path& path) const noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        std::ofstream file(path);
+        AM_UNLIKELY_IF(!file) {
+            AM_LOG_ERROR(_device->logger(), "gpu profiler: cannot write trace to {}", path.string());
+            return false;
+        }
+        auto origin = std::numeric_limits<float64>::max();
+        for (const auto& frame : _trace) {
+            for (const auto& event : frame) {
+                origin = std::min(origin, event.begin_ns);
+            }
+        }
+        constexpr const char* queue_names[] = { "graphics", "transfer", "compute" };
+        file << "{\"traceEvents\":[";
+        bool first = true;
+        for (uint32 i = 0; i < std::size(queue_names); ++i) {
+            file
+                << (first ? "" : ",")
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i
+                << ",\"args\":{\"name\":\"" << queue_names[i] << "\"}}";
+            first = false;
+        }
+        for (const auto& frame : _trace) {
+            for (const auto& event : frame) {
+                // Chrome expects microseconds
+                file
+                    << ",{\"name\":\"" << event.name
+                    << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << (uint32)event.queue
+                    << ",\"ts\":" << (event.begin_ns - origin) / 1000.0
+                    << ",\"dur\":" << (event.end_ns - event.begin_ns) / 1000.0 << "}";
+            }
+        }
+        file << "]}\n";
+        return (bool)file;
+    }
+
+    AM_NODISCARD bool CGpuProfiler::_collect(uint32 slot) noexcept {
+        AM_PROFILE_SCOPED();
+        auto& frame = _frames[slot];
+        const auto count = std::min(frame.count.load(std::memory_order_relaxed), max_zones);
+        const auto first = slot * max_zones * 2;
+        // Value and availability of every query, the begin and end of a zone are adjacent
+        const auto result = vkGetQueryPoolResults(
+            _device->native(),
+            _pool,
+            first,
+            count * 2,
+            count * 4 * sizeof(uint64),
+            _results.data(),
+            sizeof(uint64) * 2,
+            VK_QUERY_RESULT_64_BIT |
+            VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        // Unavailable queries may still be in flight, resetting them from the host is undefined. The slot stays busy
+        // until every one of them is written
+        AM_UNLIKELY_IF(result == VK_NOT_READY) {
+            AM_UNLIKELY_IF(++frame.pending == max_pending_updates) {
+                AM_LOG_WARN(_device->logger(), "gpu profiler: slot {} still unavailable after {} updates", slot, max_pending_updates);
+            }
+            return false;
+        }
+        AM_VULKAN_CHECK(_device->logger(), result);
+        for (auto& each : _history) {
+            each.frame_ms = 0;
+            each.touched = false;
+        }
+        auto& events = _trace.emplace_back();
+        events.reserve(count);
+        for (uint32 i = 0; i < count; ++i) {
+            const auto& zone = frame.zones[i];
+            const auto* values = &_results[i * 4];
+            AM_UNLIKELY_IF(values[1] == 0 || values[3] == 0) {
+                _dropped_zones.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            const auto mask = _masks[(uint32)zone.queue];
+            const auto begin = values[0] & mask;
+            const auto ticks = ((values[2] & mask) - begin) & mask;
+            auto [index, inserted] = _history_index.try_emplace(zone.name, (uint32)_history.size());
+            AM_UNLIKELY_IF(inserted) {
+                auto& history = _history.emplace_back();
+                history.stats.name = zone.name;
+                history.stats.queue = zone.queue;
+                history.stats.depth = zone.depth;
+            }
+            auto& history = _history[index->second];
+            history.frame_ms += ticks * _period / 1'000'000.0;
+            history.touched = true;
+            events.push_back({
+                zone.name,
+                zone.queue,
+                begin * _period,
+                (begin + ticks) * _period
+            });
+        }
+        for (auto& each : _history) {
+            AM_LIKELY_IF(!each.touched) {
+                continue;
+            }
+            each.samples[each.next] = each.frame_ms;
+            each.next = (each.next + 1) % history_frames;
+            each.count = std::min(each.count + 1, history_frames);
+            auto& stats = each.stats;
+            stats.last_ms = each.frame_ms;
+            stats.min_ms = std::numeric_limits<float64>::max();
+            stats.max_ms = 0;
+            float64 total = 0;
+            for (uint32 i = 0; i < each.count; ++i) {
+                total += each.samples[i];
+                stats.min_ms = std::min(stats.min_ms, each.samples[i]);
+                stats.max_ms = std::max(stats.max_ms, each.samples[i]);
+            }
+            stats.average_ms = total / each.count;
+#if defined(AM_ENABLE_PROFILING)
+            TracyPlot(stats.name, stats.last_ms);
+#endif
+        }
+        AM_UNLIKELY_IF(_trace.size() > trace_frames) {
+            _trace.pop_front();
+        }
+        vkResetQueryPool(_device->native(), _pool, first, count * 2);
+        frame.count.store(0, std::memory_order_relaxed);
+        frame.pending = 0;
+        _stats.frames++;
+        return true;
+    }
+} // namespace am
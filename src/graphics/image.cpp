@@ -1,3 +1,4 @@
+#include <amethyst/graphics/image_pool.hpp>
 #include <amethyst/graphics/image.hpp>
 #include <amethyst/graphics/queue.hpp>
 
@@ -7,6 +8,10 @@ namespace am {
     CImage::~CImage() noexcept {
         AM_PROFILE_SCOPED();
         AM_LOG_INFO(_device->logger(), "deallocating image: {}", (const void*)_handle);
+        AM_UNLIKELY_IF(_pool) {
+            _pool->_retire(_handle, _view);
+            return;
+        }
         vkDestroyImageView(_device->native(), _view, nullptr);
         AM_LIKELY_IF(_owning) {
             vmaDestroyImage(_device->allocator(), _handle, _allocation);
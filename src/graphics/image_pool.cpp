@@ -0,0 +1,249 @@
+#include <amethyst/graphics/image_pool.hpp>
+#include <amethyst/graphics/device.hpp>
+#include <amethyst/graphics/queue.hpp>
+
+#include <amethyst/meta/constants.hpp>
+#include <amethyst/meta/hash.hpp>
+
+#include <algorithm>
+
+namespace am {
+    CImagePool::CImagePool() noexcept = default;
+
+    CImagePool::~CImagePool() noexcept {
+        AM_PROFILE_SCOPED();
+        for (const auto& each : _retired) {
+            vkDestroyImageView(_device->native(), each.view, nullptr);
+            vkDestroyImage(_device->native(), each.handle, nullptr);
+        }
+        for (auto& [_, blocks] : _idle) {
+            for (auto& block : blocks) {
+                _free(block);
+            }
+        }
+        for (auto& [_, block] : _live) {
+            _free(block);
+        }
+    }
+
+    AM_NODISCARD std::unique_ptr<CImagePool> CImagePool::make(CDevice* device) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = std::unique_ptr<Self>(new Self());
+        result->_device = device;
+        return result;
+    }
+
+    AM_NODISCARD CRcPtr<CImage> CImagePool::acquire(const CImage::SCreateInfo& info) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto aspect = prv::deduce_aspect(prv::as_vulkan(info.format.internal));
+        const auto view_format =
+            info.format.view == EResourceFormat::Undefined ?
+                info.format.internal :
+                info.format.view;
+        uint32 family;
+        switch (info.queue) {
+            case EQueueType::Graphics:
+                family = _device->graphics_queue()->family();
+                break;
+            case EQueueType::Transfer:
+                family = _device->transfer_queue()->family();
+                break;
+            case EQueueType::Compute:
+                family = _device->compute_queue()->family();
+                break;
+        }
+        VkImageCreateInfo image_info = {};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        if (info.format.internal != view_format) {
+            image_info.flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+        }
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = prv::as_vulkan(info.format.internal);
+        image_info.extent = { info.width, info.height, 1 };
+        image_info.mipLevels = info.mips;
+        image_info.arrayLayers = info.layers;
+        image_info.samples = prv::as_vulkan(info.samples);
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = prv::as_vulkan(info.usage);
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.queueFamilyIndexCount = 1;
+        image_info.pQueueFamilyIndices = &family;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        const auto bucket = prv::hash(
+            0,
+            (uint32)image_info.flags,
+            (uint32)image_info.format,
+            (uint32)image_info.usage,
+            (uint32)image_info.samples,
+            info.layers,
+            info.mips,
+            (uint32)align_size(info.width, bucket_granularity),
+            (uint32)align_size(info.height, bucket_granularity));
+
+        VkImage handle;
+        AM_VULKAN_CHECK(_device->logger(), vkCreateImage(_device->native(), &image_info, nullptr, &handle));
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(_device->native(), handle, &requirements);
+
+        SBlock block = {};
+        {
+            std::lock_guard guard(_lock);
+            auto& blocks = _idle[bucket];
+            const auto found = std::find_if(blocks.begin(), blocks.end(), [&](const SBlock& each) noexcept {
+                return
+                    each.requirements.size >= requirements.size &&
+                    each.requirements.alignment % requirements.alignment == 0 &&
+                    (requirements.memoryTypeBits & (1u << each.memory_type)) != 0;
+            });
+            AM_LIKELY_IF(found != blocks.end()) {
+                block = *found;
+                blocks.erase(found);
+                _hits++;
+            }
+        }
+        AM_UNLIKELY_IF(!block.allocation) {
+            block = _allocate(image_info, requirements, bucket);
+        }
+        AM_VULKAN_CHECK(_device->logger(), vmaBindImageMemory(_device->allocator(), block.allocation, handle));
+
+        VkImageViewCreateInfo image_view_info = {};
+        image_view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        image_view_info.image = handle;
+        image_view_info.viewType =
+            info.layers == 1 ?
+                VK_IMAGE_VIEW_TYPE_2D :
+                VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        image_view_info.format = prv::as_vulkan(view_format);
+        image_view_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        image_view_info.subresourceRange.aspectMask = aspect;
+        image_view_info.subresourceRange.baseMipLevel = 0;
+        image_view_info.subresourceRange.levelCount = info.mips;
+        image_view_info.subresourceRange.baseArrayLayer = 0;
+        image_view_info.subresourceRange.layerCount = info.layers;
+        VkImageView view;
+        AM_VULKAN_CHECK(_device->logger(), vkCreateImageView(_device->native(), &image_view_info, nullptr, &view));
+        {
+            std::lock_guard guard(_lock);
+            _live[handle] = block;
+        }
+        // Doesn't own its memory, the last drop hands the image back to the pool
+        auto result = CImage::from_raw(CRcPtr<CDevice>::make(_device), {
+            .handle = handle,
+            .view = view,
+            .allocation = block.allocation,
+            .usage = (VkImageUsageFlags)image_info.usage,
+            .samples = image_info.samples,
+            .aspect = aspect,
+            .format = {
+                image_info.format,
+                image_view_info.format
+            },
+            .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .layers = info.layers,
+            .mips = info.mips,
+            .width = info.width,
+            .height = info.height
+        });
+        result->_pool = this;
+        return result;
+    }
+
+    void CImagePool::update() noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        _frame++;
+        // Frames recorded before the last drop may still use the image
+        std::erase_if(_retired, [this](const SRetiredImage& each) noexcept {
+            AM_LIKELY_IF(_frame - each.frame <= frames_in_flight) {
+                return false;
+            }
+            _recycle(each);
+            return true;
+        });
+        for (auto& [_, blocks] : _idle) {
+            std::erase_if(blocks, [this](SBlock& block) noexcept {
+                AM_LIKELY_IF(_frame - block.idle_since <= max_idle_frames) {
+                    return false;
+                }
+                _free(block);
+                return true;
+            });
+        }
+    }
+
+    AM_NODISCARD SImagePoolStats CImagePool::stats() const noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        SImagePoolStats result = {};
+        result.hits = _hits;
+        result.allocations = _allocations;
+        result.live_images = (uint32)_live.size();
+        for (const auto& [_, blocks] : _idle) {
+            result.idle_blocks += (uint32)blocks.size();
+        }
+        result.allocated_bytes = _allocated_bytes;
+        return result;
+    }
+
+    void CImagePool::_retire(VkImage handle, VkImageView view) noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        _retired.push_back({ handle, view, _frame });
+    }
+
+    void CImagePool::_recycle(const SRetiredImage& image) noexcept {
+        AM_PROFILE_SCOPED();
+        vkDestroyImageView(_device->native(), image.view, nullptr);
+        vkDestroyImage(_device->native(), image.handle, nullptr);
+        auto block = _live.extract(image.handle);
+        AM_UNLIKELY_IF(block.empty()) {
+            return;
+        }
+        block.mapped().idle_since = _frame;
+        _idle[block.mapped().bucket].emplace_back(block.mapped());
+    }
+
+    AM_NODISCARD CImagePool::SBlock CImagePool::_allocate(const VkImageCreateInfo& info, const VkMemoryRequirements& requirements, uint64 bucket) noexcept {
+        AM_PROFILE_SCOPED();
+        // Sized for the largest image of the bucket, every smaller image rounding to it fits
+        auto bucket_info = info;
+        bucket_info.extent.width = (uint32)align_size(info.extent.width, bucket_granularity);
+        bucket_info.extent.height = (uint32)align_size(info.extent.height, bucket_granularity);
+        VkImage probe;
+        AM_VULKAN_CHECK(_device->logger(), vkCreateImage(_device->native(), &bucket_info, nullptr, &probe));
+        SBlock block = {};
+        vkGetImageMemoryRequirements(_device->native(), probe, &block.requirements);
+        vkDestroyImage(_device->native(), probe, nullptr);
+        block.requirements.size = std::max(block.requirements.size, requirements.size);
+        block.requirements.alignment = std::max(block.requirements.alignment, requirements.alignment);
+        block.requirements.memoryTypeBits &= requirements.memoryTypeBits;
+        block.bucket = bucket;
+
+        VmaAllocationCreateInfo allocation_info = {};
+        allocation_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        allocation_info.priority = 1;
+        VmaAllocationInfo allocated = {};
+        AM_VULKAN_CHECK(
+            _device->logger(),
+            vmaAllocateMemory(_device->allocator(), &block.requirements, &allocation_info, &block.allocation, &allocated));
+        block.memory_type = allocated.memoryType;
+        AM_LOG_INFO(
+            _device->logger(),
+            "image pool: allocating block for {}x{} bucket ({} bytes)",
+            bucket_info.extent.width, bucket_info.extent.height, block.requirements.size);
+        std::lock_guard guard(_lock);
+        _allocations++;
+        _allocated_bytes += block.requirements.size;
+        return block;
+    }
+
+    void CImagePool::_free(SBlock& block) noexcept {
+        AM_PROFILE_SCOPED();
+        vmaFreeMemory(_device->allocator(), block.allocation);
+        _allocated_bytes -= block.requirements.size;
+        block.allocation = {};
+    }
+} // namespace am
@@ -0,0 +1,121 @@
+#include <amethyst/graphics/parallel_recorder.hpp>
+#include <amethyst/graphics/context.hpp>
+
+#include <TaskScheduler.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace am {
+    struct CParallelRecorder::SJob {
+        struct alignas(64) SThreadOutput {
+            std::vector<std::pair<uint32, CCommandBuffer*>> commands;
+        };
+
+        enki::TaskSet task;
+        PassFunc pass;
+        RangeFunc range;
+        SRecordRangeInfo info = {};
+        std::vector<SThreadOutput> recorded;
+        std::vector<std::pair<uint32, CCommandBuffer*>> ordered;
+        std::vector<CCommandBuffer*> result;
+    };
+
+    CParallelRecorder::CParallelRecorder() noexcept = default;
+
+    CParallelRecorder::~CParallelRecorder() noexcept {
+        AM_PROFILE_SCOPED();
+        for (uint32 i = 0; i < _used; ++i) {
+            _device->context()->scheduler()->WaitforTask(&_jobs[i]->task);
+        }
+    }
+
+    AM_NODISCARD CRcPtr<CParallelRecorder> CParallelRecorder::make(CRcPtr<CDevice> device, CRcPtr<CCommandAllocator> allocator) noexcept {
+        AM_PROFILE_SCOPED();
+        auto* result = new Self();
+        result->_allocator = std::move(allocator);
+        result->_device = std::move(device);
+        return CRcPtr<Self>::make(result);
+    }
+
+    void CParallelRecorder::reset() noexcept {
+        AM_PROFILE_SCOPED();
+        for (uint32 i = 0; i < _used; ++i) {
+            AM_ASSERT(_jobs[i]->task.GetIsComplete(), "recording job was never waited on");
+        }
+        _used = 0;
+    }
+
+    AM_NODISCARD uint32 CParallelRecorder::record(PassFunc&& func) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto index = _used;
+        auto& job = _next_job();
+        job.pass = std::move(func);
+        job.range = nullptr;
+        job.info = {};
+        job.task.m_SetSize = 1;
+        job.task.m_MinRange = 1;
+        _device->context()->scheduler()->AddTaskSetToPipe(&job.task);
+        return index;
+    }
+
+    AM_NODISCARD uint32 CParallelRecorder::record(SRecordRangeInfo&& info, RangeFunc&& func) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto index = _used;
+        auto& job = _next_job();
+        job.pass = nullptr;
+        job.range = std::move(func);
+        job.info = info;
+        job.task.m_SetSize = std::max(info.count, 1u);
+        job.task.m_MinRange = std::max(info.batch, 1u);
+        _device->context()->scheduler()->AddTaskSetToPipe(&job.task);
+        return index;
+    }
+
+    AM_NODISCARD const std::vector<CCommandBuffer*>& CParallelRecorder::wait(uint32 index) noexcept {
+        AM_PROFILE_SCOPED();
+        auto& job = *_jobs[index];
+        _device->context()->scheduler()->WaitforTask(&job.task);
+        job.ordered.clear();
+        for (auto& [commands] : job.recorded) {
+            job.ordered.insert(job.ordered.end(), commands.begin(), commands.end());
+            commands.clear();
+        }
+        // Workers pick up ranges in any order, execution follows the range order instead
+        std::sort(job.ordered.begin(), job.ordered.end(), [](const auto& left, const auto& right) noexcept {
+            return left.first < right.first;
+        });
+        job.result.clear();
+        for (const auto& [_, commands] : job.ordered) {
+            job.result.emplace_back(commands);
+        }
+        return job.result;
+    }
+
+    AM_NODISCARD CParallelRecorder::SJob& CParallelRecorder::_next_job() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(_used < _jobs.size()) {
+            return *_jobs[_used++];
+        }
+        auto& job = *_jobs.emplace_back(std::make_unique<SJob>());
+        job.recorded.resize(_allocator->threads());
+        job.task.m_Function = [job = &job, allocator = _allocator.get()](enki::TaskSetPartition range, uint32 thread) noexcept {
+            AM_PROFILE_NAMED_SCOPE("parallel recorder: job");
+            AM_LIKELY_IF(job->range) {
+                auto& commands = allocator->acquire(thread, ECommandBufferLevel::Secondary);
+                commands.begin(job->info.framebuffer, job->info.render_pass, job->info.statistics);
+                job->range(commands, range.start, std::min(range.end, job->info.count));
+                commands.end();
+                job->recorded[thread].commands.emplace_back(range.start, &commands);
+                return;
+            }
+            auto& commands = allocator->acquire(thread);
+            commands.begin();
+            job->pass(commands);
+            commands.end();
+            job->recorded[thread].commands.emplace_back(range.start, &commands);
+        };
+        _used++;
+        return job;
+    }
+} // namespace am
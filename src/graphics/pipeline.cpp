@@ -1,148 +1,46 @@
-#include <amethyst/core/file_view.hpp>
-
+#include <amethyst/graphics/shader_reflection.hpp>
+#include <amethyst/graphics/texture_heap.hpp>
+#include <amethyst/graphics/shader_cache.hpp>
 #include <amethyst/graphics/framebuffer.hpp>
 #include <amethyst/graphics/pipeline.hpp>
+#include <amethyst/graphics/context.hpp>
 
-#include <shaderc/shaderc.hpp>
+#include <amethyst/meta/hash.hpp>
 
-#include <spirv_glsl.hpp>
-#include <spirv.hpp>
+#include <TaskScheduler.h>
 
 #include <algorithm>
 #include <numeric>
-#include <map>
 #include <utility>
+#include <array>
+#include <mutex>
+#include <map>
 
 namespace am {
-    namespace spvc = spirv_cross;
-    namespace shc = shaderc;
-    namespace fs = std::filesystem;
-
-    class CShaderIncluder : public shc::CompileOptions::IncluderInterface {
-    public:
-        using Self = CShaderIncluder;
-        using Super = shc::CompileOptions::IncluderInterface;
-
-        CShaderIncluder(fs::path root) noexcept : _root(std::move(root)) {};
-        ~CShaderIncluder() noexcept override = default;
-
-        shaderc_include_result* GetInclude(const char* requested_source,
-                                           shaderc_include_type,
-                                           const char*,
-                                           size_t) noexcept override {
-            AM_PROFILE_SCOPED();
-            auto path = _root / requested_source;
-            auto file = CFileView::make(path);
-            std::string content((const char*)file->data(), file->size());
-            return new CIncludeResult(std::move(content), path.filename().generic_string());
-        }
-
-        void ReleaseInclude(shaderc_include_result* data) noexcept override {
-            AM_PROFILE_SCOPED();
-            delete static_cast<CIncludeResult*>(data);
-        }
-    private:
-        class CIncludeResult : public shaderc_include_result {
-        public:
-            using Self = CIncludeResult;
-            using Super = shaderc_include_result;
-
-            CIncludeResult(std::string&& content, std::string&& filename) noexcept
-                : Super(),
-                  _content(std::move(content)),
-                  _filename(std::move(filename)) {
-                AM_PROFILE_SCOPED();
-                Super::content = _content.c_str();
-                Super::content_length = _content.size();
-                Super::source_name = _filename.c_str();
-                Super::source_name_length = _filename.size();
-                Super::user_data = nullptr;
-            };
-
-            ~CIncludeResult() noexcept = default;
-
-        private:
-            std::string _content;
-            std::string _filename;
-        };
-        fs::path _root;
-    };
-
-    AM_NODISCARD static inline std::vector<uint32> compile_shader(fs::path&& path, shaderc_shader_kind kind, spdlog::logger* logger) noexcept {
+    static inline void process_resources(CDevice* device,
+                                         std::map<uint64, std::vector<SDescriptorBinding>>& descriptor_layout,
+                                         std::map<std::string, SDescriptorBinding>& descriptor_bindings,
+                                         std::map<std::string, VkPushConstantRange>& push_constants,
+                                         const SShaderReflection& reflection,
+                                         VkShaderStageFlags stage) {
         AM_PROFILE_SCOPED();
-        const auto s_path = path.string();
-        auto file = CFileView::make(path);
-        if (!file) {
-            switch (file.error()) {
-                case CFileView::EErrorType::FileNotFound:
-                    logger->error("shader: \"{}\" cannot load, file not found", s_path);
-                    return {};
-                case CFileView::EErrorType::InternalError:
-                    logger->error("shader: \"{}\" cannot load, internal filesystem error", s_path);
-                    return {};
+        if (reflection.push_constant_size != 0) {
+            auto [ptr, miss] = push_constants.try_emplace(reflection.push_constant);
+            auto& [_, value] = *ptr;
+            if (!miss) {
+                value.stageFlags |= stage;
+            } else {
+                value.stageFlags = stage;
+                value.offset = 0;
+                value.size = reflection.push_constant_size;
             }
         }
-
-        shc::Compiler compiler;
-        shc::CompileOptions options;
-        options.SetGenerateDebugInfo();
-        options.SetOptimizationLevel(shaderc_optimization_level_performance);
-        options.SetSourceLanguage(shaderc_source_language_glsl);
-        options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
-        options.SetTargetSpirv(shaderc_spirv_version_1_5);
-        options.SetIncluder(std::make_unique<CShaderIncluder>(path.parent_path()));
-        auto spirv = compiler.CompileGlslToSpv(
-            (const char*)file->data(),
-            file->size(),
-            kind,
-            s_path.c_str(),
-            options);
-        if (spirv.GetCompilationStatus() != shaderc_compilation_status_success) {
-            logger->error("shader compile failed:\n\"{}\"", spirv.GetErrorMessage());
-            logger->flush();
-            return {};
-        }
-        return { spirv.cbegin(), spirv.cend() };
-    }
-
-    static inline void process_resource(CDevice* device,
-                                        std::map<uint64, std::vector<SDescriptorBinding>>& descriptor_layout,
-                                        std::map<std::string, SDescriptorBinding>& descriptor_bindings,
-                                        std::map<std::string, VkPushConstantRange>& push_constants,
-                                        const spvc::CompilerGLSL& compiler,
-                                        const auto& resources,
-                                        VkDescriptorType descriptor,
-                                        VkShaderStageFlags stage,
-                                        bool push_constant = false) {
-        AM_PROFILE_SCOPED();
-        if (push_constant) {
-            if (!resources.empty()) {
-                const auto& resource = resources[0];
-                auto [ptr, miss] = push_constants.try_emplace(resource.name);
-                auto& [_, value] = *ptr;
-                if (!miss) {
-                    value.stageFlags |= stage;
-                } else {
-                    const auto size = compiler.get_declared_struct_size(compiler.get_type(resource.type_id));
-                    auto& current = push_constants[resource.name];
-                    current.stageFlags = stage;
-                    current.offset = 0;
-                    current.size = (uint32)size;
-                }
-            }
-            return;
-        }
-        for (const auto& each : resources) {
-            const auto set = compiler.get_decoration(each.id, spv::DecorationDescriptorSet);
-            const auto binding = compiler.get_decoration(each.id, spv::DecorationBinding);
-            const auto& type = compiler.get_type(each.type_id);
-            auto count = 1u;
-            auto is_dynamic = false;
-            const bool is_array = !type.array.empty();
-            is_dynamic = is_array && type.array[0] == 0;
+        for (const auto& each : reflection.resources) {
+            auto count = each.count;
+            const auto is_dynamic = each.count == 0;
             if (is_dynamic) {
                 const auto& limits = device->limits();
-                switch (descriptor) {
+                switch (each.type) {
                     case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
                         count = std::min<uint32>(limits.maxPerStageDescriptorSamplers, 4096);
                         break;
@@ -154,40 +52,276 @@ namespace am {
                         break;
                     default: break;
                 }
-            } else if (is_array) {
-                count = type.array[0];
             }
-            auto& layout = descriptor_layout[set];
-            const auto found = std::find_if(layout.begin(), layout.end(), [binding](const auto& each) {
+            auto& layout = descriptor_layout[each.set];
+            const auto found = std::find_if(layout.begin(), layout.end(), [binding = each.binding](const auto& each) {
                 return each.index == binding;
             });
             if (found != layout.end()) {
                 found->stage |= stage;
             } else {
-                descriptor_layout[set].emplace_back(
+                descriptor_layout[each.set].emplace_back(
                     descriptor_bindings[each.name] = {
                         .dynamic = is_dynamic,
-                        .index = binding,
+                        .set = each.set,
+                        .index = each.binding,
                         .count = count,
-                        .type = descriptor,
+                        .type = each.type,
                         .stage = stage
                     });
             }
         }
     }
 
+    static inline void process_constants(std::map<std::string, SSpecializationConstant>& constants,
+                                         const SShaderReflection& reflection) noexcept {
+        AM_PROFILE_SCOPED();
+        for (const auto& each : reflection.constants) {
+            constants[each.name] = {
+                .id = each.id,
+                .value = each.value
+            };
+        }
+    }
+
+    struct SSpecializationData {
+        std::vector<VkSpecializationMapEntry> entries;
+        std::vector<uint32> data;
+        VkSpecializationInfo info = {};
+    };
+
+    // Every stage shares the same map, IDs a stage does not declare are ignored by the driver
+    static inline void make_specialization(SSpecializationData& result, const std::vector<SSpecializationConstant>& constants) noexcept {
+        AM_PROFILE_SCOPED();
+        result.entries.reserve(constants.size());
+        result.data.reserve(constants.size());
+        for (const auto& each : constants) {
+            result.entries.push_back({
+                .constantID = each.id,
+                .offset = (uint32)size_bytes(result.data),
+                .size = sizeof(uint32)
+            });
+            result.data.emplace_back(each.value);
+        }
+        result.info.mapEntryCount = (uint32)result.entries.size();
+        result.info.pMapEntries = result.entries.data();
+        result.info.dataSize = size_bytes(result.data);
+        result.info.pData = result.data.data();
+    }
+
+    AM_NODISCARD static inline uint64 hash_constants(const std::vector<SSpecializationConstant>& constants) noexcept {
+        AM_PROFILE_SCOPED();
+        uint64 seed = 0;
+        for (const auto& each : constants) {
+            seed = prv::hash(seed, each.id, each.value);
+        }
+        return seed;
+    }
+
+    // FNV-1a, unrelated to "prv::hash()", tells apart library parts whose keys collide
+    AM_NODISCARD static inline uint64 check_bytes(uint64 seed, const void* data, uint64 size) noexcept {
+        const auto* bytes = static_cast<const uint8*>(data);
+        for (uint64 i = 0; i < size; ++i) {
+            seed ^= bytes[i];
+            seed *= 0x100000001b3ull;
+        }
+        return seed;
+    }
+
+    template <typename T>
+    AM_NODISCARD static inline uint64 check_value(uint64 seed, const T& value) noexcept {
+        return check_bytes(seed, &value, sizeof(value));
+    }
+
+    template <typename T>
+    AM_NODISCARD static inline uint64 check_value(uint64 seed, const std::vector<T>& values) noexcept {
+        return check_bytes(check_value(seed, values.size()), values.data(), size_bytes(values));
+    }
+
+    template <typename... Args>
+    AM_NODISCARD static inline uint64 check_hash(uint64 seed, const Args&... args) noexcept {
+        ((seed = check_value(seed, args)), ...);
+        return seed;
+    }
+
+    // The heap's set is bound through "CCommandBuffer::bind_texture_heap()", never allocated from its layout. Only a set
+    // declaring exactly "uniform sampler2D[]" at binding 0 gets the heap's layout
+    AM_NODISCARD static inline VkDescriptorSetLayout texture_heap_layout(CDevice* device,
+                                                                         uint64 set,
+                                                                         const std::vector<SDescriptorBinding>& descriptors) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto* heap = device->texture_heap();
+        AM_LIKELY_IF(set != CTextureHeap::set_index || !heap) {
+            return {};
+        }
+        const auto is_heap =
+            descriptors.size() == 1 &&
+            descriptors[0].dynamic &&
+            descriptors[0].index == 0 &&
+            descriptors[0].type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        AM_ASSERT(is_heap, "descriptor set 2 is reserved for the texture heap, a single runtime sampler array at binding 0");
+        AM_UNLIKELY_IF(!is_heap) {
+            AM_LOG_ERROR(device->logger(), "descriptor set {} does not match the texture heap, using its own layout", set);
+            return {};
+        }
+        return heap->layout();
+    }
+
+    AM_NODISCARD static inline VkDescriptorUpdateTemplate make_update_template(CDevice* device,
+                                                                               VkDescriptorSetLayout layout,
+                                                                               const std::vector<SDescriptorBinding>& descriptors) noexcept {
+        AM_PROFILE_SCOPED();
+        std::vector<VkDescriptorUpdateTemplateEntry> entries;
+        entries.reserve(descriptors.size());
+        for (const auto& binding : descriptors) {
+            AM_LIKELY_IF(binding.is_templated()) {
+                entries.push_back({
+                    .dstBinding = binding.index,
+                    .dstArrayElement = 0,
+                    .descriptorCount = 1,
+                    .descriptorType = binding.type,
+                    .offset = entries.size() * sizeof(SDescriptorData),
+                    .stride = sizeof(SDescriptorData)
+                });
+            }
+        }
+        AM_UNLIKELY_IF(entries.empty()) {
+            return nullptr;
+        }
+        VkDescriptorUpdateTemplateCreateInfo template_info = {};
+        template_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        template_info.descriptorUpdateEntryCount = (uint32)entries.size();
+        template_info.pDescriptorUpdateEntries = entries.data();
+        template_info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        template_info.descriptorSetLayout = layout;
+        VkDescriptorUpdateTemplate result = {};
+        AM_VULKAN_CHECK(device->logger(), vkCreateDescriptorUpdateTemplate(device->native(), &template_info, nullptr, &result));
+        return result;
+    }
+
+    // Builds one part of a graphics pipeline as a library. "info" carries the whole pipeline state, each part only reads
+    // the state that belongs to it, stages are filtered here. Shader parts get a layout of their own so they outlive the
+    // pipeline that built them. The caller releases the returned part through "CDevice::release_pipeline_library()",
+    // null means "key" is taken by a part built from other inputs
+    AM_NODISCARD static inline VkPipeline make_pipeline_library(CDevice* device,
+                                                                VkGraphicsPipelineCreateInfo info,
+                                                                const VkPipelineLayoutCreateInfo& layout_info,
+                                                                VkGraphicsPipelineLibraryFlagsEXT part,
+                                                                uint64 key,
+                                                                uint64 check) noexcept {
+        AM_PROFILE_SCOPED();
+        auto library = device->acquire_pipeline_library(key, check);
+        AM_LIKELY_IF(library) {
+            return library;
+        }
+        VkPipelineLayout layout = {};
+        AM_LIKELY_IF(part == VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT ||
+                     part == VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT) {
+            AM_VULKAN_CHECK(device->logger(), vkCreatePipelineLayout(device->native(), &layout_info, nullptr, &layout));
+        }
+        info.layout = layout;
+        std::vector<VkPipelineShaderStageCreateInfo> stages;
+        stages.reserve(info.stageCount);
+        for (uint32 i = 0; i < info.stageCount; ++i) {
+            const auto is_fragment = info.pStages[i].stage == VK_SHADER_STAGE_FRAGMENT_BIT;
+            AM_LIKELY_IF((part == VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT && !is_fragment) ||
+                         (part == VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT && is_fragment)) {
+                stages.emplace_back(info.pStages[i]);
+            }
+        }
+        VkGraphicsPipelineLibraryCreateInfoEXT library_info = {};
+        library_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+        library_info.pNext = info.pNext;
+        library_info.flags = part;
+        info.pNext = &library_info;
+        info.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+        info.stageCount = (uint32)stages.size();
+        info.pStages = stages.data();
+        AM_VULKAN_CHECK(device->logger(), vkCreateGraphicsPipelines(device->native(), device->pipeline_cache(), 1, &info, nullptr, &library));
+        const auto cached = device->set_pipeline_library(key, check, library, layout);
+        AM_UNLIKELY_IF(cached != library) {
+            vkDestroyPipeline(device->native(), library, nullptr);
+            vkDestroyPipelineLayout(device->native(), layout, nullptr);
+            library = cached;
+        }
+        return library;
+    }
+
+    // Without "optimize" the driver only stitches the parts together, cheap enough to do on the calling thread
+    AM_NODISCARD static inline VkPipeline link_pipeline_libraries(CDevice* device,
+                                                                  const std::array<VkPipeline, 4>& libraries,
+                                                                  VkPipelineLayout layout,
+                                                                  bool optimize) noexcept {
+        AM_PROFILE_SCOPED();
+        VkPipelineLibraryCreateInfoKHR linking_info = {};
+        linking_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+        linking_info.libraryCount = (uint32)libraries.size();
+        linking_info.pLibraries = libraries.data();
+
+        VkGraphicsPipelineCreateInfo pipeline_info = {};
+        pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipeline_info.pNext = &linking_info;
+        AM_UNLIKELY_IF(optimize) {
+            pipeline_info.flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+        }
+        pipeline_info.layout = layout;
+        pipeline_info.basePipelineHandle = nullptr;
+        pipeline_info.basePipelineIndex = -1;
+        VkPipeline result = {};
+        AM_VULKAN_CHECK(device->logger(), vkCreateGraphicsPipelines(device->native(), device->pipeline_cache(), 1, &pipeline_info, nullptr, &result));
+        return result;
+    }
+
+    // Owned by a pipeline and every variant made from it, variants only differ in their constants
+    struct CPipeline::SShared : IRefCounted {
+        ~SShared() noexcept {
+            AM_PROFILE_SCOPED();
+            for (const auto& each : sets) {
+                vkDestroyDescriptorUpdateTemplate(device->native(), each.update_template, nullptr);
+            }
+            vkDestroyPipelineLayout(device->native(), layout, nullptr);
+            for (const auto& stage : stages) {
+                vkDestroyShaderModule(device->native(), stage.module, nullptr);
+            }
+        }
+
+        std::vector<VkPipelineShaderStageCreateInfo> stages;
+        // Hashes of the vertex, geometry and fragment binaries, keys of the library parts
+        std::array<uint64, 3> code = {};
+        // Second hashes of the same binaries, see "CDevice::SPipelineLibrary::check"
+        std::array<uint64, 3> code_check = {};
+        std::vector<VkPipelineColorBlendAttachmentState> outputs;
+        std::vector<VkDescriptorSetLayout> set_layouts;
+        std::vector<VkPushConstantRange> push_constants;
+        std::vector<SDescriptorSetLayout> sets;
+        VkPipelineLayout layout = {};
+        CRcPtr<CDevice> device;
+    };
+
     CPipeline::CPipeline() noexcept = default;
 
     CPipeline::~CPipeline() noexcept {
         AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(_link_task) {
+            _device->context()->scheduler()->WaitforTask(_link_task.get());
+        }
+        for (const auto& [_, bucket] : _variants) {
+            for (const auto& each : bucket) {
+                AM_UNLIKELY_IF(each.task) {
+                    _device->context()->scheduler()->WaitforTask(each.task.get());
+                }
+            }
+        }
         AM_LOG_INFO(_device->logger(), "destroying pipeline: {}, layout: {}", (const void*)_handle, (const void*)_layout._pipeline);
-        vkDestroyPipelineLayout(_device->native(), _layout._pipeline, nullptr);
+        for (const auto key : _libraries) {
+            _device->release_pipeline_library(key);
+        }
+        vkDestroyPipeline(_device->native(), _optimized.load(std::memory_order_acquire), nullptr);
         vkDestroyPipeline(_device->native(), _handle, nullptr);
     }
 
     AM_NODISCARD CRcPtr<CPipeline> CPipeline::make(CRcPtr<CDevice> device, SGraphicsCreateInfo&& info) noexcept {
         AM_PROFILE_SCOPED();
-        auto* result = new Self();
         bool should_create_vertex = !info.vertex.empty();
         bool should_create_fragment = !info.fragment.empty();
         bool should_create_geometry = !info.geometry.empty();
@@ -219,11 +353,36 @@ namespace am {
         std::map<std::string, VkPushConstantRange> push_constants;
         std::map<uint64, std::vector<SDescriptorBinding>> descriptor_layout;
 
+        // Stages load concurrently, reflection stays serial as every stage merges into the same tables
+        SShaderBinary binaries[3];
+        {
+            const std::filesystem::path* paths[] = { &info.vertex, &info.geometry, &info.fragment };
+            constexpr EShaderStage stages[] = { EShaderStage::Vertex, EShaderStage::Geometry, EShaderStage::Fragment };
+            enki::TaskSet compile_task(3, [&](enki::TaskSetPartition range, uint32) noexcept {
+                for (auto i = range.start; i < range.end; ++i) {
+                    AM_LIKELY_IF(!paths[i]->empty()) {
+                        binaries[i] = device->shader_cache()->load(*paths[i], stages[i]);
+                    }
+                }
+            });
+            device->context()->scheduler()->AddTaskSetToPipe(&compile_task);
+            device->context()->scheduler()->WaitforTask(&compile_task);
+            // Any requested stage failing fails the pipeline, a hot reload then keeps the previous one
+            for (uint32 i = 0; i < std::size(paths); ++i) {
+                AM_UNLIKELY_IF(!paths[i]->empty() && binaries[i].code.empty()) {
+                    AM_LOG_ERROR(device->logger(), "cannot create graphics pipeline, \"{}\" failed to load", paths[i]->string());
+                    return nullptr;
+                }
+            }
+        }
+        auto* result = new Self();
+        auto shared = CRcPtr<SShared>::make(new SShared());
+        shared->device = device;
+
         { // Vertex Stage
-            auto binary = compile_shader(std::move(info.vertex), shaderc_vertex_shader, device->logger());
+            const auto& [binary, reflection] = binaries[0];
             AM_ASSERT(!binary.empty(), "cannot create graphics pipeline without vertex shader");
-            const auto compiler = spvc::CompilerGLSL(binary.data(), binary.size());
-            const auto resources = compiler.get_shader_resources();
+            process_constants(result->_constants, reflection);
 
             VkShaderModuleCreateInfo module_create_info = {};
             module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -231,43 +390,21 @@ namespace am {
             module_create_info.pCode = binary.data();
             AM_VULKAN_CHECK(device->logger(), vkCreateShaderModule(device->native(), &module_create_info, nullptr, &vertex_stage.module));
 
-            process_resource(
-                device.get(),
-                descriptor_layout,
-                result->_bindings,
-                push_constants,
-                compiler,
-                resources.push_constant_buffers,
-                {},
-                VK_SHADER_STAGE_VERTEX_BIT,
-                true);
-            process_resource(
-                device.get(),
-                descriptor_layout,
-                result->_bindings,
-                push_constants,
-                compiler,
-                resources.uniform_buffers,
-                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                VK_SHADER_STAGE_VERTEX_BIT);
-            process_resource(
+            process_resources(
                 device.get(),
                 descriptor_layout,
                 result->_bindings,
                 push_constants,
-                compiler,
-                resources.storage_buffers,
-                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                reflection,
                 VK_SHADER_STAGE_VERTEX_BIT);
         }
 
         if (should_create_geometry) { // Geometry Stage
-            auto binary = compile_shader(std::move(info.geometry), shaderc_geometry_shader, device->logger());
+            const auto& [binary, reflection] = binaries[1];
             if (binary.empty()) {
                 should_create_geometry = false;
             } else {
-                const auto compiler = spvc::CompilerGLSL(binary.data(), binary.size());
-                const auto resources = compiler.get_shader_resources();
+                process_constants(result->_constants, reflection);
 
                 VkShaderModuleCreateInfo module_create_info = {};
                 module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -275,63 +412,23 @@ namespace am {
                 module_create_info.pCode = binary.data();
                 AM_VULKAN_CHECK(device->logger(), vkCreateShaderModule(device->native(), &module_create_info, nullptr, &geometry_stage.module));
 
-                process_resource(
-                    device.get(),
-                    descriptor_layout,
-                    result->_bindings,
-                    push_constants,
-                    compiler,
-                    resources.push_constant_buffers,
-                    {},
-                    VK_SHADER_STAGE_GEOMETRY_BIT,
-                    true);
-                process_resource(
+                process_resources(
                     device.get(),
                     descriptor_layout,
                     result->_bindings,
                     push_constants,
-                    compiler,
-                    resources.uniform_buffers,
-                    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                    VK_SHADER_STAGE_GEOMETRY_BIT);
-                process_resource(
-                    device.get(),
-                    descriptor_layout,
-                    result->_bindings,
-                    push_constants,
-                    compiler,
-                    resources.storage_buffers,
-                    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                    VK_SHADER_STAGE_GEOMETRY_BIT);
-                process_resource(
-                    device.get(),
-                    descriptor_layout,
-                    result->_bindings,
-                    push_constants,
-                    compiler,
-                    resources.sampled_images,
-                    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                    VK_SHADER_STAGE_GEOMETRY_BIT);
-                process_resource(
-                    device.get(),
-                    descriptor_layout,
-                    result->_bindings,
-                    push_constants,
-                    compiler,
-                    resources.storage_images,
-                    VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                    reflection,
                     VK_SHADER_STAGE_GEOMETRY_BIT);
             }
         }
 
         std::vector<VkPipelineColorBlendAttachmentState> attachment_outputs;
         if (should_create_fragment) { // Fragment Stage
-            auto binary = compile_shader(std::move(info.fragment), shaderc_fragment_shader, device->logger());
+            const auto& [binary, reflection] = binaries[2];
             if (binary.empty()) {
                 should_create_fragment = false;
             } else {
-                const auto compiler = spvc::CompilerGLSL(binary.data(), binary.size());
-                const auto resources = compiler.get_shader_resources();
+                process_constants(result->_constants, reflection);
 
                 VkShaderModuleCreateInfo module_create_info = {};
                 module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -346,14 +443,13 @@ namespace am {
                 attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
                 attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
                 attachment.alphaBlendOp = VK_BLEND_OP_ADD;
-                for (uint32 i = 0; const auto& outputs : resources.stage_outputs) {
-                    const auto& type = compiler.get_type(outputs.type_id);
+                for (uint32 i = 0; const auto components : reflection.outputs) {
                     if (info.attachments.empty()) {
-                        attachment.blendEnable = type.vecsize == 4;
+                        attachment.blendEnable = components == 4;
                     } else {
                         switch (info.attachments[i++]) {
                             case EAttachmentBlend::Auto:
-                                attachment.blendEnable = type.vecsize == 4;
+                                attachment.blendEnable = components == 4;
                                 break;
 
                             case EAttachmentBlend::Disabled:
@@ -361,64 +457,133 @@ namespace am {
                                 break;
                         }
                     }
-                    switch (type.vecsize) {
+                    switch (components) {
                         case 4: attachment.colorWriteMask |= VK_COLOR_COMPONENT_A_BIT; AM_FALLTHROUGH;
                         case 3: attachment.colorWriteMask |= VK_COLOR_COMPONENT_B_BIT; AM_FALLTHROUGH;
                         case 2: attachment.colorWriteMask |= VK_COLOR_COMPONENT_G_BIT; AM_FALLTHROUGH;
                         case 1: attachment.colorWriteMask |= VK_COLOR_COMPONENT_R_BIT;
                     }
                 }
-                attachment_outputs.resize(resources.stage_outputs.size(), attachment);
+                attachment_outputs.resize(reflection.outputs.size(), attachment);
 
-                process_resource(
+                process_resources(
                     device.get(),
                     descriptor_layout,
                     result->_bindings,
                     push_constants,
-                    compiler,
-                    resources.push_constant_buffers,
-                    {},
-                    VK_SHADER_STAGE_FRAGMENT_BIT,
-                    true);
-                process_resource(
-                    device.get(),
-                    descriptor_layout,
-                    result->_bindings,
-                    push_constants,
-                    compiler,
-                    resources.uniform_buffers,
-                    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                    VK_SHADER_STAGE_FRAGMENT_BIT);
-                process_resource(
-                    device.get(),
-                    descriptor_layout,
-                    result->_bindings,
-                    push_constants,
-                    compiler,
-                    resources.storage_buffers,
-                    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-                    VK_SHADER_STAGE_FRAGMENT_BIT);
-                process_resource(
-                    device.get(),
-                    descriptor_layout,
-                    result->_bindings,
-                    push_constants,
-                    compiler,
-                    resources.sampled_images,
-                    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                    VK_SHADER_STAGE_FRAGMENT_BIT);
-                process_resource(
-                    device.get(),
-                    descriptor_layout,
-                    result->_bindings,
-                    push_constants,
-                    compiler,
-                    resources.storage_images,
-                    VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                    reflection,
                     VK_SHADER_STAGE_FRAGMENT_BIT);
             }
         }
 
+        std::vector<VkDescriptorSetLayout> set_layouts;
+        set_layouts.reserve(descriptor_layout.size());
+        result->_layout._set.reserve(descriptor_layout.size());
+        result->_layout._bindings.reserve(descriptor_layout.size());
+        for (const auto& [set, descriptors] : descriptor_layout) {
+            SDescriptorSetLayout layout = {};
+            // Known up front, a cache hit skips the loop below and variants or reloads always hit
+            for (const auto& binding : descriptors) {
+                AM_UNLIKELY_IF(binding.dynamic) {
+                    layout.dynamic = true;
+                    layout.binds = binding.count;
+                }
+            }
+            layout.handle = texture_heap_layout(device.get(), set, descriptors);
+            AM_LIKELY_IF(!layout.handle) {
+                layout.handle = device->acquire_cached_item(descriptors);
+            }
+            AM_UNLIKELY_IF(!layout.handle) {
+                std::vector<VkDescriptorBindingFlags> flags;
+                flags.reserve(descriptors.size());
+                std::vector<VkDescriptorSetLayoutBinding> bindings;
+                bindings.reserve(descriptors.size());
+                for (const auto& binding : descriptors) {
+                    flags.emplace_back();
+                    AM_UNLIKELY_IF(binding.dynamic) {
+                        layout.dynamic = true;
+                        layout.binds = binding.count;
+                        flags.back() =
+                            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                            VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+                    }
+                    bindings.push_back({
+                        .binding = binding.index,
+                        .descriptorType = binding.type,
+                        .descriptorCount = binding.count,
+                        .stageFlags = binding.stage,
+                        .pImmutableSamplers = nullptr
+                    });
+                }
+
+                VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags = {};
+                binding_flags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+                binding_flags.bindingCount = (uint32)flags.size();
+                binding_flags.pBindingFlags = flags.data();
+
+                VkDescriptorSetLayoutCreateInfo layout_info = {};
+                layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+                layout_info.pNext = &binding_flags;
+                layout_info.bindingCount = (uint32)bindings.size();
+                layout_info.pBindings = bindings.data();
+                AM_VULKAN_CHECK(device->logger(), vkCreateDescriptorSetLayout(device->native(), &layout_info, nullptr, &layout.handle));
+                const auto cached = device->set_cached_item(descriptors, layout.handle);
+                AM_UNLIKELY_IF(cached != layout.handle) {
+                    vkDestroyDescriptorSetLayout(device->native(), layout.handle, nullptr);
+                    layout.handle = cached;
+                }
+            }
+            layout.update_template = make_update_template(device.get(), layout.handle, descriptors);
+            result->_layout._set.emplace_back(layout);
+            result->_layout._bindings.emplace_back(descriptors);
+            set_layouts.emplace_back(layout.handle);
+        }
+
+        std::vector<VkPushConstantRange> push_constant_ranges;
+        push_constant_ranges.reserve(push_constants.size());
+        for (const auto& [_, value] : push_constants) {
+            push_constant_ranges.emplace_back(value);
+        }
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.setLayoutCount = (uint32)set_layouts.size();
+        pipeline_layout_info.pSetLayouts = set_layouts.data();
+        pipeline_layout_info.pushConstantRangeCount = (uint32)push_constant_ranges.size();
+        pipeline_layout_info.pPushConstantRanges = push_constant_ranges.data();
+        AM_VULKAN_CHECK(device->logger(), vkCreatePipelineLayout(device->native(), &pipeline_layout_info, nullptr, &result->_layout._pipeline));
+
+        shared->stages.emplace_back(vertex_stage);
+        if (should_create_geometry) { shared->stages.emplace_back(geometry_stage); }
+        if (should_create_fragment) { shared->stages.emplace_back(fragment_stage); }
+        for (uint32 i = 0; i < std::size(binaries); ++i) {
+            shared->code[i] = prv::hash(binaries[i].code.size(), binaries[i].code);
+            shared->code_check[i] = check_value(0xcbf29ce484222325ull, binaries[i].code);
+        }
+        shared->outputs = std::move(attachment_outputs);
+        shared->set_layouts = std::move(set_layouts);
+        shared->push_constants = std::move(push_constant_ranges);
+        shared->layout = result->_layout._pipeline;
+        shared->sets = result->_layout._set;
+        result->_shared = std::move(shared);
+        result->_graphics_info = std::move(info);
+        result->_type = EPipelineType::Graphics;
+        result->_device = std::move(device);
+        result->_create_graphics();
+        return CRcPtr<Self>::make(result);
+    }
+
+    void CPipeline::_create_graphics() noexcept {
+        AM_PROFILE_SCOPED();
+        auto* device = _device.get();
+        const auto& info = _graphics_info;
+        VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.setLayoutCount = (uint32)_shared->set_layouts.size();
+        pipeline_layout_info.pSetLayouts = _shared->set_layouts.data();
+        pipeline_layout_info.pushConstantRangeCount = (uint32)_shared->push_constants.size();
+        pipeline_layout_info.pPushConstantRanges = _shared->push_constants.data();
+
         VkVertexInputBindingDescription vertex_binding_description = {};
         vertex_binding_description.binding = 0;
         vertex_binding_description.stride =
@@ -521,8 +686,8 @@ namespace am {
         color_blend_state.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
         color_blend_state.logicOpEnable = false;
         color_blend_state.logicOp = VK_LOGIC_OP_NO_OP;
-        color_blend_state.attachmentCount = (uint32)attachment_outputs.size();
-        color_blend_state.pAttachments = attachment_outputs.data();
+        color_blend_state.attachmentCount = (uint32)_shared->outputs.size();
+        color_blend_state.pAttachments = _shared->outputs.data();
         color_blend_state.blendConstants[0] = 0.0f;
         color_blend_state.blendConstants[1] = 0.0f;
         color_blend_state.blendConstants[2] = 0.0f;
@@ -537,75 +702,40 @@ namespace am {
         pipeline_dynamic_states.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
         pipeline_dynamic_states.dynamicStateCount = (uint32)dynamic_states.size();
         pipeline_dynamic_states.pDynamicStates = dynamic_states.data();
-        
-        std::vector<VkDescriptorSetLayout> set_layouts;
-        set_layouts.reserve(descriptor_layout.size());
-        result->_layout._set.reserve(descriptor_layout.size());
-        for (const auto& [_, descriptors] : descriptor_layout) {
-            SDescriptorSetLayout layout = {};
-            layout.handle = device->acquire_cached_item(descriptors);
-            AM_UNLIKELY_IF(!layout.handle) {
-                std::vector<VkDescriptorBindingFlags> flags;
-                flags.reserve(descriptors.size());
-                std::vector<VkDescriptorSetLayoutBinding> bindings;
-                bindings.reserve(descriptors.size());
-                for (const auto& binding : descriptors) {
-                    flags.emplace_back();
-                    AM_UNLIKELY_IF(binding.dynamic) {
-                        layout.dynamic = true;
-                        layout.binds = binding.count;
-                        flags.back() =
-                            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
-                            VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
-                    }
-                    bindings.push_back({
-                        .binding = binding.index,
-                        .descriptorType = binding.type,
-                        .descriptorCount = binding.count,
-                        .stageFlags = binding.stage,
-                        .pImmutableSamplers = nullptr
-                    });
-                }
 
-                VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags = {};
-                binding_flags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
-                binding_flags.bindingCount = (uint32)flags.size();
-                binding_flags.pBindingFlags = flags.data();
-
-                VkDescriptorSetLayoutCreateInfo layout_info = {};
-                layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-                layout_info.pNext = &binding_flags;
-                layout_info.bindingCount = (uint32)bindings.size();
-                layout_info.pBindings = bindings.data();
-                AM_VULKAN_CHECK(device->logger(), vkCreateDescriptorSetLayout(device->native(), &layout_info, nullptr, &layout.handle));
-                device->set_cached_item(descriptors, layout.handle);
+        SSpecializationData specialization;
+        auto pipeline_stages = _shared->stages;
+        AM_UNLIKELY_IF(!info.constants.empty()) {
+            make_specialization(specialization, info.constants);
+            for (auto& stage : pipeline_stages) {
+                stage.pSpecializationInfo = &specialization.info;
             }
-            result->_layout._set.emplace_back(layout);
-            set_layouts.emplace_back(layout.handle);
         }
 
-        std::vector<VkPushConstantRange> push_constant_ranges;
-        push_constant_ranges.reserve(push_constants.size());
-        for (const auto& [_, value] : push_constants) {
-            push_constant_ranges.emplace_back(value);
+        const auto* render_pass = info.framebuffer->render_pass();
+        std::vector<VkFormat> color_formats;
+        VkPipelineRenderingCreateInfo rendering_info = {};
+        rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        AM_LIKELY_IF(render_pass->is_dynamic()) {
+            for (const auto& attachment : render_pass->rendering_attachments()) {
+                AM_UNLIKELY_IF(attachment.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) {
+                    rendering_info.depthAttachmentFormat = attachment.format;
+                    AM_UNLIKELY_IF(attachment.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) {
+                        rendering_info.stencilAttachmentFormat = attachment.format;
+                    }
+                } else {
+                    color_formats.emplace_back(attachment.format);
+                }
+            }
+            rendering_info.colorAttachmentCount = (uint32)color_formats.size();
+            rendering_info.pColorAttachmentFormats = color_formats.data();
         }
 
-        VkPipelineLayoutCreateInfo pipeline_layout_info = {};
-        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipeline_layout_info.setLayoutCount = (uint32)set_layouts.size();
-        pipeline_layout_info.pSetLayouts = set_layouts.data();
-        pipeline_layout_info.pushConstantRangeCount = (uint32)push_constant_ranges.size();
-        pipeline_layout_info.pPushConstantRanges = push_constant_ranges.data();
-        AM_VULKAN_CHECK(device->logger(), vkCreatePipelineLayout(device->native(), &pipeline_layout_info, nullptr, &result->_layout._pipeline));
-
-        std::vector<VkPipelineShaderStageCreateInfo> pipeline_stages;
-        pipeline_stages.reserve(3);
-        pipeline_stages.emplace_back(vertex_stage);
-        if (should_create_geometry) { pipeline_stages.emplace_back(geometry_stage); }
-        if (should_create_fragment) { pipeline_stages.emplace_back(fragment_stage); }
-
         VkGraphicsPipelineCreateInfo pipeline_info = {};
         pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        AM_LIKELY_IF(render_pass->is_dynamic()) {
+            pipeline_info.pNext = &rendering_info;
+        }
         pipeline_info.stageCount = (uint32)pipeline_stages.size();
         pipeline_info.pStages = pipeline_stages.data();
         pipeline_info.pVertexInputState = &vertex_input_state;
@@ -617,24 +747,140 @@ namespace am {
         pipeline_info.pDepthStencilState = &depth_stencil_state;
         pipeline_info.pColorBlendState = &color_blend_state;
         pipeline_info.pDynamicState = &pipeline_dynamic_states;
-        pipeline_info.layout = result->_layout._pipeline;
-        pipeline_info.renderPass = info.framebuffer->render_pass()->native();
+        pipeline_info.layout = _layout._pipeline;
+        pipeline_info.renderPass = render_pass->native();
         pipeline_info.subpass = info.subpass;
         pipeline_info.basePipelineHandle = nullptr;
         pipeline_info.basePipelineIndex = -1;
 
-        AM_VULKAN_CHECK(device->logger(), vkCreateGraphicsPipelines(device->native(), nullptr, 1, &pipeline_info, nullptr, &result->_handle));
-        for (const auto& stage : pipeline_stages) {
-            vkDestroyShaderModule(device->native(), stage.module, nullptr);
+        // Parts are keyed by everything they are built from, legacy render passes fall back to a monolithic build since
+        // their handles say nothing about compatibility once recycled
+        AM_LIKELY_IF(device->feature_support(EDeviceFeature::GraphicsPipelineLibrary) && render_pass->is_dynamic()) {
+            uint64 layout_key = prv::hash(0, _shared->set_layouts);
+            for (const auto& each : _shared->push_constants) {
+                layout_key = prv::hash(layout_key, each.stageFlags, each.offset, each.size);
+            }
+            const auto pass_key = prv::hash(
+                0,
+                color_formats,
+                rendering_info.depthAttachmentFormat,
+                rendering_info.stencilAttachmentFormat,
+                multisampling_state.rasterizationSamples,
+                multisampling_state.sampleShadingEnable,
+                multisampling_state.minSampleShading,
+                multisampling_state.alphaToCoverageEnable,
+                multisampling_state.alphaToOneEnable,
+                info.states);
+            uint64 output_key = prv::hash(pass_key, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT);
+            for (const auto& each : _shared->outputs) {
+                output_key = prv::hash(output_key, each.blendEnable, each.colorWriteMask);
+            }
+            const auto constants_key = hash_constants(info.constants);
+            _libraries = {
+                prv::hash(pass_key, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, info.attributes),
+                prv::hash(
+                    pass_key,
+                    VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+                    layout_key,
+                    constants_key,
+                    _shared->code[0],
+                    _shared->code[1],
+                    fb_viewport.width,
+                    fb_viewport.height,
+                    info.cull),
+                prv::hash(
+                    pass_key,
+                    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+                    layout_key,
+                    constants_key,
+                    _shared->code[2],
+                    info.depth_test,
+                    info.depth_write),
+                output_key
+            };
+
+            // The same inputs through an unrelated hash, a part found under a key must also match its check
+            const auto layout_check = check_hash(0xcbf29ce484222325ull, _shared->set_layouts, _shared->push_constants);
+            const auto pass_check = check_hash(
+                0xcbf29ce484222325ull,
+                color_formats,
+                rendering_info.depthAttachmentFormat,
+                rendering_info.stencilAttachmentFormat,
+                multisampling_state.rasterizationSamples,
+                multisampling_state.sampleShadingEnable,
+                multisampling_state.minSampleShading,
+                multisampling_state.alphaToCoverageEnable,
+                multisampling_state.alphaToOneEnable,
+                info.states);
+            uint64 output_check = check_hash(pass_check, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT);
+            for (const auto& each : _shared->outputs) {
+                output_check = check_hash(output_check, each.blendEnable, each.colorWriteMask);
+            }
+            const std::array checks = {
+                check_hash(pass_check, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, info.attributes),
+                check_hash(
+                    pass_check,
+                    VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+                    layout_check,
+                    info.constants,
+                    _shared->code_check[0],
+                    _shared->code_check[1],
+                    fb_viewport.width,
+                    fb_viewport.height,
+                    info.cull),
+                check_hash(
+                    pass_check,
+                    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+                    layout_check,
+                    info.constants,
+                    _shared->code_check[2],
+                    info.depth_test,
+                    info.depth_write),
+                output_check
+            };
+            constexpr std::array parts = {
+                VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+                VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+                VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+                VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT
+            };
+            std::array<VkPipeline, parts.size()> libraries = {};
+            bool is_collision = false;
+            for (uint32 i = 0; i < parts.size(); ++i) {
+                libraries[i] = make_pipeline_library(
+                    device,
+                    pipeline_info,
+                    pipeline_layout_info,
+                    parts[i],
+                    _libraries[i],
+                    checks[i]);
+                is_collision |= !libraries[i];
+            }
+            // Colliding keys are rare enough that the whole pipeline is built monolithically instead
+            AM_UNLIKELY_IF(is_collision) {
+                for (uint32 i = 0; i < parts.size(); ++i) {
+                    AM_LIKELY_IF(libraries[i]) {
+                        device->release_pipeline_library(_libraries[i]);
+                    }
+                }
+                _libraries.clear();
+                AM_VULKAN_CHECK(device->logger(), vkCreateGraphicsPipelines(device->native(), device->pipeline_cache(), 1, &pipeline_info, nullptr, &_handle));
+                return;
+            }
+            _handle = link_pipeline_libraries(device, libraries, _layout._pipeline, false);
+            _link_task = std::make_unique<enki::TaskSet>(1, [this, device, libraries](enki::TaskSetPartition, uint32) noexcept {
+                _optimized.store(
+                    link_pipeline_libraries(device, libraries, _layout._pipeline, true),
+                    std::memory_order_release);
+            });
+            device->context()->scheduler()->AddTaskSetToPipe(_link_task.get());
+        } else {
+            AM_VULKAN_CHECK(device->logger(), vkCreateGraphicsPipelines(device->native(), device->pipeline_cache(), 1, &pipeline_info, nullptr, &_handle));
         }
-        result->_type = EPipelineType::Graphics;
-        result->_device = std::move(device);
-        return CRcPtr<Self>::make(result);
     }
 
     AM_NODISCARD CRcPtr<CPipeline> CPipeline::make(CRcPtr<CDevice> device, SComputeCreateInfo&& info) noexcept {
         AM_PROFILE_SCOPED();
-        auto* result = new Self();
         VkPipelineShaderStageCreateInfo compute_stage = {};
         compute_stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         compute_stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
@@ -645,10 +891,13 @@ namespace am {
             "- compute: {}",
             info.compute.string());
 
-        auto binary = compile_shader(std::move(info.compute), shaderc_compute_shader, device->logger());
-        AM_ASSERT(!binary.empty(), "cannot create compute pipeline without compute shader");
-        const auto compiler = spvc::CompilerGLSL(binary.data(), binary.size());
-        const auto resources = compiler.get_shader_resources();
+        const auto [binary, reflection] = device->shader_cache()->load(info.compute, EShaderStage::Compute);
+        AM_UNLIKELY_IF(binary.empty()) {
+            AM_LOG_ERROR(device->logger(), "cannot create compute pipeline, \"{}\" failed to load", info.compute.string());
+            return nullptr;
+        }
+        auto* result = new Self();
+        process_constants(result->_constants, reflection);
 
         VkShaderModuleCreateInfo module_create_info = {};
         module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -658,59 +907,31 @@ namespace am {
 
         std::map<std::string, VkPushConstantRange> push_constants;
         std::map<uint64, std::vector<SDescriptorBinding>> descriptor_layout;
-        process_resource(
-            device.get(),
-            descriptor_layout,
-            result->_bindings,
-            push_constants,
-            compiler,
-            resources.push_constant_buffers,
-            {},
-            VK_SHADER_STAGE_COMPUTE_BIT,
-            true);
-        process_resource(
-            device.get(),
-            descriptor_layout,
-            result->_bindings,
-            push_constants,
-            compiler,
-            resources.uniform_buffers,
-            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-            VK_SHADER_STAGE_COMPUTE_BIT);
-        process_resource(
+        process_resources(
             device.get(),
             descriptor_layout,
             result->_bindings,
             push_constants,
-            compiler,
-            resources.storage_buffers,
-            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            VK_SHADER_STAGE_COMPUTE_BIT);
-        process_resource(
-            device.get(),
-            descriptor_layout,
-            result->_bindings,
-            push_constants,
-            compiler,
-            resources.sampled_images,
-            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-            VK_SHADER_STAGE_COMPUTE_BIT);
-        process_resource(
-            device.get(),
-            descriptor_layout,
-            result->_bindings,
-            push_constants,
-            compiler,
-            resources.storage_images,
-            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            reflection,
             VK_SHADER_STAGE_COMPUTE_BIT);
 
         std::vector<VkDescriptorSetLayout> set_layouts;
         set_layouts.reserve(descriptor_layout.size());
         result->_layout._set.reserve(descriptor_layout.size());
-        for (const auto& [_, descriptors] : descriptor_layout) {
+        result->_layout._bindings.reserve(descriptor_layout.size());
+        for (const auto& [set, descriptors] : descriptor_layout) {
             SDescriptorSetLayout layout = {};
-            layout.handle = device->acquire_cached_item(descriptors);
+            // Known up front, a cache hit skips the loop below and variants or reloads always hit
+            for (const auto& binding : descriptors) {
+                AM_UNLIKELY_IF(binding.dynamic) {
+                    layout.dynamic = true;
+                    layout.binds = binding.count;
+                }
+            }
+            layout.handle = texture_heap_layout(device.get(), set, descriptors);
+            AM_LIKELY_IF(!layout.handle) {
+                layout.handle = device->acquire_cached_item(descriptors);
+            }
             AM_UNLIKELY_IF(!layout.handle) {
                 std::vector<VkDescriptorBindingFlags> flags;
                 flags.reserve(descriptors.size());
@@ -745,9 +966,15 @@ namespace am {
                 layout_info.bindingCount = (uint32)bindings.size();
                 layout_info.pBindings = bindings.data();
                 AM_VULKAN_CHECK(device->logger(), vkCreateDescriptorSetLayout(device->native(), &layout_info, nullptr, &layout.handle));
-                device->set_cached_item(descriptors, layout.handle);
+                const auto cached = device->set_cached_item(descriptors, layout.handle);
+                AM_UNLIKELY_IF(cached != layout.handle) {
+                    vkDestroyDescriptorSetLayout(device->native(), layout.handle, nullptr);
+                    layout.handle = cached;
+                }
             }
+            layout.update_template = make_update_template(device.get(), layout.handle, descriptors);
             result->_layout._set.emplace_back(layout);
+            result->_layout._bindings.emplace_back(descriptors);
             set_layouts.emplace_back(layout.handle);
         }
 
@@ -765,20 +992,43 @@ namespace am {
         pipeline_layout_info.pPushConstantRanges = push_constant_ranges.data();
         AM_VULKAN_CHECK(device->logger(), vkCreatePipelineLayout(device->native(), &pipeline_layout_info, nullptr, &result->_layout._pipeline));
 
-        VkComputePipelineCreateInfo pipeline_info = {};
-        pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-        pipeline_info.stage = compute_stage;
-        pipeline_info.layout = result->_layout._pipeline;
-        AM_VULKAN_CHECK(device->logger(), vkCreateComputePipelines(device->native(), nullptr, 1, &pipeline_info, nullptr, &result->_handle));
-        vkDestroyShaderModule(device->native(), compute_stage.module, nullptr);
-
+        auto shared = CRcPtr<SShared>::make(new SShared());
+        shared->stages.emplace_back(compute_stage);
+        shared->set_layouts = std::move(set_layouts);
+        shared->push_constants = std::move(push_constant_ranges);
+        shared->layout = result->_layout._pipeline;
+        shared->sets = result->_layout._set;
+        shared->device = device;
+        result->_shared = std::move(shared);
+        result->_compute_info = std::move(info);
         result->_type = EPipelineType::Compute;
         result->_device = std::move(device);
+        result->_create_compute();
         return CRcPtr<Self>::make(result);
     }
 
+    void CPipeline::_create_compute() noexcept {
+        AM_PROFILE_SCOPED();
+        SSpecializationData specialization;
+        VkComputePipelineCreateInfo pipeline_info = {};
+        pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipeline_info.stage = _shared->stages[0];
+        AM_UNLIKELY_IF(!_compute_info.constants.empty()) {
+            make_specialization(specialization, _compute_info.constants);
+            pipeline_info.stage.pSpecializationInfo = &specialization.info;
+        }
+        pipeline_info.layout = _layout._pipeline;
+        AM_VULKAN_CHECK(
+            _device->logger(),
+            vkCreateComputePipelines(_device->native(), _device->pipeline_cache(), 1, &pipeline_info, nullptr, &_handle));
+    }
+
     AM_NODISCARD VkPipeline CPipeline::native() const noexcept {
         AM_PROFILE_SCOPED();
+        const auto optimized = _optimized.load(std::memory_order_acquire);
+        AM_LIKELY_IF(optimized) {
+            return optimized;
+        }
         return _handle;
     }
 
@@ -804,4 +1054,140 @@ namespace am {
         AM_PROFILE_SCOPED();
         return _layout._set[index];
     }
+
+    AM_NODISCARD SBindingHandle CPipeline::binding_handle(const std::string& name) const noexcept {
+        AM_PROFILE_SCOPED();
+        const auto* binding = bindings(name);
+        AM_UNLIKELY_IF(!binding) {
+            return {};
+        }
+        return { binding->set, binding->index };
+    }
+
+    AM_NODISCARD const std::vector<SDescriptorBinding>& CPipeline::set_bindings(uint32 index) const noexcept {
+        AM_PROFILE_SCOPED();
+        return _layout._bindings[index];
+    }
+
+    AM_NODISCARD const SSpecializationConstant* CPipeline::constant(const std::string& name) const noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(!_constants.contains(name)) {
+            return nullptr;
+        }
+        return &_constants.at(name);
+    }
+
+    AM_NODISCARD CRcPtr<CPipeline> CPipeline::variant(std::vector<SSpecializationConstant> constants) noexcept {
+        AM_PROFILE_SCOPED();
+        std::sort(constants.begin(), constants.end(), [](const auto& lhs, const auto& rhs) noexcept {
+            return lhs.id < rhs.id;
+        });
+        const auto key = hash_constants(constants);
+        enki::TaskSet* task = nullptr;
+        {
+            std::lock_guard lock(_variant_lock);
+            auto& bucket = _variants[key];
+            const auto* cached = _find_variant(bucket, constants);
+            AM_LIKELY_IF(cached && cached->handle) {
+                return cached->handle;
+            }
+            AM_UNLIKELY_IF(!cached) {
+                auto& pending = bucket.emplace_back();
+                pending.constants = constants;
+                pending.task = std::make_unique<enki::TaskSet>(1, [this, key, constants = std::move(constants)](enki::TaskSetPartition, uint32) noexcept {
+                    auto result = _make_variant(constants);
+                    std::lock_guard lock(_variant_lock);
+                    auto* variant = _find_variant(_variants[key], constants);
+                    AM_LIKELY_IF(!variant->handle) {
+                        variant->handle = std::move(result);
+                    }
+                });
+                task = pending.task.get();
+            }
+        }
+        // Scheduled outside the lock, enki runs the task inline when its pipe is full
+        AM_UNLIKELY_IF(task) {
+            _device->context()->scheduler()->AddTaskSetToPipe(task);
+        }
+        return CRcPtr<Self>::make(this);
+    }
+
+    AM_NODISCARD CRcPtr<CPipeline> CPipeline::build_variant(std::vector<SSpecializationConstant> constants) noexcept {
+        AM_PROFILE_SCOPED();
+        std::sort(constants.begin(), constants.end(), [](const auto& lhs, const auto& rhs) noexcept {
+            return lhs.id < rhs.id;
+        });
+        const auto key = hash_constants(constants);
+        {
+            std::lock_guard lock(_variant_lock);
+            const auto* cached = _find_variant(_variants[key], constants);
+            AM_LIKELY_IF(cached && cached->handle) {
+                return cached->handle;
+            }
+        }
+        auto result = _make_variant(constants);
+        std::lock_guard lock(_variant_lock);
+        auto& bucket = _variants[key];
+        auto* variant = _find_variant(bucket, constants);
+        AM_LIKELY_IF(!variant) {
+            variant = &bucket.emplace_back();
+            variant->constants = std::move(constants);
+        }
+        // A pending build of the same variant keeps the one built here
+        AM_LIKELY_IF(!variant->handle) {
+            variant->handle = std::move(result);
+        }
+        return variant->handle;
+    }
+
+    AM_NODISCARD std::vector<std::vector<SSpecializationConstant>> CPipeline::variants() const noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard lock(_variant_lock);
+        std::vector<std::vector<SSpecializationConstant>> result;
+        result.reserve(_variants.size());
+        for (const auto& [_, bucket] : _variants) {
+            for (const auto& each : bucket) {
+                result.emplace_back(each.constants);
+            }
+        }
+        return result;
+    }
+
+    AM_NODISCARD CPipeline::SVariant* CPipeline::_find_variant(std::vector<SVariant>& bucket,
+                                                               const std::vector<SSpecializationConstant>& constants) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto found = std::find_if(bucket.begin(), bucket.end(), [&](const SVariant& each) noexcept {
+            return each.constants == constants;
+        });
+        AM_UNLIKELY_IF(found == bucket.end()) {
+            return nullptr;
+        }
+        return &*found;
+    }
+
+    AM_NODISCARD CRcPtr<CPipeline> CPipeline::_make_variant(const std::vector<SSpecializationConstant>& constants) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LOG_INFO(_device->logger(), "building pipeline variant: {:#018x}", hash_constants(constants));
+        auto* result = new Self();
+        result->_layout = _layout;
+        result->_bindings = _bindings;
+        result->_constants = _constants;
+        result->_type = _type;
+        result->_shared = _shared;
+        result->_device = _device;
+        switch (_type) {
+            case EPipelineType::Graphics:
+                result->_graphics_info = _graphics_info;
+                result->_graphics_info.constants = constants;
+                result->_create_graphics();
+                break;
+            case EPipelineType::Compute:
+                result->_compute_info = _compute_info;
+                result->_compute_info.constants = constants;
+                result->_create_compute();
+                break;
+            default: AM_UNREACHABLE();
+        }
+        return CRcPtr<Self>::make(result);
+    }
 } // namespace am
@@ -19,6 +19,7 @@ namespace am {
         query_pool_info.pipelineStatistics = prv::as_vulkan(info.statistics);
         AM_VULKAN_CHECK(device->logger(), vkCreateQueryPool(device->native(), &query_pool_info, nullptr, &result->_handle));
         result->_count = info.count;
+        result->_statistics = info.statistics;
         result->_device = std::move(device);
         return CRcPtr<Self>::make(result);
     }
@@ -33,6 +34,11 @@ namespace am {
         return _count;
     }
 
+    AM_NODISCARD EQueryPipelineStatistics CQueryPool::statistics() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _statistics;
+    }
+
     AM_NODISCARD std::vector<uint64> CQueryPool::results() const noexcept {
         AM_PROFILE_SCOPED();
         std::vector<uint64> result;
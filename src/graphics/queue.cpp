@@ -1,15 +1,63 @@
+#include <amethyst/graphics/completion_poller.hpp>
 #include <amethyst/graphics/command_buffer.hpp>
 #include <amethyst/graphics/swapchain.hpp>
 #include <amethyst/graphics/semaphore.hpp>
+#include <amethyst/graphics/recycler.hpp>
+#include <amethyst/graphics/context.hpp>
 #include <amethyst/graphics/device.hpp>
 #include <amethyst/graphics/queue.hpp>
 #include <amethyst/graphics/fence.hpp>
 
+#include <TaskScheduler.h>
+
+#include <algorithm>
+
 namespace am {
+    AM_NODISCARD static inline uint32 count_batches(std::span<const SQueueSubmitInfo> info) noexcept {
+        AM_PROFILE_SCOPED();
+        uint32 count = 1;
+        for (uint32 i = 1; i < info.size(); ++i) {
+            AM_ASSERT(info[i].batch >= info[i - 1].batch, "submit batches must not decrease");
+            AM_UNLIKELY_IF(info[i].batch != info[i - 1].batch) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    struct CQueue::SAcquireState {
+        struct SBufferAcquire {
+            const CQueue* source = nullptr;
+            uint64 value = 0;
+            SBufferMemoryBarrier barrier = {};
+        };
+
+        struct SImageAcquire {
+            const CQueue* source = nullptr;
+            uint64 value = 0;
+            SImageMemoryBarrier barrier = {};
+        };
+
+        std::vector<SBufferAcquire> buffers;
+        std::vector<SImageAcquire> images;
+        CBarrierBatch batch;
+        // Guarded by whichever lock assigns timeline values, "_lock" or "_pending_lock"
+        std::array<SQueueSubmitInfo, max_submit_infos> submit = {};
+        std::mutex lock;
+    };
+
     CQueue::CQueue() noexcept = default;
 
     CQueue::~CQueue() noexcept {
         AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(_thread.joinable()) {
+            _thread.request_stop();
+            _pending_signal.notify_all();
+            _thread.join();
+        }
+        // Command buffers free into the pools destroyed below
+        _in_flight.clear();
+        vkDestroySemaphore(_device->native(), _timeline, nullptr);
         vkDestroyCommandPool(_device->native(), _pool, nullptr);
         for (const auto& pool : _transient) {
             vkDestroyCommandPool(_device->native(), pool->_handle, nullptr);
@@ -34,14 +82,33 @@ namespace am {
         AM_VULKAN_CHECK(device->logger(), vkCreateCommandPool(device->native(), &command_pool_info, nullptr, &result->_pool));
 
         command_pool_info.flags |= VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-        const auto threads = std::thread::hardware_concurrency();
-        result->_transient.reserve(threads);
-        for (uint32 i = 0; i < threads; ++i) {
+        result->_transient.reserve(info.threads);
+        for (uint32 i = 0; i < info.threads; ++i) {
             auto& pool = result->_transient.emplace_back(std::make_unique<SThreadSafePool>());
             AM_VULKAN_CHECK(device->logger(), vkCreateCommandPool(device->native(), &command_pool_info, nullptr, &pool->_handle));
         }
+        VkSemaphoreTypeCreateInfo timeline_type = {};
+        timeline_type.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timeline_type.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timeline_type.initialValue = 0;
+        VkSemaphoreCreateInfo timeline_info = {};
+        timeline_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        timeline_info.pNext = &timeline_type;
+        AM_VULKAN_CHECK(device->logger(), vkCreateSemaphore(device->native(), &timeline_info, nullptr, &result->_timeline));
         result->_logger = std::move(logger);
         result->_device = device;
+        result->_acquires = std::make_unique<SAcquireState>();
+        AM_UNLIKELY_IF(info.submission_thread) {
+            // Both vectors swap on the submission thread and keep their capacity
+            result->_incoming.reserve(max_in_flight_submits);
+            result->_in_flight.reserve(info.threads);
+            for (uint32 i = 0; i < info.threads; ++i) {
+                result->_in_flight.emplace_back(std::make_unique<SInFlightRing>());
+            }
+            result->_thread = std::jthread([queue = result](std::stop_token token) noexcept {
+                queue->_run(std::move(token));
+            });
+        }
         return result;
     }
 
@@ -50,6 +117,11 @@ namespace am {
         return _family.family;
     }
 
+    AM_NODISCARD uint32 CQueue::threads() const noexcept {
+        AM_PROFILE_SCOPED();
+        return (uint32)_transient.size();
+    }
+
     AM_NODISCARD VkQueue CQueue::native() const noexcept {
         AM_PROFILE_SCOPED();
         return _handle;
@@ -75,49 +147,94 @@ namespace am {
         _transient[thread]->_lock.unlock();
     }
 
+    AM_NODISCARD VkSemaphore CQueue::timeline() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _timeline;
+    }
+
+    AM_NODISCARD uint64 CQueue::submitted() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _submitted.load(std::memory_order_acquire);
+    }
+
+    AM_NODISCARD uint64 CQueue::completed() const noexcept {
+        AM_PROFILE_SCOPED();
+        uint64 value = 0;
+        AM_VULKAN_CHECK(_logger, vkGetSemaphoreCounterValue(_device->native(), _timeline, &value));
+        return value;
+    }
+
+    AM_NODISCARD bool CQueue::is_complete(uint64 value) const noexcept {
+        AM_PROFILE_SCOPED();
+        return completed() >= value;
+    }
+
+    void CQueue::wait(uint64 value) const noexcept {
+        AM_PROFILE_SCOPED();
+        VkSemaphoreWaitInfo wait_info = {};
+        wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        wait_info.semaphoreCount = 1;
+        wait_info.pSemaphores = &_timeline;
+        wait_info.pValues = &value;
+        AM_VULKAN_CHECK(_logger, vkWaitSemaphores(_device->native(), &wait_info, (uint64)-1));
+    }
+
     void CQueue::wait_idle() noexcept {
         AM_PROFILE_SCOPED();
+        _flush_submissions();
         std::lock_guard guard(_lock);
         AM_VULKAN_CHECK(_device->logger(), vkQueueWaitIdle(_handle));
     }
 
-    void CQueue::submit(std::vector<SQueueSubmitInfo>&& info, CFence* fence) noexcept {
-        AM_PROFILE_SCOPED();
-        std::vector<VkPipelineStageFlags> stage_masks;
-        stage_masks.reserve(info.size());
-        std::vector<VkCommandBuffer> commands;
-        commands.reserve(info.size());
-        std::vector<VkSemaphore> waits;
-        waits.reserve(info.size());
-        std::vector<VkSemaphore> signals;
-        signals.reserve(info.size());
-        for (auto&& [stage_mask, command, wait, signal] : info) {
-            AM_LIKELY_IF(command) {
-                commands.emplace_back(command->native());
-            }
-            AM_LIKELY_IF(wait) {
-                waits.emplace_back(wait->native());
-                stage_masks.emplace_back(prv::as_vulkan(stage_mask));
-            }
-            AM_LIKELY_IF(signal) {
-                signals.emplace_back(signal->native());
-            }
-        }
-        VkSubmitInfo submit_info = {};
-        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit_info.waitSemaphoreCount = (uint32)waits.size();
-        submit_info.pWaitSemaphores = waits.data();
-        submit_info.pWaitDstStageMask = stage_masks.data();
-        submit_info.commandBufferCount = (uint32)commands.size();
-        submit_info.pCommandBuffers = commands.data();
-        submit_info.signalSemaphoreCount = (uint32)signals.size();
-        submit_info.pSignalSemaphores = signals.data();
-        VkFence n_fence = nullptr;
-        AM_LIKELY_IF(fence) {
-            n_fence = fence->native();
+    uint64 CQueue::submit(std::initializer_list<SQueueSubmitInfo> info, CFence* fence) noexcept {
+        AM_PROFILE_SCOPED();
+        return submit(std::span(info.begin(), info.size()), fence);
+    }
+
+    uint64 CQueue::submit(std::span<const SQueueSubmitInfo> info, CFence* fence) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_ASSERT(info.size() <= max_submit_infos, "too many submit infos");
+        const auto thread = _device->context()->scheduler()->GetThreadNum();
+        // The prepended acquires keep their command buffer alive on their own
+        const auto submitted = info;
+        CRcPtr<CCommandBuffer> acquire_commands;
+        uint64 value = 0;
+        AM_LIKELY_IF(!_thread.joinable()) {
+            std::lock_guard guard(_lock);
+            // Acquires are taken under the lock assigning values, no later submission can run ahead of them
+            info = _prepend_acquires(info, acquire_commands, thread);
+            const auto batches = count_batches(info);
+            AM_ASSERT(batches <= max_submit_batches, "too many submit batches");
+            // Values must increase in submission order, so they are only assigned under the queue lock
+            value = _submitted.load(std::memory_order_relaxed) + batches;
+            _submit(info, fence, value);
+            _submitted.store(value, std::memory_order_release);
+        } else {
+            {
+                // The submission thread drains in order, assigning values under the same lock keeps them increasing
+                std::lock_guard guard(_pending_lock);
+                info = _prepend_acquires(info, acquire_commands, thread);
+                const auto batches = count_batches(info);
+                AM_ASSERT(batches <= max_submit_batches, "too many submit batches");
+                value = _submitted.load(std::memory_order_relaxed) + batches;
+                auto& pending = _incoming.emplace_back();
+                std::copy(info.begin(), info.end(), pending.info.begin());
+                pending.count = (uint32)info.size();
+                pending.fence = fence;
+                pending.value = value;
+                _submitted.store(value, std::memory_order_release);
+            }
+            _pending_signal.notify_one();
+            _track_in_flight(submitted, fence, value, thread);
         }
-        std::lock_guard guard(_lock);
-        AM_VULKAN_CHECK(_device->logger(), vkQueueSubmit(_handle, 1, &submit_info, n_fence));
+        AM_UNLIKELY_IF(acquire_commands) {
+            _device->completion_poller()->enqueue(this, value, thread, [
+                commands = std::move(acquire_commands)
+            ]() mutable noexcept {
+                commands.reset();
+            });
+        }
+        return value;
     }
 
     void CQueue::immediate_submit(std::function<void(CCommandBuffer&)>&& func) noexcept {
@@ -129,9 +246,26 @@ namespace am {
         commands->begin();
         func(*commands);
         commands->end();
-        auto fence = CFence::make(CRcPtr<CDevice>::make(_device), false);
-        submit({ { .command = commands.get() } }, fence.get());
-        fence->wait();
+        wait(submit({ { .command = commands.get() } }));
+    }
+
+    void CQueue::acquire(const CQueue& source, uint64 value, const SBufferMemoryBarrier& barrier) noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_acquires->lock);
+        _acquires->buffers.push_back({ &source, value, barrier });
+        _pending_acquires.fetch_add(1, std::memory_order_release);
+    }
+
+    void CQueue::acquire(const CQueue& source, uint64 value, const SImageMemoryBarrier& barrier) noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_acquires->lock);
+        _acquires->images.push_back({ &source, value, barrier });
+        _pending_acquires.fetch_add(1, std::memory_order_release);
+    }
+
+    AM_NODISCARD uint32 CQueue::pending_acquires() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _pending_acquires.load(std::memory_order_acquire);
     }
 
     void CQueue::present(SQueuePresentInfo&& info) noexcept {
@@ -147,6 +281,7 @@ namespace am {
         present_info.pSwapchains = &swapchain;
         present_info.pImageIndices = &info.image;
         present_info.pResults = &result;
+        _flush_submissions();
         std::lock_guard guard(_lock);
         vkQueuePresentKHR(_handle, &present_info);
         AM_UNLIKELY_IF(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_ERROR_SURFACE_LOST_KHR) {
@@ -155,4 +290,278 @@ namespace am {
         }
         AM_VULKAN_CHECK(_logger, result);
     }
+
+    AM_NODISCARD std::span<const SQueueSubmitInfo> CQueue::_prepend_acquires(
+        std::span<const SQueueSubmitInfo> info,
+        CRcPtr<CCommandBuffer>& commands,
+        uint32 thread) noexcept {
+        AM_PROFILE_SCOPED();
+        // Recycled command buffers are per scheduler thread, other threads leave the acquires to a later submission
+        AM_LIKELY_IF(_pending_acquires.load(std::memory_order_acquire) == 0 || thread >= threads()) {
+            return info;
+        }
+        // At most one source per queue type, each is waited on up to its newest retired release
+        std::array<const CQueue*, 3> sources = {};
+        std::array<uint64, 3> completed = {};
+        std::array<uint64, 3> waits = {};
+        uint32 source_count = 0;
+        const auto find_source = [&](const CQueue* source) noexcept {
+            for (uint32 i = 0; i < source_count; ++i) {
+                AM_LIKELY_IF(sources[i] == source) {
+                    return i;
+                }
+            }
+            AM_ASSERT(source_count < sources.size(), "too many acquire sources");
+            sources[source_count] = source;
+            completed[source_count] = source->completed();
+            return source_count++;
+        };
+        auto& state = *_acquires;
+        std::lock_guard guard(state.lock);
+        uint32 retired = 0;
+        const auto retire = [&](const auto& each) noexcept {
+            const auto index = find_source(each.source);
+            AM_LIKELY_IF(completed[index] < each.value) {
+                return false;
+            }
+            waits[index] = std::max(waits[index], each.value);
+            // Within one family the release already did the whole transition, the timeline wait orders the rest
+            AM_LIKELY_IF(each.source->family() != _family.family) {
+                state.batch.transfer_ownership(*each.source, *this, each.barrier);
+            }
+            retired++;
+            return true;
+        };
+        std::erase_if(state.buffers, retire);
+        std::erase_if(state.images, retire);
+        AM_LIKELY_IF(retired == 0) {
+            return info;
+        }
+        _pending_acquires.fetch_sub(retired, std::memory_order_release);
+        AM_LIKELY_IF(!state.batch.empty()) {
+            commands = _device->recycler()->acquire_command_buffer(_type, thread);
+            commands->begin()
+                .barrier(state.batch)
+                .end();
+        }
+        // Prepended to the first batch, its command buffers run after the acquires in submission order
+        const auto batch = info.empty() ? 0 : info[0].batch;
+        uint32 count = 0;
+        for (uint32 i = 0; i < source_count; ++i) {
+            AM_UNLIKELY_IF(waits[i] == 0) {
+                continue;
+            }
+            state.submit[count++] = {
+                .stage_mask = EPipelineStage::AllCommands,
+                .wait_queue = sources[i],
+                .wait_queue_value = waits[i],
+                .batch = batch
+            };
+        }
+        AM_UNLIKELY_IF(count == 0) {
+            state.submit[count++] = { .batch = batch };
+        }
+        state.submit[0].command = commands.get();
+        AM_ASSERT(count + info.size() <= max_submit_infos, "too many submit infos with pending acquires");
+        std::copy(info.begin(), info.end(), state.submit.begin() + count);
+        return std::span<const SQueueSubmitInfo>(state.submit.data(), count + info.size());
+    }
+
+    void CQueue::_submit(std::span<const SQueueSubmitInfo> info, CFence* fence, uint64 value) noexcept {
+        AM_PROFILE_SCOPED();
+        // Everything lives on the stack, the queue lock is held by the caller
+        std::array<VkCommandBufferSubmitInfo, max_submit_infos> commands;
+        std::array<VkSemaphoreSubmitInfo, max_submit_infos * 2> waits;
+        std::array<VkSemaphoreSubmitInfo, max_submit_infos + max_submit_batches> signals;
+        std::array<VkSubmitInfo2, max_submit_batches> batches;
+        uint32 command_count = 0;
+        uint32 wait_count = 0;
+        uint32 signal_count = 0;
+        uint32 batch_count = 0;
+        const auto add_semaphore = [](VkSemaphoreSubmitInfo& semaphore, VkSemaphore handle, uint64 wait_value, VkPipelineStageFlags2 stage) noexcept {
+            semaphore = {};
+            semaphore.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+            semaphore.semaphore = handle;
+            semaphore.value = wait_value;
+            semaphore.stageMask = stage;
+        };
+        const auto first_value = value + 1 - count_batches(info);
+        const auto close_batch = [&]() noexcept {
+            add_semaphore(signals[signal_count++], _timeline, first_value + batch_count, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+            auto& batch = batches[batch_count++];
+            batch = {};
+            batch.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+            batch.waitSemaphoreInfoCount = wait_count;
+            batch.pWaitSemaphoreInfos = waits.data();
+            batch.commandBufferInfoCount = command_count;
+            batch.pCommandBufferInfos = commands.data();
+            batch.signalSemaphoreInfoCount = signal_count;
+            batch.pSignalSemaphoreInfos = signals.data();
+            // Counts are cumulative until fixed up below
+        };
+        for (uint32 i = 0; i < info.size(); ++i) {
+            const auto& each = info[i];
+            AM_LIKELY_IF(each.command) {
+                auto& command = commands[command_count++];
+                command = {};
+                command.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+                command.commandBuffer = each.command->native();
+            }
+            AM_LIKELY_IF(each.wait) {
+                add_semaphore(waits[wait_count++], each.wait->native(), each.wait_value, prv::as_vulkan(each.stage_mask));
+            }
+            AM_UNLIKELY_IF(each.wait_queue) {
+                add_semaphore(waits[wait_count++], each.wait_queue->timeline(), each.wait_queue_value, prv::as_vulkan(each.stage_mask));
+            }
+            AM_LIKELY_IF(each.signal) {
+                add_semaphore(signals[signal_count++], each.signal->native(), each.signal_value, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+            }
+            AM_UNLIKELY_IF(i + 1 == info.size() || info[i + 1].batch != each.batch) {
+                close_batch();
+            }
+        }
+        AM_UNLIKELY_IF(info.empty()) {
+            close_batch();
+        }
+        // Turn the cumulative counts into per-batch ranges
+        for (uint32 i = batch_count; i-- > 1;) {
+            auto& batch = batches[i];
+            const auto& previous = batches[i - 1];
+            batch.pWaitSemaphoreInfos += previous.waitSemaphoreInfoCount;
+            batch.waitSemaphoreInfoCount -= previous.waitSemaphoreInfoCount;
+            batch.pCommandBufferInfos += previous.commandBufferInfoCount;
+            batch.commandBufferInfoCount -= previous.commandBufferInfoCount;
+            batch.pSignalSemaphoreInfos += previous.signalSemaphoreInfoCount;
+            batch.signalSemaphoreInfoCount -= previous.signalSemaphoreInfoCount;
+        }
+        VkFence n_fence = nullptr;
+        AM_LIKELY_IF(fence) {
+            n_fence = fence->native();
+        }
+        AM_LIKELY_IF(_device->feature_support(EDeviceFeature::Synchronization2)) {
+            AM_VULKAN_CHECK(_device->logger(), vkQueueSubmit2(_handle, batch_count, batches.data(), n_fence));
+            return;
+        }
+        // Devices without synchronization2 get the same batches translated
+        std::array<VkSemaphore, max_submit_infos * 2> wait_handles;
+        std::array<uint64, max_submit_infos * 2> wait_values;
+        std::array<VkPipelineStageFlags, max_submit_infos * 2> stage_masks;
+        std::array<VkCommandBuffer, max_submit_infos> command_handles;
+        std::array<VkSemaphore, max_submit_infos + max_submit_batches> signal_handles;
+        std::array<uint64, max_submit_infos + max_submit_batches> signal_values;
+        std::array<VkTimelineSemaphoreSubmitInfo, max_submit_batches> timeline_infos;
+        std::array<VkSubmitInfo, max_submit_batches> submit_infos;
+        for (uint32 i = 0; i < wait_count; ++i) {
+            wait_handles[i] = waits[i].semaphore;
+            wait_values[i] = waits[i].value;
+            stage_masks[i] = (VkPipelineStageFlags)waits[i].stageMask;
+        }
+        for (uint32 i = 0; i < command_count; ++i) {
+            command_handles[i] = commands[i].commandBuffer;
+        }
+        for (uint32 i = 0; i < signal_count; ++i) {
+            signal_handles[i] = signals[i].semaphore;
+            signal_values[i] = signals[i].value;
+        }
+        for (uint32 i = 0; i < batch_count; ++i) {
+            const auto& batch = batches[i];
+            const auto wait_offset = (uint32)(batch.pWaitSemaphoreInfos - waits.data());
+            const auto command_offset = (uint32)(batch.pCommandBufferInfos - commands.data());
+            const auto signal_offset = (uint32)(batch.pSignalSemaphoreInfos - signals.data());
+            auto& timeline_info = timeline_infos[i];
+            timeline_info = {};
+            timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timeline_info.waitSemaphoreValueCount = batch.waitSemaphoreInfoCount;
+            timeline_info.pWaitSemaphoreValues = wait_values.data() + wait_offset;
+            timeline_info.signalSemaphoreValueCount = batch.signalSemaphoreInfoCount;
+            timeline_info.pSignalSemaphoreValues = signal_values.data() + signal_offset;
+            auto& submit_info = submit_infos[i];
+            submit_info = {};
+            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submit_info.pNext = &timeline_info;
+            submit_info.waitSemaphoreCount = batch.waitSemaphoreInfoCount;
+            submit_info.pWaitSemaphores = wait_handles.data() + wait_offset;
+            submit_info.pWaitDstStageMask = stage_masks.data() + wait_offset;
+            submit_info.commandBufferCount = batch.commandBufferInfoCount;
+            submit_info.pCommandBuffers = command_handles.data() + command_offset;
+            submit_info.signalSemaphoreCount = batch.signalSemaphoreInfoCount;
+            submit_info.pSignalSemaphores = signal_handles.data() + signal_offset;
+        }
+        AM_VULKAN_CHECK(_device->logger(), vkQueueSubmit(_handle, batch_count, submit_infos.data(), n_fence));
+    }
+
+    void CQueue::_flush_submissions() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(!_thread.joinable()) {
+            return;
+        }
+        std::unique_lock lock(_pending_lock);
+        _flushed_signal.wait(lock, [this]() noexcept {
+            return _flushed == _submitted.load(std::memory_order_relaxed);
+        });
+    }
+
+    void CQueue::_track_in_flight(std::span<const SQueueSubmitInfo> info, CFence* fence, uint64 value, uint32 thread) noexcept {
+        AM_PROFILE_SCOPED();
+        // Threads outside the scheduler own no ring, they keep what they submit alive until it completes
+        AM_UNLIKELY_IF(thread >= _in_flight.size()) {
+            return;
+        }
+        auto& ring = *_in_flight[thread];
+        const auto completed = this->completed();
+        while (ring.count != 0) {
+            auto& oldest = ring.entries[ring.head];
+            AM_LIKELY_IF(oldest.value > completed) {
+                AM_LIKELY_IF(ring.count < max_in_flight_submits) {
+                    break;
+                }
+                wait(oldest.value);
+            }
+            oldest = {};
+            ring.head = (ring.head + 1) % max_in_flight_submits;
+            ring.count--;
+        }
+        auto& entry = ring.entries[(ring.head + ring.count) % max_in_flight_submits];
+        for (uint32 i = 0; i < info.size(); ++i) {
+            entry.commands[i] = CRcPtr<CCommandBuffer>::make(info[i].command);
+            entry.semaphores[i * 2] = CRcPtr<CSemaphore>::make(info[i].wait);
+            entry.semaphores[i * 2 + 1] = CRcPtr<CSemaphore>::make(info[i].signal);
+        }
+        entry.fence = CRcPtr<CFence>::make(fence);
+        entry.value = value;
+        ring.count++;
+    }
+
+    void CQueue::_run(std::stop_token token) noexcept {
+        AM_PROFILE_SCOPED();
+        std::vector<SPendingSubmit> active;
+        while (true) {
+            {
+                std::unique_lock lock(_pending_lock);
+                _pending_signal.wait(lock, token, [this]() noexcept {
+                    return !_incoming.empty();
+                });
+                // Both vectors keep their capacity, steady state submissions don't allocate
+                std::swap(active, _incoming);
+            }
+            // Pending submissions are always issued, their fences and semaphores are waited on elsewhere
+            AM_UNLIKELY_IF(active.empty() && token.stop_requested()) {
+                break;
+            }
+            uint64 value = 0;
+            {
+                std::lock_guard guard(_lock);
+                for (const auto& pending : active) {
+                    _submit(std::span(pending.info.data(), pending.count), pending.fence, pending.value);
+                    value = pending.value;
+                }
+            }
+            active.clear();
+            AM_LIKELY_IF(value != 0) {
+                std::lock_guard lock(_pending_lock);
+                _flushed = value;
+            }
+            _flushed_signal.notify_all();
+        }
+    }
 } // namespace am
@@ -0,0 +1,218 @@
+#include <amethyst/graphics/command_buffer.hpp>
+#include <amethyst/graphics/semaphore.hpp>
+#include <amethyst/graphics/recycler.hpp>
+#include <amethyst/graphics/context.hpp>
+#include <amethyst/graphics/device.hpp>
+#include <amethyst/graphics/fence.hpp>
+
+#include <TaskScheduler.h>
+
+namespace am {
+    CRecycler::CRecycler() noexcept = default;
+
+    CRecycler::~CRecycler() noexcept {
+        AM_PROFILE_SCOPED();
+        for (uint32 thread = 0; thread < _caches.size(); ++thread) {
+            auto& cache = *_caches[thread];
+            cache.fence_inbox.drain([&](VkFence fence) noexcept {
+                cache.fences.emplace_back(fence);
+            });
+            cache.semaphore_inbox.drain([&](VkSemaphore semaphore) noexcept {
+                cache.semaphores.emplace_back(semaphore);
+            });
+            for (const auto& fence : cache.fences) {
+                vkDestroyFence(_device->native(), fence, nullptr);
+            }
+            for (const auto& semaphore : cache.semaphores) {
+                vkDestroySemaphore(_device->native(), semaphore, nullptr);
+            }
+            for (uint32 type = 0; type < queue_types; ++type) {
+                auto& commands = cache.commands[type];
+                cache.command_inbox[type].drain([&](VkCommandBuffer command) noexcept {
+                    commands.emplace_back(command);
+                });
+                AM_UNLIKELY_IF(commands.empty()) {
+                    continue;
+                }
+                const auto pool = _queue((EQueueType)type)->transient_pool(thread);
+                vkFreeCommandBuffers(_device->native(), pool, (uint32)commands.size(), commands.data());
+            }
+        }
+    }
+
+    AM_NODISCARD std::unique_ptr<CRecycler> CRecycler::make(CDevice* device, uint32 threads) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = std::unique_ptr<Self>(new Self());
+        result->_caches.reserve(threads);
+        for (uint32 i = 0; i < threads; ++i) {
+            result->_caches.emplace_back(std::make_unique<SThreadCache>());
+        }
+        result->_device = device;
+        return result;
+    }
+
+    AM_NODISCARD CRcPtr<CFence> CRecycler::acquire_fence() noexcept {
+        AM_PROFILE_SCOPED();
+        const auto thread = _current_thread();
+        const auto owned = thread < _caches.size();
+        auto& cache = *_caches[owned ? thread : 0];
+        AM_UNLIKELY_IF(owned && cache.fences.empty()) {
+            cache.fence_inbox.drain([&](VkFence fence) noexcept {
+                cache.fences.emplace_back(fence);
+            });
+        }
+        auto* result = new CFence();
+        AM_LIKELY_IF(owned && !cache.fences.empty()) {
+            result->_handle = cache.fences.back();
+            cache.fences.pop_back();
+            cache.fence_counters.hits.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            VkFenceCreateInfo fence_info = {};
+            fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            AM_VULKAN_CHECK(_device->logger(), vkCreateFence(_device->native(), &fence_info, nullptr, &result->_handle));
+            cache.fence_counters.creations.fetch_add(1, std::memory_order_relaxed);
+        }
+        result->_recycled = true;
+        result->_device = CRcPtr<CDevice>::make(_device);
+        return CRcPtr<CFence>::make(result);
+    }
+
+    AM_NODISCARD CRcPtr<CSemaphore> CRecycler::acquire_semaphore() noexcept {
+        AM_PROFILE_SCOPED();
+        const auto thread = _current_thread();
+        const auto owned = thread < _caches.size();
+        auto& cache = *_caches[owned ? thread : 0];
+        AM_UNLIKELY_IF(owned && cache.semaphores.empty()) {
+            cache.semaphore_inbox.drain([&](VkSemaphore semaphore) noexcept {
+                cache.semaphores.emplace_back(semaphore);
+            });
+        }
+        auto* result = new CSemaphore();
+        AM_LIKELY_IF(owned && !cache.semaphores.empty()) {
+            result->_handle = cache.semaphores.back();
+            cache.semaphores.pop_back();
+            cache.semaphore_counters.hits.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            VkSemaphoreCreateInfo semaphore_info = {};
+            semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            AM_VULKAN_CHECK(_device->logger(), vkCreateSemaphore(_device->native(), &semaphore_info, nullptr, &result->_handle));
+            cache.semaphore_counters.creations.fetch_add(1, std::memory_order_relaxed);
+        }
+        result->_recycled = true;
+        result->_device = CRcPtr<CDevice>::make(_device);
+        return CRcPtr<CSemaphore>::make(result);
+    }
+
+    AM_NODISCARD CRcPtr<CCommandBuffer> CRecycler::acquire_command_buffer(EQueueType type, uint32 thread) noexcept {
+        AM_PROFILE_SCOPED();
+        // Transient pools are not externally synchronized, only their owning thread may touch them
+        AM_ASSERT(thread == _current_thread(), "command buffers must be acquired on the thread owning the pool");
+        auto& cache = *_caches[thread];
+        auto& commands = cache.commands[(uint32)type];
+        auto* queue = _queue(type);
+        const auto pool = queue->transient_pool(thread);
+        AM_UNLIKELY_IF(commands.empty()) {
+            queue->lock_pool(thread);
+            cache.command_inbox[(uint32)type].drain([&](VkCommandBuffer command) noexcept {
+                vkResetCommandBuffer(command, 0);
+                commands.emplace_back(command);
+            });
+            queue->unlock_pool(thread);
+        }
+        auto* result = new CCommandBuffer();
+        AM_LIKELY_IF(!commands.empty()) {
+            result->_handle = commands.back();
+            commands.pop_back();
+            cache.command_counters.hits.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            VkCommandBufferAllocateInfo allocate_info = {};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = pool;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandBufferCount = 1;
+            queue->lock_pool(thread);
+            AM_VULKAN_CHECK(_device->logger(), vkAllocateCommandBuffers(_device->native(), &allocate_info, &result->_handle));
+            queue->unlock_pool(thread);
+            cache.command_counters.creations.fetch_add(1, std::memory_order_relaxed);
+        }
+        result->_pool = pool;
+        result->_queue = type;
+        result->_pool_type = ECommandPoolType::Transient;
+        result->_index = thread;
+        result->_recycled = true;
+        result->_device = CRcPtr<CDevice>::make(_device);
+        return CRcPtr<CCommandBuffer>::make(result);
+    }
+
+    void CRecycler::recycle_fence(VkFence fence) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_VULKAN_CHECK(_device->logger(), vkResetFences(_device->native(), 1, &fence));
+        const auto thread = _current_thread();
+        AM_LIKELY_IF(thread < _caches.size()) {
+            _caches[thread]->fences.emplace_back(fence);
+        } else {
+            _caches[0]->fence_inbox.push(std::move(fence));
+        }
+    }
+
+    void CRecycler::recycle_semaphore(VkSemaphore semaphore) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto thread = _current_thread();
+        AM_LIKELY_IF(thread < _caches.size()) {
+            _caches[thread]->semaphores.emplace_back(semaphore);
+        } else {
+            _caches[0]->semaphore_inbox.push(std::move(semaphore));
+        }
+    }
+
+    void CRecycler::recycle_command_buffer(EQueueType type, uint32 thread, VkCommandBuffer command) noexcept {
+        AM_PROFILE_SCOPED();
+        auto& cache = *_caches[thread];
+        AM_LIKELY_IF(thread == _current_thread()) {
+            // Uncontended unless a CCommandBuffer is being made from this pool elsewhere
+            auto* queue = _queue(type);
+            queue->lock_pool(thread);
+            vkResetCommandBuffer(command, 0);
+            queue->unlock_pool(thread);
+            cache.commands[(uint32)type].emplace_back(command);
+        } else {
+            // Reset later by the owning thread, the pool may be in use right now
+            cache.command_inbox[(uint32)type].push(std::move(command));
+        }
+    }
+
+    AM_NODISCARD SRecyclerStats CRecycler::stats() const noexcept {
+        AM_PROFILE_SCOPED();
+        SRecyclerStats result = {};
+        const auto accumulate = [](SRecyclerCounters& dest, const SCounters& source) noexcept {
+            dest.hits += source.hits.load(std::memory_order_relaxed);
+            dest.creations += source.creations.load(std::memory_order_relaxed);
+        };
+        for (const auto& cache : _caches) {
+            accumulate(result.fences, cache->fence_counters);
+            accumulate(result.semaphores, cache->semaphore_counters);
+            accumulate(result.commands, cache->command_counters);
+        }
+        return result;
+    }
+
+    AM_NODISCARD uint32 CRecycler::_current_thread() const noexcept {
+        AM_PROFILE_SCOPED();
+        // Threads unknown to the scheduler (e.g. the completion poller) map past the end of "_caches"
+        const auto thread = _device->context()->scheduler()->GetThreadNum();
+        AM_UNLIKELY_IF(thread >= _caches.size()) {
+            return (uint32)_caches.size();
+        }
+        return thread;
+    }
+
+    AM_NODISCARD CQueue* CRecycler::_queue(EQueueType type) const noexcept {
+        AM_PROFILE_SCOPED();
+        switch (type) {
+            case EQueueType::Graphics: return _device->graphics_queue();
+            case EQueueType::Transfer: return _device->transfer_queue();
+            case EQueueType::Compute: return _device->compute_queue();
+        }
+        AM_UNREACHABLE();
+    }
+} // namespace am
@@ -0,0 +1,534 @@
+#include <amethyst/graphics/render_graph.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace am {
+    CRenderGraph::CRenderGraph() noexcept = default;
+
+    CRenderGraph::~CRenderGraph() noexcept {
+        AM_PROFILE_SCOPED();
+        _destroy_transients();
+    }
+
+    AM_NODISCARD CRcPtr<CRenderGraph> CRenderGraph::make(CRcPtr<CDevice> device) noexcept {
+        AM_PROFILE_SCOPED();
+        auto* result = new Self();
+        result->_device = std::move(device);
+        return CRcPtr<Self>::make(result);
+    }
+
+    AM_NODISCARD uint32 CRenderGraph::import_image(SRenderGraphImageInfo&& info) noexcept {
+        AM_PROFILE_SCOPED();
+        auto& resource = _resources.emplace_back();
+        resource.is_image = true;
+        resource.image = info.image;
+        resource.state = info;
+        return (uint32)_resources.size() - 1;
+    }
+
+    AM_NODISCARD uint32 CRenderGraph::import_buffer(SRenderGraphBufferInfo&& info) noexcept {
+        AM_PROFILE_SCOPED();
+        auto& resource = _resources.emplace_back();
+        resource.buffer = info.buffer;
+        resource.state.stage = info.stage;
+        resource.state.access = info.access;
+        resource.state.final_stage = info.final_stage;
+        resource.state.final_access = info.final_access;
+        return (uint32)_resources.size() - 1;
+    }
+
+    AM_NODISCARD uint32 CRenderGraph::create_image(STransientImageInfo&& info) noexcept {
+        AM_PROFILE_SCOPED();
+        auto& resource = _resources.emplace_back();
+        resource.is_image = true;
+        resource.is_transient = true;
+        resource.transient = (uint32)_transients.size();
+        _transients.push_back({
+            .info = info,
+            .resource = (uint32)_resources.size() - 1
+        });
+        return (uint32)_resources.size() - 1;
+    }
+
+    void CRenderGraph::add_pass(SRenderGraphPassInfo&& info, PassFunc&& func) noexcept {
+        AM_PROFILE_SCOPED();
+        _passes.push_back({
+            .info = std::move(info),
+            .func = std::move(func)
+        });
+    }
+
+    AM_NODISCARD const CImage* CRenderGraph::image(uint32 index) const noexcept {
+        AM_PROFILE_SCOPED();
+        AM_ASSERT(index < _resources.size() && _resources[index].is_image, "resource is not an image");
+        return _resources[index].image;
+    }
+
+    AM_NODISCARD const SBufferInfo& CRenderGraph::buffer(uint32 index) const noexcept {
+        AM_PROFILE_SCOPED();
+        AM_ASSERT(index < _resources.size() && !_resources[index].is_image, "resource is not a buffer");
+        return _resources[index].buffer;
+    }
+
+    AM_NODISCARD const SRenderGraphStats& CRenderGraph::stats() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _stats;
+    }
+
+    void CRenderGraph::compile() noexcept {
+        AM_PROFILE_SCOPED();
+        _stats = {};
+        _stats.passes = (uint32)_passes.size();
+        // Walk backwards from the observable results, a pass is live if anything live reads what it writes
+        _needed.assign(_resources.size(), false);
+        for (auto i = (uint32)_passes.size(); i-- > 0;) {
+            auto& pass = _passes[i];
+            pass.live = pass.info.side_effects;
+            for (const auto& write : pass.info.writes) {
+                pass.live |= !_resources[write.resource].is_transient || _needed[write.resource];
+            }
+            AM_UNLIKELY_IF(!pass.live) {
+                _stats.culled++;
+                continue;
+            }
+            for (const auto& read : pass.info.reads) {
+                _needed[read.resource] = true;
+            }
+        }
+        for (auto& transient : _transients) {
+            transient.first = (uint32)-1;
+            transient.last = 0;
+        }
+        for (uint32 i = 0; i < _passes.size(); ++i) {
+            const auto& pass = _passes[i];
+            AM_UNLIKELY_IF(!pass.live) {
+                continue;
+            }
+            const auto update = [&](const SRenderGraphAccess& access) noexcept {
+                const auto& resource = _resources[access.resource];
+                AM_LIKELY_IF(!resource.is_transient) {
+                    return;
+                }
+                auto& transient = _transients[resource.transient];
+                transient.first = std::min(transient.first, i);
+                transient.last = std::max(transient.last, i);
+            };
+            std::for_each(pass.info.reads.begin(), pass.info.reads.end(), update);
+            std::for_each(pass.info.writes.begin(), pass.info.writes.end(), update);
+        }
+        _allocate_transients();
+    }
+
+    void CRenderGraph::execute(CCommandBuffer& commands) noexcept {
+        AM_PROFILE_SCOPED();
+        _states.assign(_resources.size(), {});
+        for (uint32 i = 0; i < _resources.size(); ++i) {
+            const auto& resource = _resources[i];
+            AM_UNLIKELY_IF(resource.is_transient) {
+                continue;
+            }
+            auto& state = _states[i];
+            state.write_stage = resource.state.stage;
+            state.write_access = resource.state.access;
+            state.layout = resource.state.layout;
+            state.touched = true;
+        }
+        for (auto& slot : _slots) {
+            slot.stage = {};
+            slot.access = {};
+        }
+        for (auto& pass : _passes) {
+            AM_UNLIKELY_IF(!pass.live) {
+                continue;
+            }
+            // A resource read and written by the same pass needs a single barrier
+            _uses.clear();
+            const auto merge = [this](const SRenderGraphAccess& access, bool write) noexcept {
+                const auto use = std::find_if(_uses.begin(), _uses.end(), [&](const SPassUse& each) noexcept {
+                    return each.access.resource == access.resource;
+                });
+                AM_LIKELY_IF(use == _uses.end()) {
+                    _uses.push_back({ access, write });
+                    return;
+                }
+                AM_ASSERT(
+                    use->access.layout == access.layout ||
+                    use->access.layout == EImageLayout::Undefined ||
+                    access.layout == EImageLayout::Undefined,
+                    "conflicting layouts within the same pass");
+                AM_UNLIKELY_IF(use->access.layout == EImageLayout::Undefined) {
+                    use->access.layout = access.layout;
+                }
+                use->access.stage |= access.stage;
+                use->access.access |= access.access;
+                AM_UNLIKELY_IF(access.final_layout != EImageLayout::Undefined) {
+                    use->access.final_layout = access.final_layout;
+                }
+                use->write |= write;
+            };
+            for (const auto& read : pass.info.reads) {
+                merge(read, false);
+            }
+            for (const auto& write : pass.info.writes) {
+                merge(write, true);
+            }
+            for (const auto& use : _uses) {
+                const auto& resource = _resources[use.access.resource];
+                auto& state = _states[use.access.resource];
+                AM_UNLIKELY_IF(!state.touched) {
+                    // First use of an aliased image, wait for whatever used its memory before
+                    const auto& slot = _slots[_images[_transients[resource.transient].image].slot];
+                    state.write_stage = slot.stage;
+                    state.write_access = slot.access;
+                    state.layout = EImageLayout::Undefined;
+                    state.touched = true;
+                }
+                _sync(resource, state, use);
+            }
+            _flush(commands);
+            AM_PROFILE_NAMED_SCOPE("render graph: pass");
+            // Every named pass shows up in the GPU profiler
+            AM_LIKELY_IF(pass.info.name) {
+                commands.begin_zone(pass.info.name);
+                pass.func(commands, *this);
+                commands.end_zone();
+            } else {
+                pass.func(commands, *this);
+            }
+            for (const auto& use : _uses) {
+                const auto& resource = _resources[use.access.resource];
+                AM_LIKELY_IF(!resource.is_transient) {
+                    continue;
+                }
+                auto& slot = _slots[_images[_transients[resource.transient].image].slot];
+                slot.stage |= use.access.stage;
+                AM_LIKELY_IF(use.write) {
+                    slot.access |= use.access.access;
+                }
+            }
+        }
+        for (uint32 i = 0; i < _resources.size(); ++i) {
+            const auto& resource = _resources[i];
+            const auto& state = _states[i];
+            AM_UNLIKELY_IF(resource.is_transient || !state.used) {
+                continue;
+            }
+            const auto final_layout =
+                resource.state.final_layout == EImageLayout::Undefined ?
+                    state.layout :
+                    resource.state.final_layout;
+            const auto layout_change = resource.is_image && final_layout != state.layout;
+            AM_LIKELY_IF(resource.state.final_stage == EPipelineStage::None && !layout_change) {
+                continue;
+            }
+            AM_LIKELY_IF(state.write_stage == EPipelineStage::None && !layout_change) {
+                continue;
+            }
+            auto source_stage = state.write_stage | state.read_stage;
+            AM_UNLIKELY_IF(source_stage == EPipelineStage::None) {
+                source_stage = EPipelineStage::TopOfPipe;
+            }
+            auto dest_stage = resource.state.final_stage;
+            AM_UNLIKELY_IF(dest_stage == EPipelineStage::None) {
+                dest_stage = EPipelineStage::BottomOfPipe;
+            }
+            AM_LIKELY_IF(resource.is_image) {
+                _barriers.image({
+                    .image = resource.image,
+                    .source_stage = source_stage,
+                    .dest_stage = dest_stage,
+                    .source_access = state.write_access,
+                    .dest_access = resource.state.final_access,
+                    .old_layout = state.layout,
+                    .new_layout = final_layout
+                });
+            } else {
+                _barriers.buffer({
+                    .buffer = resource.buffer,
+                    .source_stage = source_stage,
+                    .dest_stage = dest_stage,
+                    .source_access = state.write_access,
+                    .dest_access = resource.state.final_access
+                });
+            }
+        }
+        _flush(commands);
+    }
+
+    void CRenderGraph::reset() noexcept {
+        AM_PROFILE_SCOPED();
+        _resources.clear();
+        _transients.clear();
+        _passes.clear();
+    }
+
+    void CRenderGraph::_allocate_transients() noexcept {
+        AM_PROFILE_SCOPED();
+        std::vector<uint32> used;
+        std::vector<uint32> signature;
+        used.reserve(_transients.size());
+        for (uint32 i = 0; i < _transients.size(); ++i) {
+            const auto& [info, resource, first, last, image] = _transients[i];
+            AM_UNLIKELY_IF(first > last) {
+                continue;
+            }
+            used.emplace_back(i);
+            signature.insert(signature.end(), {
+                (uint32)info.samples,
+                (uint32)info.usage,
+                (uint32)info.format,
+                info.layers,
+                info.mips,
+                info.width,
+                info.height,
+                first,
+                last
+            });
+        }
+        AM_UNLIKELY_IF(signature != _signature) {
+            _retire_transients();
+            _signature = std::move(signature);
+            // Greedy interval packing, transients are placed in order of first use
+            std::sort(used.begin(), used.end(), [this](uint32 left, uint32 right) noexcept {
+                return _transients[left].first < _transients[right].first;
+            });
+            _images.reserve(used.size());
+            for (const auto index : used) {
+                const auto& transient = _transients[index];
+                const auto& info = transient.info;
+                VkImageCreateInfo image_info = {};
+                image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+                image_info.imageType = VK_IMAGE_TYPE_2D;
+                image_info.format = prv::as_vulkan(info.format);
+                image_info.extent = { info.width, info.height, 1 };
+                image_info.mipLevels = info.mips;
+                image_info.arrayLayers = info.layers;
+                image_info.samples = prv::as_vulkan(info.samples);
+                image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+                image_info.usage = prv::as_vulkan(info.usage);
+                image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                auto& image = _images.emplace_back();
+                AM_VULKAN_CHECK(_device->logger(), vkCreateImage(_device->native(), &image_info, nullptr, &image.handle));
+                VkMemoryRequirements requirements;
+                vkGetImageMemoryRequirements(_device->native(), image.handle, &requirements);
+                _transient_bytes += requirements.size;
+
+                auto best = (uint32)_slots.size();
+                for (uint32 i = 0; i < _slots.size(); ++i) {
+                    const auto& slot = _slots[i];
+                    AM_LIKELY_IF(slot.last >= transient.first) {
+                        continue;
+                    }
+                    AM_UNLIKELY_IF(!(slot.requirements.memoryTypeBits & requirements.memoryTypeBits)) {
+                        continue;
+                    }
+                    // Prefer the slot wasting the least memory
+                    const auto waste = [&](const SMemorySlot& each) noexcept {
+                        return std::max(each.requirements.size, requirements.size) - std::min(each.requirements.size, requirements.size);
+                    };
+                    AM_UNLIKELY_IF(best == _slots.size() || waste(slot) < waste(_slots[best])) {
+                        best = i;
+                    }
+                }
+                AM_UNLIKELY_IF(best == _slots.size()) {
+                    _slots.push_back({
+                        .requirements = requirements
+                    });
+                } else {
+                    auto& slot = _slots[best].requirements;
+                    slot.size = std::max(slot.size, requirements.size);
+                    slot.alignment = std::max(slot.alignment, requirements.alignment);
+                    slot.memoryTypeBits &= requirements.memoryTypeBits;
+                }
+                _slots[best].last = transient.last;
+                image.slot = best;
+            }
+            VmaAllocationCreateInfo allocation_info = {};
+            allocation_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            allocation_info.priority = 1;
+            for (auto& slot : _slots) {
+                AM_VULKAN_CHECK(
+                    _device->logger(),
+                    vmaAllocateMemory(_device->allocator(), &slot.requirements, &allocation_info, &slot.allocation, nullptr));
+                _allocated_bytes += slot.requirements.size;
+            }
+            for (uint32 i = 0; i < used.size(); ++i) {
+                auto& image = _images[i];
+                const auto& info = _transients[used[i]].info;
+                const auto aspect = prv::deduce_aspect(prv::as_vulkan(info.format));
+                AM_VULKAN_CHECK(_device->logger(), vmaBindImageMemory(_device->allocator(), _slots[image.slot].allocation, image.handle));
+                VkImageViewCreateInfo image_view_info = {};
+                image_view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                image_view_info.image = image.handle;
+                image_view_info.viewType =
+                    info.layers == 1 ?
+                        VK_IMAGE_VIEW_TYPE_2D :
+                        VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+                image_view_info.format = prv::as_vulkan(info.format);
+                image_view_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+                image_view_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+                image_view_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+                image_view_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+                image_view_info.subresourceRange.aspectMask = aspect;
+                image_view_info.subresourceRange.baseMipLevel = 0;
+                image_view_info.subresourceRange.levelCount = info.mips;
+                image_view_info.subresourceRange.baseArrayLayer = 0;
+                image_view_info.subresourceRange.layerCount = info.layers;
+                VkImageView view;
+                AM_VULKAN_CHECK(_device->logger(), vkCreateImageView(_device->native(), &image_view_info, nullptr, &view));
+                // Non owning, the graph releases the image and its memory
+                image.image = CImage::from_raw(_device, {
+                    .handle = image.handle,
+                    .view = view,
+                    .allocation = _slots[image.slot].allocation,
+                    .usage = (VkImageUsageFlags)prv::as_vulkan(info.usage),
+                    .samples = prv::as_vulkan(info.samples),
+                    .aspect = aspect,
+                    .format = {
+                        prv::as_vulkan(info.format),
+                        prv::as_vulkan(info.format)
+                    },
+                    .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                    .layers = info.layers,
+                    .mips = info.mips,
+                    .width = info.width,
+                    .height = info.height
+                });
+            }
+            AM_LOG_INFO(
+                _device->logger(),
+                "render graph: {} transient images aliased into {} allocations ({} of {} bytes)",
+                _images.size(), _slots.size(), _allocated_bytes, _transient_bytes);
+        }
+        // Same order as the signature, images follow the sorted order
+        std::sort(used.begin(), used.end(), [this](uint32 left, uint32 right) noexcept {
+            return _transients[left].first < _transients[right].first;
+        });
+        for (uint32 i = 0; i < used.size(); ++i) {
+            auto& transient = _transients[used[i]];
+            transient.image = i;
+            _resources[transient.resource].image = _images[i].image.get();
+        }
+        _stats.transient_images = (uint32)used.size();
+        _stats.transient_bytes = _transient_bytes;
+        _stats.allocated_bytes = _allocated_bytes;
+    }
+
+    void CRenderGraph::_retire_transients() noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(!_images.empty() || !_slots.empty()) {
+            _device->cleanup_after(
+                frames_in_flight,
+                [images = std::move(_images), slots = std::move(_slots)](const CDevice* device) mutable noexcept {
+                    for (auto& image : images) {
+                        image.image.reset();
+                        vkDestroyImage(device->native(), image.handle, nullptr);
+                    }
+                    for (const auto& slot : slots) {
+                        vmaFreeMemory(device->allocator(), slot.allocation);
+                    }
+                });
+        }
+        _images.clear();
+        _slots.clear();
+        _signature.clear();
+        _transient_bytes = 0;
+        _allocated_bytes = 0;
+    }
+
+    void CRenderGraph::_destroy_transients() noexcept {
+        AM_PROFILE_SCOPED();
+        for (auto& image : _images) {
+            image.image.reset();
+            vkDestroyImage(_device->native(), image.handle, nullptr);
+        }
+        for (const auto& slot : _slots) {
+            vmaFreeMemory(_device->allocator(), slot.allocation);
+        }
+        _images.clear();
+        _slots.clear();
+        _signature.clear();
+        _transient_bytes = 0;
+        _allocated_bytes = 0;
+    }
+
+    void CRenderGraph::_sync(const SResource& resource, SResourceState& state, const SPassUse& use) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto& access = use.access;
+        state.used = true;
+        const auto layout_change =
+            resource.is_image &&
+            access.layout != EImageLayout::Undefined &&
+            access.layout != state.layout;
+        const auto new_layout = layout_change ? access.layout : state.layout;
+        auto source_stage = EPipelineStage::None;
+        auto source_access = EResourceAccess::None;
+        AM_LIKELY_IF(use.write || layout_change) {
+            // Write-after-read and write-after-write, wait for everything since the last write
+            source_stage = state.write_stage | state.read_stage;
+            source_access = state.write_access;
+            AM_LIKELY_IF(use.write) {
+                state.write_stage = access.stage;
+                state.write_access = access.access;
+            } else {
+                // The transition itself is the last write, later readers chain through this pass' stages
+                state.write_stage = access.stage;
+                state.write_access = EResourceAccess::None;
+            }
+            state.read_stage = use.write ? EPipelineStage::None : access.stage;
+            state.visible_stage = use.write ? EPipelineStage::None : access.stage;
+            state.visible_access = use.write ? EResourceAccess::None : access.access;
+        } else {
+            // Read-after-read never needs a barrier, read-after-write only if the write isn't visible to this stage yet
+            const auto visible =
+                (access.stage & ~state.visible_stage) == EPipelineStage::None &&
+                (access.access & ~state.visible_access) == EResourceAccess::None;
+            AM_LIKELY_IF(state.write_stage != EPipelineStage::None && !visible) {
+                source_stage = state.write_stage;
+                source_access = state.write_access;
+                state.visible_stage |= access.stage;
+                state.visible_access |= access.access;
+            }
+            state.read_stage |= access.stage;
+        }
+        const auto old_layout = state.layout;
+        state.layout = access.final_layout != EImageLayout::Undefined ? access.final_layout : new_layout;
+        AM_LIKELY_IF(source_stage == EPipelineStage::None && !layout_change) {
+            return;
+        }
+        AM_UNLIKELY_IF(source_stage == EPipelineStage::None) {
+            source_stage = EPipelineStage::TopOfPipe;
+        }
+        AM_LIKELY_IF(resource.is_image) {
+            _barriers.image({
+                .image = resource.image,
+                .source_stage = source_stage,
+                .dest_stage = access.stage,
+                .source_access = source_access,
+                .dest_access = access.access,
+                .old_layout = old_layout,
+                .new_layout = new_layout
+            });
+        } else {
+            _barriers.buffer({
+                .buffer = resource.buffer,
+                .source_stage = source_stage,
+                .dest_stage = access.stage,
+                .source_access = source_access,
+                .dest_access = access.access
+            });
+        }
+    }
+
+    void CRenderGraph::_flush(CCommandBuffer& commands) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(_barriers.empty()) {
+            return;
+        }
+        _stats.barriers += _barriers.size();
+        _stats.batches++;
+        commands.barrier(_barriers);
+    }
+} // namespace am
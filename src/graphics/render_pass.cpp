@@ -1,6 +1,8 @@
 #include <amethyst/graphics/render_pass.hpp>
 #include <amethyst/graphics/context.hpp>
 
+#include <amethyst/meta/constants.hpp>
+
 #include <optional>
 #include <vector>
 
@@ -122,6 +124,71 @@ namespace am {
         }
         AM_LOG_INFO(device->logger(), "- subpass dependencies count: {}", dependencies.size());
 
+        // Implicit external dependencies unless the pass declares its own
+        result->_begin_dependency = {
+            .source_subpass = external_subpass,
+            .dest_subpass = 0,
+            .source_stage = EPipelineStage::TopOfPipe,
+            .dest_stage = EPipelineStage::AllGraphics,
+            .source_access = EResourceAccess::None,
+            .dest_access =
+                EResourceAccess::ColorAttachmentRead |
+                EResourceAccess::ColorAttachmentWrite |
+                EResourceAccess::DepthStencilAttachmentRead |
+                EResourceAccess::DepthStencilAttachmentWrite
+        };
+        result->_end_dependency = {
+            .source_subpass = 0,
+            .dest_subpass = external_subpass,
+            .source_stage = EPipelineStage::AllGraphics,
+            .dest_stage = EPipelineStage::BottomOfPipe,
+            .source_access =
+                EResourceAccess::ColorAttachmentWrite |
+                EResourceAccess::DepthStencilAttachmentWrite,
+            .dest_access = EResourceAccess::None
+        };
+        for (const auto& each : info.dependencies) {
+            AM_UNLIKELY_IF(each.source_subpass == external_subpass) {
+                result->_begin_dependency = each;
+            } else if (each.dest_subpass == external_subpass) {
+                result->_end_dependency = each;
+            }
+        }
+        uint32 color_attachments = 0;
+        AM_LIKELY_IF(info.subpasses.size() == 1) {
+            for (const auto index : info.subpasses[0].attachments) {
+                color_attachments += !(prv::deduce_aspect(attachment_descriptions[index].format) & VK_IMAGE_ASPECT_DEPTH_BIT);
+            }
+        }
+        result->_is_dynamic =
+            info.dynamic_rendering &&
+            info.subpasses.size() == 1 &&
+            info.subpasses[0].input.empty() &&
+            color_attachments <= max_color_attachments &&
+            device->feature_support(EDeviceFeature::DynamicRendering);
+        AM_LIKELY_IF(result->_is_dynamic) {
+            for (const auto index : info.subpasses[0].attachments) {
+                const auto& description = attachment_descriptions[index];
+                const auto aspect = prv::deduce_aspect(description.format);
+                result->_rendering.push_back({
+                    .index = index,
+                    .format = description.format,
+                    .aspect = aspect,
+                    .layout =
+                        aspect & VK_IMAGE_ASPECT_DEPTH_BIT ?
+                            EImageLayout::DepthStencilAttachmentOptimal :
+                            EImageLayout::ColorAttachmentOptimal,
+                    .load = description.loadOp,
+                    .store = description.storeOp,
+                    .stencil_load = description.stencilLoadOp,
+                    .stencil_store = description.stencilStoreOp
+                });
+            }
+            AM_LOG_INFO(device->logger(), "- dynamic rendering, no render pass object created");
+            result->_device = std::move(device);
+            return CRcPtr<Self>::make(result);
+        }
+
         VkRenderPassCreateInfo render_pass_info = {};
         render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
         render_pass_info.attachmentCount = (uint32)attachment_descriptions.size();
@@ -145,4 +212,24 @@ namespace am {
         AM_PROFILE_SCOPED();
         return _attachments[index];
     }
+
+    AM_NODISCARD bool CRenderPass::is_dynamic() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _is_dynamic;
+    }
+
+    AM_NODISCARD const std::vector<SRenderingAttachment>& CRenderPass::rendering_attachments() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _rendering;
+    }
+
+    AM_NODISCARD const SDependencyDescriptions& CRenderPass::begin_dependency() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _begin_dependency;
+    }
+
+    AM_NODISCARD const SDependencyDescriptions& CRenderPass::end_dependency() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _end_dependency;
+    }
 } // namespace am
@@ -1,19 +1,38 @@
 #include <amethyst/graphics/semaphore.hpp>
+#include <amethyst/graphics/recycler.hpp>
 
 namespace am {
     CSemaphore::CSemaphore() noexcept = default;
 
     CSemaphore::~CSemaphore() noexcept {
         AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(_recycled) {
+            _device->recycler()->recycle_semaphore(_handle);
+            return;
+        }
         vkDestroySemaphore(_device->native(), _handle, nullptr);
     }
 
     AM_NODISCARD CRcPtr<CSemaphore> CSemaphore::make(CRcPtr<CDevice> device) noexcept {
+        AM_PROFILE_SCOPED();
+        return make(std::move(device), SCreateInfo());
+    }
+
+    AM_NODISCARD CRcPtr<CSemaphore> CSemaphore::make(CRcPtr<CDevice> device, SCreateInfo&& info) noexcept {
         AM_PROFILE_SCOPED();
         auto* result = new Self();
+        VkSemaphoreTypeCreateInfo type_info = {};
+        type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        type_info.initialValue = info.initial;
+
         VkSemaphoreCreateInfo semaphore_info = {};
         semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        AM_UNLIKELY_IF(info.timeline) {
+            semaphore_info.pNext = &type_info;
+        }
         AM_VULKAN_CHECK(device->logger(), vkCreateSemaphore(device->native(), &semaphore_info, nullptr, &result->_handle));
+        result->_timeline = info.timeline;
         result->_device = std::move(device);
         return CRcPtr<Self>::make(result);
     }
@@ -28,18 +47,57 @@ namespace am {
         return result;
     }
 
+    AM_NODISCARD std::vector<CRcPtr<CSemaphore>> CSemaphore::make(const CRcPtr<CDevice>& device, uint32 count, SCreateInfo&& info) noexcept {
+        AM_PROFILE_SCOPED();
+        std::vector<CRcPtr<Self>> result;
+        result.reserve(count);
+        for (uint32 i = 0; i < count; ++i) {
+            result.emplace_back(make(device, SCreateInfo(info)));
+        }
+        return result;
+    }
+
     AM_NODISCARD VkSemaphore CSemaphore::native() const noexcept {
         AM_PROFILE_SCOPED();
         return _handle;
     }
 
-    void CSemaphore::wait() const noexcept {
+    AM_NODISCARD bool CSemaphore::is_timeline() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _timeline;
+    }
+
+    AM_NODISCARD uint64 CSemaphore::value() const noexcept {
+        AM_PROFILE_SCOPED();
+        AM_ASSERT(_timeline, "value() requires a timeline semaphore");
+        uint64 value = 0;
+        AM_VULKAN_CHECK(_device->logger(), vkGetSemaphoreCounterValue(_device->native(), _handle, &value));
+        return value;
+    }
+
+    AM_NODISCARD bool CSemaphore::is_ready(uint64 value) const noexcept {
+        AM_PROFILE_SCOPED();
+        return this->value() >= value;
+    }
+
+    void CSemaphore::wait(uint64 value) const noexcept {
         AM_PROFILE_SCOPED();
-        // TODO
+        AM_ASSERT(_timeline, "wait() requires a timeline semaphore");
+        VkSemaphoreWaitInfo wait_info = {};
+        wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        wait_info.semaphoreCount = 1;
+        wait_info.pSemaphores = &_handle;
+        wait_info.pValues = &value;
+        AM_VULKAN_CHECK(_device->logger(), vkWaitSemaphores(_device->native(), &wait_info, (uint64)-1));
     }
 
-    void CSemaphore::signal() const noexcept {
+    void CSemaphore::signal(uint64 value) const noexcept {
         AM_PROFILE_SCOPED();
-        // TODO
+        AM_ASSERT(_timeline, "signal() requires a timeline semaphore");
+        VkSemaphoreSignalInfo signal_info = {};
+        signal_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+        signal_info.semaphore = _handle;
+        signal_info.value = value;
+        AM_VULKAN_CHECK(_device->logger(), vkSignalSemaphore(_device->native(), &signal_info));
     }
 } // namespace am
@@ -0,0 +1,412 @@
+#include <amethyst/core/file_view.hpp>
+
+#include <amethyst/graphics/shader_cache.hpp>
+#include <amethyst/graphics/device.hpp>
+
+#if defined(AM_RUNTIME_SHADERS)
+    #include <shaderc/shaderc.hpp>
+#endif
+
+#include <string_view>
+#include <algorithm>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+namespace am {
+    namespace fs = std::filesystem;
+
+#if defined(AM_RUNTIME_SHADERS)
+    namespace shc = shaderc;
+
+    namespace prv {
+        struct SShaderCacheHeader {
+            uint32 magic = 0;
+            uint32 version = 0;
+            uint64 key = 0;
+            uint64 words = 0;
+            float64 compile_ms = 0;
+        };
+
+        constexpr static auto shader_cache_magic = 0x48534d41u; // "AMSH"
+        // Everything "make_compile_options()" sets, hashed into the key along with the compiler's revision
+        struct SShaderCompileSettings {
+            bool debug_info = false;
+            shaderc_optimization_level optimization = {};
+            shaderc_source_language language = {};
+            shaderc_target_env environment = {};
+            shaderc_env_version environment_version = {};
+            shaderc_spirv_version spirv_version = {};
+        };
+
+        constexpr static SShaderCompileSettings shader_compile_settings = {
+            .debug_info = true,
+            .optimization = shaderc_optimization_level_performance,
+            .language = shaderc_source_language_glsl,
+            .environment = shaderc_target_env_vulkan,
+            .environment_version = shaderc_env_version_vulkan_1_2,
+            .spirv_version = shaderc_spirv_version_1_5
+        };
+#if defined(AM_SHADER_COMPILER_VERSION)
+        constexpr static std::string_view shader_compiler_version = AM_SHADER_COMPILER_VERSION;
+#else
+        constexpr static std::string_view shader_compiler_version = "unknown";
+#endif
+
+        // FNV-1a, the key is persisted so it cannot depend on the standard library's hash
+        AM_NODISCARD static inline uint64 stable_hash(uint64 seed, const void* data, uint64 size) noexcept {
+            const auto* bytes = static_cast<const uint8*>(data);
+            for (uint64 i = 0; i < size; ++i) {
+                seed ^= bytes[i];
+                seed *= 0x100000001b3ull;
+            }
+            return seed;
+        }
+
+        AM_NODISCARD static inline uint64 stable_hash(uint64 seed, std::string_view data) noexcept {
+            return stable_hash(seed, data.data(), data.size());
+        }
+
+        AM_NODISCARD static inline uint64 stable_hash(uint64 seed, const SShaderCompileSettings& settings) noexcept {
+            seed = stable_hash(seed, &settings.debug_info, sizeof settings.debug_info);
+            seed = stable_hash(seed, &settings.optimization, sizeof settings.optimization);
+            seed = stable_hash(seed, &settings.language, sizeof settings.language);
+            seed = stable_hash(seed, &settings.environment, sizeof settings.environment);
+            seed = stable_hash(seed, &settings.environment_version, sizeof settings.environment_version);
+            return stable_hash(seed, &settings.spirv_version, sizeof settings.spirv_version);
+        }
+
+        AM_NODISCARD static inline shaderc_shader_kind as_shader_kind(EShaderStage stage) noexcept {
+            switch (stage) {
+                case EShaderStage::Vertex: return shaderc_vertex_shader;
+                case EShaderStage::TessellationControl: return shaderc_tess_control_shader;
+                case EShaderStage::TessellationEvaluation: return shaderc_tess_evaluation_shader;
+                case EShaderStage::Geometry: return shaderc_geometry_shader;
+                case EShaderStage::Fragment: return shaderc_fragment_shader;
+                case EShaderStage::Compute: return shaderc_compute_shader;
+                default: break;
+            }
+            AM_UNREACHABLE();
+        }
+
+        // Hands shaderc the includes relative to the shader, folds each resolved one into "digest" and records it in
+        // "includes"
+        class CShaderIncluder : public shc::CompileOptions::IncluderInterface {
+        public:
+            using Self = CShaderIncluder;
+            using Super = shc::CompileOptions::IncluderInterface;
+
+            CShaderIncluder(fs::path root, uint64* digest, std::vector<fs::path>* includes) noexcept
+                : _root(std::move(root)),
+                  _digest(digest),
+                  _includes(includes) {};
+            ~CShaderIncluder() noexcept override = default;
+
+            shaderc_include_result* GetInclude(const char* requested_source,
+                                               shaderc_include_type,
+                                               const char*,
+                                               size_t) noexcept override {
+                AM_PROFILE_SCOPED();
+                auto path = _root / requested_source;
+                auto file = CFileView::make(path);
+                std::string content;
+                AM_LIKELY_IF(file) {
+                    content.assign((const char*)file->data(), file->size());
+                }
+                AM_LIKELY_IF(_digest) {
+                    *_digest = stable_hash(*_digest, path.generic_string());
+                    *_digest = stable_hash(*_digest, content);
+                }
+                AM_LIKELY_IF(_includes) {
+                    _includes->emplace_back(path);
+                }
+                return new CIncludeResult(std::move(content), path.filename().generic_string());
+            }
+
+            void ReleaseInclude(shaderc_include_result* data) noexcept override {
+                AM_PROFILE_SCOPED();
+                delete static_cast<CIncludeResult*>(data);
+            }
+        private:
+            class CIncludeResult : public shaderc_include_result {
+            public:
+                using Self = CIncludeResult;
+                using Super = shaderc_include_result;
+
+                CIncludeResult(std::string&& content, std::string&& filename) noexcept
+                    : Super(),
+                      _content(std::move(content)),
+                      _filename(std::move(filename)) {
+                    AM_PROFILE_SCOPED();
+                    Super::content = _content.c_str();
+                    Super::content_length = _content.size();
+                    Super::source_name = _filename.c_str();
+                    Super::source_name_length = _filename.size();
+                    Super::user_data = nullptr;
+                };
+
+                ~CIncludeResult() noexcept = default;
+
+            private:
+                std::string _content;
+                std::string _filename;
+            };
+            fs::path _root;
+            uint64* _digest = nullptr;
+            std::vector<fs::path>* _includes = nullptr;
+        };
+
+        AM_NODISCARD static inline shc::CompileOptions make_compile_options() noexcept {
+            const auto& settings = shader_compile_settings;
+            shc::CompileOptions options;
+            AM_LIKELY_IF(settings.debug_info) {
+                options.SetGenerateDebugInfo();
+            }
+            options.SetOptimizationLevel(settings.optimization);
+            options.SetSourceLanguage(settings.language);
+            options.SetTargetEnvironment(settings.environment, settings.environment_version);
+            options.SetTargetSpirv(settings.spirv_version);
+            return options;
+        }
+    } // namespace am::prv
+#endif
+
+    CShaderCache::CShaderCache() noexcept = default;
+
+    CShaderCache::~CShaderCache() noexcept {
+        AM_PROFILE_SCOPED();
+        const auto stats = this->stats();
+        AM_LOG_INFO(
+            _device->logger(),
+            "shader cache: {} hits, {} misses, {:.2f} ms saved",
+            stats.hits,
+            stats.misses,
+            stats.saved_ms);
+    }
+
+    AM_NODISCARD std::unique_ptr<CShaderCache> CShaderCache::make(CDevice* device, fs::path directory) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = std::unique_ptr<Self>(new Self());
+        result->_device = device;
+#if !defined(AM_RUNTIME_SHADERS)
+        // Prebuilt shaders are already optimized SPIR-V, there is nothing to cache
+        directory.clear();
+#endif
+        AM_LIKELY_IF(!directory.empty()) {
+            std::error_code error;
+            fs::create_directories(directory, error);
+            AM_UNLIKELY_IF(error) {
+                AM_LOG_WARN(device->logger(), "shader cache: cannot create \"{}\", caching disabled", directory.string());
+                directory.clear();
+            }
+        }
+        result->_directory = std::move(directory);
+        result->_instance = ((uint64)std::random_device()() << 32) | std::random_device()();
+        return result;
+    }
+
+    AM_NODISCARD SShaderBinary CShaderCache::load(const fs::path& path, EShaderStage stage) noexcept {
+        AM_PROFILE_SCOPED();
+        SShaderBinary result;
+#if defined(AM_RUNTIME_SHADERS)
+        result.code = compile(path, stage);
+        AM_LIKELY_IF(!result.code.empty()) {
+            result.reflection = SShaderReflection::make(result.code);
+        }
+#else
+        (void)stage;
+        auto binary = path;
+        binary += ".spv";
+        auto reflection = path;
+        reflection += ".refl";
+        auto file = CFileView::make(binary);
+        AM_UNLIKELY_IF(!file || file->size() % sizeof(uint32) != 0) {
+            AM_LOG_ERROR(_device->logger(), "shader: \"{}\" cannot load, build the \"amethyst_shaders\" target", binary.string());
+            return {};
+        }
+        const auto* words = static_cast<const uint32*>(file->data());
+        result.code.assign(words, words + file->size() / sizeof(uint32));
+        AM_UNLIKELY_IF(!SShaderReflection::load(reflection, result.reflection)) {
+            AM_LOG_ERROR(_device->logger(), "shader: \"{}\" cannot load, missing or stale reflection", reflection.string());
+            return {};
+        }
+#endif
+        return result;
+    }
+
+#if defined(AM_RUNTIME_SHADERS)
+    AM_NODISCARD std::vector<uint32> CShaderCache::compile(const fs::path& path, EShaderStage stage) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto s_path = path.string();
+        auto* logger = _device->logger();
+        auto file = CFileView::make(path);
+        if (!file) {
+            switch (file.error()) {
+                case CFileView::EErrorType::FileNotFound:
+                    logger->error("shader: \"{}\" cannot load, file not found", s_path);
+                    return {};
+                case CFileView::EErrorType::InternalError:
+                    logger->error("shader: \"{}\" cannot load, internal filesystem error", s_path);
+                    return {};
+            }
+        }
+        const auto kind = prv::as_shader_kind(stage);
+        const auto source = std::string_view((const char*)file->data(), file->size());
+
+        shc::Compiler compiler;
+        std::vector<fs::path> includes;
+        uint64 key = 0xcbf29ce484222325ull;
+        AM_LIKELY_IF(!_directory.empty()) {
+            // Preprocessing resolves every include, nested ones too, for a fraction of the cost of compiling
+            key = prv::stable_hash(key, &format_version, sizeof format_version);
+            key = prv::stable_hash(key, &kind, sizeof kind);
+            key = prv::stable_hash(key, prv::shader_compile_settings);
+            key = prv::stable_hash(key, prv::shader_compiler_version);
+            key = prv::stable_hash(key, source);
+            auto options = prv::make_compile_options();
+            options.SetIncluder(std::make_unique<prv::CShaderIncluder>(path.parent_path(), &key, &includes));
+            const auto preprocessed = compiler.PreprocessGlsl(source.data(), source.size(), kind, s_path.c_str(), options);
+            AM_LIKELY_IF(preprocessed.GetCompilationStatus() == shaderc_compilation_status_success) {
+                const auto begin = std::chrono::steady_clock::now();
+                std::vector<uint32> binary;
+                float64 compile_ms = 0;
+                AM_LIKELY_IF(_load(key, binary, compile_ms)) {
+                    _record(path, std::move(includes));
+                    const auto load_ms = std::chrono::duration<float64, std::milli>(std::chrono::steady_clock::now() - begin).count();
+                    std::lock_guard guard(_lock);
+                    _stats.hits++;
+                    _stats.saved_ms += std::max(compile_ms - load_ms, 0.0);
+                    AM_LOG_INFO(logger, "shader cache: \"{}\" hit, {:.2f} ms saved", s_path, compile_ms - load_ms);
+                    return binary;
+                }
+            }
+            // Preprocessing errors are reported by the compilation below
+        }
+
+        includes.clear();
+        auto options = prv::make_compile_options();
+        options.SetIncluder(std::make_unique<prv::CShaderIncluder>(path.parent_path(), nullptr, &includes));
+        const auto begin = std::chrono::steady_clock::now();
+        auto spirv = compiler.CompileGlslToSpv(source.data(), source.size(), kind, s_path.c_str(), options);
+        const auto compile_ms = std::chrono::duration<float64, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        // Recorded even on failure, fixing a broken include must still be noticed
+        _record(path, std::move(includes));
+        if (spirv.GetCompilationStatus() != shaderc_compilation_status_success) {
+            logger->error("shader compile failed:\n\"{}\"", spirv.GetErrorMessage());
+            logger->flush();
+            return {};
+        }
+        std::vector<uint32> binary = { spirv.cbegin(), spirv.cend() };
+        {
+            std::lock_guard guard(_lock);
+            _stats.misses++;
+            _stats.compile_ms += compile_ms;
+        }
+        AM_LIKELY_IF(!_directory.empty()) {
+            _store(key, binary, compile_ms);
+        }
+        return binary;
+    }
+#endif
+
+    AM_NODISCARD const fs::path& CShaderCache::directory() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _directory;
+    }
+
+    AM_NODISCARD std::vector<fs::path> CShaderCache::dependencies(const fs::path& path) const noexcept {
+        AM_PROFILE_SCOPED();
+        std::error_code error;
+        const auto key = fs::weakly_canonical(path, error).generic_string();
+        std::lock_guard guard(_lock);
+        const auto found = _dependencies.find(key);
+        AM_UNLIKELY_IF(found == _dependencies.end()) {
+            return {};
+        }
+        return found->second;
+    }
+
+    AM_NODISCARD SShaderCacheStats CShaderCache::stats() const noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        return _stats;
+    }
+
+    void CShaderCache::_record(const fs::path& path, std::vector<fs::path>&& includes) noexcept {
+        AM_PROFILE_SCOPED();
+        std::error_code error;
+        for (auto& each : includes) {
+            each = fs::weakly_canonical(each, error);
+        }
+        std::sort(includes.begin(), includes.end());
+        includes.erase(std::unique(includes.begin(), includes.end()), includes.end());
+        const auto key = fs::weakly_canonical(path, error).generic_string();
+        std::lock_guard guard(_lock);
+        _dependencies[key] = std::move(includes);
+    }
+
+#if defined(AM_RUNTIME_SHADERS)
+    AM_NODISCARD bool CShaderCache::_load(uint64 key, std::vector<uint32>& binary, float64& compile_ms) const noexcept {
+        AM_PROFILE_SCOPED();
+        char name[32];
+        std::snprintf(name, sizeof name, "%016llx.spv", (unsigned long long)key);
+        std::ifstream file(_directory / name, std::ios::binary);
+        AM_LIKELY_IF(!file) {
+            return false;
+        }
+        prv::SShaderCacheHeader header = {};
+        file.read((char*)&header, sizeof header);
+        // A mismatching header means a stale format or a hash collision, the entry is recompiled and overwritten
+        AM_UNLIKELY_IF(!file ||
+                       header.magic != prv::shader_cache_magic ||
+                       header.version != format_version ||
+                       header.key != key ||
+                       header.words == 0) {
+            return false;
+        }
+        binary.resize(header.words);
+        file.read((char*)binary.data(), size_bytes(binary));
+        AM_UNLIKELY_IF(!file || binary[0] != 0x07230203) {
+            binary.clear();
+            return false;
+        }
+        compile_ms = header.compile_ms;
+        return true;
+    }
+
+    void CShaderCache::_store(uint64 key, const std::vector<uint32>& binary, float64 compile_ms) noexcept {
+        AM_PROFILE_SCOPED();
+        char name[32];
+        std::snprintf(name, sizeof name, "%016llx.spv", (unsigned long long)key);
+        // Written aside and renamed so concurrent compilations and crashes never leave a torn entry behind
+        char suffix[48];
+        std::snprintf(suffix, sizeof suffix, ".%016llx.%llu.tmp", (unsigned long long)_instance, (unsigned long long)_temporaries.fetch_add(1));
+        auto temporary = _directory / (std::string(name) + suffix);
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            const prv::SShaderCacheHeader header = {
+                .magic = prv::shader_cache_magic,
+                .version = format_version,
+                .key = key,
+                .words = binary.size(),
+                .compile_ms = compile_ms
+            };
+            file.write((const char*)&header, sizeof header);
+            file.write((const char*)binary.data(), size_bytes(binary));
+            AM_UNLIKELY_IF(!file) {
+                AM_LOG_WARN(_device->logger(), "shader cache: cannot write \"{}\"", temporary.string());
+                file.close();
+                std::error_code error;
+                fs::remove(temporary, error);
+                return;
+            }
+        }
+        std::error_code error;
+        fs::rename(temporary, _directory / name, error);
+        AM_UNLIKELY_IF(error) {
+            fs::remove(temporary, error);
+        }
+    }
+#endif
+} // namespace am
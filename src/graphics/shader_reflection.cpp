@@ -0,0 +1,168 @@
+#include <amethyst/graphics/shader_reflection.hpp>
+
+#include <spirv_glsl.hpp>
+#include <spirv.hpp>
+
+#include <fstream>
+
+namespace am {
+    namespace spvc = spirv_cross;
+    namespace fs = std::filesystem;
+
+    namespace prv {
+        struct SShaderReflectionHeader {
+            uint32 magic = 0;
+            uint32 version = 0;
+            uint32 resources = 0;
+            uint32 constants = 0;
+            uint32 outputs = 0;
+            uint32 push_constant_size = 0;
+        };
+
+        constexpr static auto shader_reflection_magic = 0x46524d41u; // "AMRF"
+        // Anything longer is a corrupted file, not an identifier
+        constexpr static auto max_name_length = 4096u;
+        // Same for the number of resources, constants or outputs of a single stage
+        constexpr static auto max_entry_count = 4096u;
+
+        static inline void write_value(std::ofstream& file, uint32 value) noexcept {
+            file.write((const char*)&value, sizeof value);
+        }
+
+        static inline void write_string(std::ofstream& file, const std::string& value) noexcept {
+            write_value(file, (uint32)value.size());
+            file.write(value.data(), value.size());
+        }
+
+        AM_NODISCARD static inline bool read_value(std::ifstream& file, uint32& value) noexcept {
+            file.read((char*)&value, sizeof value);
+            return (bool)file;
+        }
+
+        AM_NODISCARD static inline bool read_string(std::ifstream& file, std::string& value) noexcept {
+            uint32 size = 0;
+            AM_UNLIKELY_IF(!read_value(file, size) || size > max_name_length) {
+                return false;
+            }
+            value.resize(size);
+            file.read(value.data(), size);
+            return (bool)file;
+        }
+    } // namespace am::prv
+
+    AM_NODISCARD SShaderReflection SShaderReflection::make(const std::vector<uint32>& binary) noexcept {
+        AM_PROFILE_SCOPED();
+        Self result;
+        const auto compiler = spvc::CompilerGLSL(binary.data(), binary.size());
+        const auto resources = compiler.get_shader_resources();
+        AM_LIKELY_IF(!resources.push_constant_buffers.empty()) {
+            const auto& resource = resources.push_constant_buffers[0];
+            result.push_constant = resource.name;
+            result.push_constant_size = (uint32)compiler.get_declared_struct_size(compiler.get_type(resource.type_id));
+        }
+        // Order matters, bindings shared between stages keep the position they were first seen at
+        const auto reflect = [&](const auto& list, VkDescriptorType descriptor) noexcept {
+            for (const auto& each : list) {
+                const auto& type = compiler.get_type(each.type_id);
+                result.resources.push_back({
+                    .name = each.name,
+                    .set = compiler.get_decoration(each.id, spv::DecorationDescriptorSet),
+                    .binding = compiler.get_decoration(each.id, spv::DecorationBinding),
+                    .count = type.array.empty() ? 1 : type.array[0],
+                    .type = descriptor
+                });
+            }
+        };
+        reflect(resources.uniform_buffers, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+        reflect(resources.storage_buffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        reflect(resources.sampled_images, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        reflect(resources.storage_images, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+        for (const auto& each : compiler.get_specialization_constants()) {
+            result.constants.push_back({
+                .name = compiler.get_name(each.id),
+                .id = each.constant_id,
+                .value = compiler.get_constant(each.id).scalar()
+            });
+        }
+        result.outputs.reserve(resources.stage_outputs.size());
+        for (const auto& each : resources.stage_outputs) {
+            result.outputs.emplace_back(compiler.get_type(each.type_id).vecsize);
+        }
+        return result;
+    }
+
+    AM_NODISCARD bool SShaderReflection::load(const fs::path& path, Self& result) noexcept {
+        AM_PROFILE_SCOPED();
+        std::ifstream file(path, std::ios::binary);
+        AM_UNLIKELY_IF(!file) {
+            return false;
+        }
+        prv::SShaderReflectionHeader header = {};
+        file.read((char*)&header, sizeof header);
+        AM_UNLIKELY_IF(!file ||
+                       header.magic != prv::shader_reflection_magic ||
+                       header.version != format_version ||
+                       header.resources > prv::max_entry_count ||
+                       header.constants > prv::max_entry_count ||
+                       header.outputs > prv::max_entry_count) {
+            return false;
+        }
+        result = {};
+        result.push_constant_size = header.push_constant_size;
+        AM_UNLIKELY_IF(!prv::read_string(file, result.push_constant)) {
+            return false;
+        }
+        result.resources.resize(header.resources);
+        for (auto& each : result.resources) {
+            uint32 type = 0;
+            AM_UNLIKELY_IF(!prv::read_string(file, each.name) ||
+                           !prv::read_value(file, each.set) ||
+                           !prv::read_value(file, each.binding) ||
+                           !prv::read_value(file, each.count) ||
+                           !prv::read_value(file, type)) {
+                return false;
+            }
+            each.type = (VkDescriptorType)type;
+        }
+        result.constants.resize(header.constants);
+        for (auto& each : result.constants) {
+            AM_UNLIKELY_IF(!prv::read_string(file, each.name) ||
+                           !prv::read_value(file, each.id) ||
+                           !prv::read_value(file, each.value)) {
+                return false;
+            }
+        }
+        result.outputs.resize(header.outputs);
+        file.read((char*)result.outputs.data(), size_bytes(result.outputs));
+        return (bool)file;
+    }
+
+    AM_NODISCARD bool SShaderReflection::save(const fs::path& path) const noexcept {
+        AM_PROFILE_SCOPED();
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        const prv::SShaderReflectionHeader header = {
+            .magic = prv::shader_reflection_magic,
+            .version = format_version,
+            .resources = (uint32)resources.size(),
+            .constants = (uint32)constants.size(),
+            .outputs = (uint32)outputs.size(),
+            .push_constant_size = push_constant_size
+        };
+        file.write((const char*)&header, sizeof header);
+        prv::write_string(file, push_constant);
+        for (const auto& each : resources) {
+            prv::write_string(file, each.name);
+            prv::write_value(file, each.set);
+            prv::write_value(file, each.binding);
+            prv::write_value(file, each.count);
+            prv::write_value(file, (uint32)each.type);
+        }
+        for (const auto& each : constants) {
+            prv::write_string(file, each.name);
+            prv::write_value(file, each.id);
+            prv::write_value(file, each.value);
+        }
+        file.write((const char*)outputs.data(), size_bytes(outputs));
+        return (bool)file;
+    }
+} // namespace am
@@ -0,0 +1,158 @@
+#include <amethyst/graphics/shader_watcher.hpp>
+#include <amethyst/graphics/shader_cache.hpp>
+
+#if defined(__linux__)
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#include <unordered_set>
+#include <string>
+
+namespace am {
+    namespace fs = std::filesystem;
+
+    CShaderWatcher::CShaderWatcher() noexcept = default;
+
+    CShaderWatcher::~CShaderWatcher() noexcept {
+        AM_PROFILE_SCOPED();
+#if defined(__linux__)
+        AM_LIKELY_IF(_fd != -1) {
+            close(_fd);
+        }
+#endif
+    }
+
+    AM_NODISCARD CRcPtr<CShaderWatcher> CShaderWatcher::make(CRcPtr<CDevice> device, const fs::path& root) noexcept {
+        AM_PROFILE_SCOPED();
+        auto* result = new Self();
+#if defined(__linux__)
+        result->_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        AM_UNLIKELY_IF(result->_fd == -1) {
+            AM_LOG_WARN(device->logger(), "shader watcher: inotify unavailable, hot reload disabled");
+        } else {
+            result->_watch(root);
+            AM_LOG_INFO(device->logger(), "shader watcher: watching {} directories under \"{}\"", result->_directories.size(), root.string());
+        }
+#else
+        AM_LOG_WARN(device->logger(), "shader watcher: unsupported platform, hot reload disabled");
+#endif
+        result->_events.resize(16384);
+        result->_device = std::move(device);
+        return CRcPtr<Self>::make(result);
+    }
+
+    AM_NODISCARD bool CShaderWatcher::is_supported() const noexcept {
+        AM_PROFILE_SCOPED();
+        return !_directories.empty();
+    }
+
+    void CShaderWatcher::watch(CRcPtr<CAsyncPipeline> pipeline) noexcept {
+        AM_PROFILE_SCOPED();
+        _pipelines.emplace_back(std::move(pipeline));
+    }
+
+    uint32 CShaderWatcher::update() noexcept {
+        AM_PROFILE_SCOPED();
+        std::unordered_set<std::string> changed;
+        bool overflow = false;
+#if defined(__linux__)
+        AM_UNLIKELY_IF(_fd == -1) {
+            return 0;
+        }
+        while (true) {
+            const auto size = read(_fd, _events.data(), _events.size());
+            AM_LIKELY_IF(size <= 0) {
+                break;
+            }
+            for (uint64 offset = 0; offset < (uint64)size;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(_events.data() + offset);
+                offset += sizeof(inotify_event) + event->len;
+                AM_UNLIKELY_IF(event->mask & IN_Q_OVERFLOW) {
+                    overflow = true;
+                    continue;
+                }
+                const auto directory = _directories.find(event->wd);
+                AM_UNLIKELY_IF(event->len == 0 || directory == _directories.end()) {
+                    continue;
+                }
+                const auto path = directory->second / event->name;
+                // New directories are not watched yet, whatever was written into them before the watch counts too
+                AM_UNLIKELY_IF((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                    const auto watches = _watch(path);
+                    AM_LOG_INFO(_device->logger(), "shader watcher: watching {} new directories under \"{}\"", watches, path.string());
+                    std::error_code error;
+                    for (const auto& each : fs::recursive_directory_iterator(path, error)) {
+                        AM_LIKELY_IF(each.is_regular_file(error)) {
+                            changed.emplace(fs::weakly_canonical(each.path(), error).generic_string());
+                        }
+                    }
+                    continue;
+                }
+                // A new file is reported again once written
+                AM_UNLIKELY_IF(event->mask & IN_CREATE) {
+                    continue;
+                }
+                changed.emplace(path.generic_string());
+            }
+        }
+#endif
+        AM_LIKELY_IF(changed.empty() && !overflow) {
+            return 0;
+        }
+        const auto is_changed = [&](const fs::path& path) noexcept {
+            std::error_code error;
+            return overflow || changed.contains(fs::weakly_canonical(path, error).generic_string());
+        };
+        uint32 reloads = 0;
+        for (auto& pipeline : _pipelines) {
+            bool affected = false;
+            for (const auto& source : pipeline->sources()) {
+                // Rebuilding the prebuilt shaders replaces them, their reflection is written last
+                affected = is_changed(source) || is_changed(fs::path(source) += ".refl");
+                for (const auto& include : _device->shader_cache()->dependencies(source)) {
+                    AM_LIKELY_IF(affected) {
+                        break;
+                    }
+                    affected = is_changed(include);
+                }
+                AM_UNLIKELY_IF(affected) {
+                    break;
+                }
+            }
+            AM_UNLIKELY_IF(affected) {
+                pipeline->reload();
+                reloads++;
+            }
+        }
+        for (const auto& each : changed) {
+            AM_LOG_INFO(_device->logger(), "shader watcher: \"{}\" changed", each);
+        }
+        AM_LOG_INFO(_device->logger(), "shader watcher: reloading {} pipelines", reloads);
+        return reloads;
+    }
+
+    uint32 CShaderWatcher::_watch(const fs::path& root) noexcept {
+        AM_PROFILE_SCOPED();
+        uint32 watches = 0;
+#if defined(__linux__)
+        // Editors either rewrite the file in place or move a temporary over it, directories are created or moved in
+        constexpr auto mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+        std::error_code error;
+        std::vector<fs::path> directories = { fs::weakly_canonical(root, error) };
+        for (const auto& each : fs::recursive_directory_iterator(root, error)) {
+            AM_UNLIKELY_IF(each.is_directory(error)) {
+                directories.emplace_back(fs::weakly_canonical(each.path(), error));
+            }
+        }
+        for (auto& each : directories) {
+            const auto descriptor = inotify_add_watch(_fd, each.c_str(), mask);
+            AM_LIKELY_IF(descriptor != -1) {
+                _directories[descriptor] = std::move(each);
+                watches++;
+            }
+        }
+#endif
+        return watches;
+    }
+} // namespace am
@@ -0,0 +1,200 @@
+#include <amethyst/graphics/texture_heap.hpp>
+#include <amethyst/graphics/device.hpp>
+
+#include <amethyst/meta/constants.hpp>
+
+#include <algorithm>
+
+namespace am {
+    CTextureHeap::CTextureHeap() noexcept = default;
+
+    CTextureHeap::~CTextureHeap() noexcept {
+        AM_PROFILE_SCOPED();
+        vkDestroyDescriptorPool(_device->native(), _pool, nullptr);
+        vkDestroyDescriptorSetLayout(_device->native(), _layout, nullptr);
+    }
+
+    AM_NODISCARD std::unique_ptr<CTextureHeap> CTextureHeap::make(CDevice* device) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(!device->feature_support(EDeviceFeature::BindlessTextures)) {
+            AM_LOG_WARN(
+                device->logger(),
+                "texture heap unavailable: descriptor indexing, runtime arrays, partially bound and update-after-bind "
+                "sampled images are required");
+            return nullptr;
+        }
+        auto result = std::unique_ptr<Self>(new Self());
+        VkPhysicalDeviceVulkan12Properties properties_12 = {};
+        properties_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties2 = {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &properties_12;
+        vkGetPhysicalDeviceProperties2(device->gpu(), &properties2);
+        // Pipelines bind the heap next to their own sets, which count against the same per-stage and per-layout limits
+        const auto limit = std::min({
+            properties_12.maxPerStageDescriptorUpdateAfterBindSamplers,
+            properties_12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            properties_12.maxDescriptorSetUpdateAfterBindSamplers,
+            properties_12.maxDescriptorSetUpdateAfterBindSampledImages,
+            properties_12.maxPerStageUpdateAfterBindResources
+        });
+        AM_UNLIKELY_IF(limit <= reserved_descriptors + null_slot + 1) {
+            AM_LOG_WARN(device->logger(), "texture heap unavailable: update-after-bind sampler limit too low: {}", limit);
+            return nullptr;
+        }
+        result->_capacity = std::min(limit - reserved_descriptors, max_capacity);
+
+        const auto flags = (VkDescriptorBindingFlags)(
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT);
+        VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags = {};
+        binding_flags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        binding_flags.bindingCount = 1;
+        binding_flags.pBindingFlags = &flags;
+
+        VkDescriptorSetLayoutBinding binding = {};
+        binding.binding = 0;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        binding.descriptorCount = result->_capacity;
+        binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+        VkDescriptorSetLayoutCreateInfo layout_info = {};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layout_info.pNext = &binding_flags;
+        layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        layout_info.bindingCount = 1;
+        layout_info.pBindings = &binding;
+        AM_VULKAN_CHECK(device->logger(), vkCreateDescriptorSetLayout(device->native(), &layout_info, nullptr, &result->_layout));
+
+        VkDescriptorPoolSize pool_size = {};
+        pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        pool_size.descriptorCount = result->_capacity;
+        VkDescriptorPoolCreateInfo pool_info = {};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        pool_info.maxSets = 1;
+        pool_info.poolSizeCount = 1;
+        pool_info.pPoolSizes = &pool_size;
+        AM_VULKAN_CHECK(device->logger(), vkCreateDescriptorPool(device->native(), &pool_info, nullptr, &result->_pool));
+
+        VkDescriptorSetAllocateInfo allocate_info = {};
+        allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorPool = result->_pool;
+        allocate_info.descriptorSetCount = 1;
+        allocate_info.pSetLayouts = &result->_layout;
+        AM_VULKAN_CHECK(device->logger(), vkAllocateDescriptorSets(device->native(), &allocate_info, &result->_handle));
+        AM_LOG_INFO(device->logger(), "texture heap created, capacity: {}, device limit: {}", result->_capacity, limit);
+        result->_device = device;
+        return result;
+    }
+
+    AM_NODISCARD VkDescriptorSet CTextureHeap::native() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _handle;
+    }
+
+    AM_NODISCARD VkDescriptorSetLayout CTextureHeap::layout() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _layout;
+    }
+
+    AM_NODISCARD uint32 CTextureHeap::capacity() const noexcept {
+        AM_PROFILE_SCOPED();
+        return _capacity;
+    }
+
+    AM_NODISCARD uint32 CTextureHeap::allocate(STextureInfo texture) noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        AM_UNLIKELY_IF(_free.empty() && _next == _capacity) {
+            AM_LOG_ERROR(_device->logger(), "texture heap is full, capacity: {}", _capacity);
+            return null_slot;
+        }
+        uint32 slot = null_slot;
+        if (_free.empty()) {
+            slot = _next++;
+        } else {
+            slot = _free.back();
+            _free.pop_back();
+        }
+        _pending[slot] = texture;
+        _live++;
+        return slot;
+    }
+
+    void CTextureHeap::write(uint32 slot, STextureInfo texture) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(slot == null_slot) {
+            return;
+        }
+        std::lock_guard guard(_lock);
+        _pending[slot] = texture;
+    }
+
+    void CTextureHeap::free(uint32 slot) noexcept {
+        AM_PROFILE_SCOPED();
+        AM_UNLIKELY_IF(slot == null_slot) {
+            return;
+        }
+        std::lock_guard guard(_lock);
+        // Left as is, partially bound slots are never read once nothing indexes them
+        _pending.erase(slot);
+        _retired.push_back({ slot, _frame });
+        _live--;
+    }
+
+    uint32 CTextureHeap::flush() noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        _writes = (uint32)_pending.size();
+        AM_LIKELY_IF(_pending.empty()) {
+            return 0;
+        }
+        std::vector<VkDescriptorImageInfo> descriptors;
+        descriptors.reserve(_pending.size());
+        std::vector<VkWriteDescriptorSet> updates;
+        updates.reserve(_pending.size());
+        for (const auto& [slot, texture] : _pending) {
+            VkDescriptorImageInfo descriptor = {};
+            descriptor.sampler = texture.sampler;
+            descriptor.imageView = texture.handle;
+            descriptor.imageLayout = texture.layout;
+            descriptors.emplace_back(descriptor);
+            VkWriteDescriptorSet update = {};
+            update.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            update.dstSet = _handle;
+            update.dstBinding = 0;
+            update.dstArrayElement = slot;
+            update.descriptorCount = 1;
+            update.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            update.pImageInfo = &descriptors.back();
+            updates.emplace_back(update);
+        }
+        vkUpdateDescriptorSets(_device->native(), (uint32)updates.size(), updates.data(), 0, nullptr);
+        _pending.clear();
+        return _writes;
+    }
+
+    void CTextureHeap::update() noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        _frame++;
+        std::erase_if(_retired, [this](const SRetiredSlot& each) noexcept {
+            AM_LIKELY_IF(_frame - each.frame <= frames_in_flight) {
+                return false;
+            }
+            _free.emplace_back(each.slot);
+            return true;
+        });
+    }
+
+    AM_NODISCARD STextureHeapStats CTextureHeap::stats() const noexcept {
+        AM_PROFILE_SCOPED();
+        std::lock_guard guard(_lock);
+        return {
+            .live_slots = _live,
+            .capacity = _capacity,
+            .writes = _writes
+        };
+    }
+} // namespace am
@@ -208,7 +208,9 @@ namespace am {
         ImGui::Render();
         commands.begin_render_pass(_framebuffer.get());
         ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commands.native());
-        commands.end_render_pass();
+        commands
+            .invalidate_state()
+            .end_render_pass();
     }
 
     AM_NODISCARD const CFramebuffer* CUIContext::framebuffer() const noexcept {
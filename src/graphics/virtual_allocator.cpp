@@ -38,7 +38,7 @@ namespace am {
         buffer_info.size = info.capacity;
         buffer_info.usage = prv::as_vulkan(info.usage);
         buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        AM_UNLIKELY_IF(queue_families_count >= 2 && !info.staging) {
+        AM_UNLIKELY_IF(info.concurrent && queue_families_count >= 2) {
             buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
             buffer_info.queueFamilyIndexCount = queue_families_count;
             buffer_info.pQueueFamilyIndices = queue_families;
@@ -1,13 +1,25 @@
+#include <amethyst/graphics/completion_poller.hpp>
+#include <amethyst/graphics/command_allocator.hpp>
+#include <amethyst/graphics/parallel_recorder.hpp>
 #include <amethyst/graphics/descriptor_pool.hpp>
 #include <amethyst/graphics/command_buffer.hpp>
 #include <amethyst/graphics/descriptor_set.hpp>
+#include <amethyst/graphics/render_graph.hpp>
 #include <amethyst/graphics/typed_buffer.hpp>
+#include <amethyst/graphics/shader_watcher.hpp>
+#include <amethyst/graphics/shader_cache.hpp>
+#include <amethyst/graphics/texture_heap.hpp>
 #include <amethyst/graphics/render_pass.hpp>
+#include <amethyst/graphics/async_pipeline.hpp>
 #include <amethyst/graphics/async_model.hpp>
+#include <amethyst/graphics/async_event.hpp>
 #include <amethyst/graphics/framebuffer.hpp>
+#include <amethyst/graphics/gpu_profiler.hpp>
+#include <amethyst/graphics/image_pool.hpp>
 #include <amethyst/graphics/ui_context.hpp>
 #include <amethyst/graphics/query_pool.hpp>
 #include <amethyst/graphics/swapchain.hpp>
+#include <amethyst/graphics/recycler.hpp>
 #include <amethyst/graphics/pipeline.hpp>
 #include <amethyst/graphics/context.hpp>
 #include <amethyst/graphics/device.hpp>
@@ -29,6 +41,7 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <algorithm>
 #include <numeric>
 #include <vector>
 #include <deque>
@@ -39,21 +52,93 @@
 #include "shadows/common.glsl"
 #include "common.hpp"
 
+// Runtime compilation reads the sources, prebuilt shaders live next to the executable
+#if defined(AM_RUNTIME_SHADERS)
+    #define AM_SHADER_ROOT "../data/shaders"
+#else
+    #define AM_SHADER_ROOT "data/shaders"
+#endif
+
 namespace am::tst {
     struct SSubMesh {
         const STexturedMesh* mesh;
-        uint32 textures[3];
+        const CAsyncTexture* textures[3];
         uint32 transform[2];
         uint32 instances;
     };
 
+    struct SMeshBatch {
+        const CRawBuffer* vertices;
+        const CRawBuffer* indices;
+        uint32 offset;
+        uint32 count;
+    };
+
+    struct SPendingSubMesh {
+        uint32 draw;
+        const STexturedMesh* mesh;
+    };
+
     struct SScene {
         using MeshBuffer = std::pair<const CRawBuffer*, const CRawBuffer*>;
-        std::vector<STextureInfo> textures;
         std::vector<STransformData> local_transforms;
         std::vector<STransformData> world_transforms;
         std::unordered_map<MeshBuffer, std::vector<SSubMesh>> meshes;
-        std::unordered_map<const STexturedMesh*, std::array<uint32, 3>> submesh_history;
+
+        // Incremental state, only touched when a ready event arrives or a transform is edited
+        std::unordered_set<const void*> ready;
+        std::unordered_map<const CAsyncMesh*, std::vector<SPendingSubMesh>> pending;
+        std::vector<uint32> world_offsets;
+        std::vector<uint32> dirty_draws;
+        std::vector<uint32> moved;
+        uint64 version = 1;
+
+        // Per frame in flight, what its transform buffers are missing. Local transforms are only ever appended
+        std::array<std::vector<uint32>, frames_in_flight> stale_world;
+        std::array<uint32, frames_in_flight> uploaded_local = {};
+    };
+
+    // Every binding the demo's pipelines declare, resolved once per pipeline. A pipeline lacking one leaves it invalid
+    struct SBindings {
+        SBindingHandle camera;
+        SBindingHandle object_data;
+        SBindingHandle local_transforms;
+        SBindingHandle world_transforms;
+        SBindingHandle object_offsets;
+        SBindingHandle object_remap;
+        SBindingHandle instance_offsets;
+        SBindingHandle instance_remap;
+        SBindingHandle culling_output;
+        SBindingHandle draw_count_output;
+        SBindingHandle shadow_cascades;
+        SBindingHandle point_lights;
+        SBindingHandle directional_lights;
+        SBindingHandle scene_depth;
+        SBindingHandle depth_pyramid;
+        SBindingHandle visibility;
+        SBindingHandle shadow_map;
+
+        AM_NODISCARD static SBindings make(const CPipeline* pipeline) noexcept {
+            return {
+                .camera = pipeline->binding_handle("UCamera"),
+                .object_data = pipeline->binding_handle("BObjectData"),
+                .local_transforms = pipeline->binding_handle("BLocalTransforms"),
+                .world_transforms = pipeline->binding_handle("BWorldTransforms"),
+                .object_offsets = pipeline->binding_handle("BObjectOffsets"),
+                .object_remap = pipeline->binding_handle("BObjectIDRemap"),
+                .instance_offsets = pipeline->binding_handle("BInstanceOffsets"),
+                .instance_remap = pipeline->binding_handle("BInstanceIDRemap"),
+                .culling_output = pipeline->binding_handle("BCullingOutput"),
+                .draw_count_output = pipeline->binding_handle("BDrawCountOutput"),
+                .shadow_cascades = pipeline->binding_handle("UShadowCascades"),
+                .point_lights = pipeline->binding_handle("BPointLights"),
+                .directional_lights = pipeline->binding_handle("BDirectionalLights"),
+                .scene_depth = pipeline->binding_handle("u_scene_depth"),
+                .depth_pyramid = pipeline->binding_handle("u_depth_pyramid"),
+                .visibility = pipeline->binding_handle("u_visibility"),
+                .shadow_map = pipeline->binding_handle("u_shadow_map")
+            };
+        }
     };
 
     struct SRotation {
@@ -72,92 +157,144 @@ namespace am::tst {
         std::vector<STransform> transform;
     };
 
-    static inline SScene build_scene(CDevice* device, const std::vector<SDraw>& draws, CAsyncTexture* fallback, const SScene& old_scene) noexcept {
+    static inline glm::mat4 make_transform(const STransform& transform) noexcept {
+        AM_PROFILE_SCOPED();
+        auto result = glm::translate(glm::mat4(1.0f), transform.position);
+        result = glm::scale(result, transform.scale);
+        AM_LIKELY_IF(std::fpclassify(transform.rotation.angle) != FP_ZERO) {
+            result = glm::rotate(result, glm::radians(transform.rotation.angle), transform.rotation.axis);
+        }
+        return result;
+    }
+
+    static inline SScene make_scene(const std::vector<SDraw>& draws) noexcept {
         AM_PROFILE_SCOPED();
-        constexpr auto sampler = SSamplerInfo {
-            .filter = EFilter::Linear,
-            .mip_mode = EMipMode::Linear,
-            .border_color = EBorderColor::FloatOpaqueBlack,
-            .address_mode = EAddressMode::Repeat,
-            .anisotropy = 16,
-        };
         SScene scene;
-        scene.textures.reserve(1024);
-        scene.textures = { device->sample(fallback, sampler) };
         scene.local_transforms.reserve(4096);
         scene.world_transforms.reserve(1024);
-        std::unordered_map<const void*, uint32> texture_cache;
-        uint32 local_offset = 0;
-        uint32 world_offset = 0;
-        for (uint32 i = 0; const auto& [model, transforms] : draws) {
-            if (!model->is_ready()) { continue; }
-            uint32 old_world_offset = 0;
-            uint32 old_instance_size = 0;
-            for (uint32 j = 0; const auto& submesh : model->submeshes()) {
-                if (!submesh.geometry->is_ready()) { continue; }
-                const auto mesh_buffer = SScene::MeshBuffer {
-                    submesh.geometry->vertices()->handle(),
-                    submesh.geometry->indices()->handle()
-                };
-                auto& current = scene.meshes[mesh_buffer];
-                std::array<uint32, 3> indices = {};
-                const auto emplace_descriptor = [&](CAsyncTexture* texture, uint32 which) {
-                    AM_LIKELY_IF(texture) {
-                        auto& cached = texture_cache[texture];
-                        AM_LIKELY_IF(cached == 0 && texture->is_ready()) {
-                            scene.textures.emplace_back(device->sample(texture, sampler));
-                            cached = (uint32)scene.textures.size() - 1;
-                        }
-                        indices[which] = cached;
-                    }
-                };
-                emplace_descriptor(submesh.albedo.get(), 0);
-                emplace_descriptor(submesh.normal.get(), 1);
-                auto result = SSubMesh {
-                    .mesh = &submesh,
-                    .textures = { indices[0], indices[1] },
-                    .transform = { local_offset++, world_offset },
-                    .instances = (uint32)transforms.size(),
-                };
-                current.push_back(result);
-                scene.submesh_history[result.mesh] = { {
-                    result.transform[0],
-                    result.transform[1],
-                    (uint32)transforms.size()
-                } };
-                auto prev_transform = glm::mat4(1.0f);
-                AM_LIKELY_IF(old_scene.submesh_history.contains(result.mesh)) {
-                    const auto& old_mesh = old_scene.submesh_history.at(result.mesh);
-                    prev_transform = old_scene.local_transforms[old_mesh[0]].current;
-                    old_world_offset = old_mesh[1];
-                    old_instance_size = old_mesh[2];
-                }
-                scene.local_transforms.push_back({
-                    .current = submesh.transform,
-                    .previous = prev_transform
+        scene.world_offsets.reserve(draws.size());
+        for (const auto& [model, transforms] : draws) {
+            scene.world_offsets.push_back((uint32)scene.world_transforms.size());
+            for (const auto& transform : transforms) {
+                const auto current = make_transform(transform);
+                scene.world_transforms.push_back({
+                    .current = current,
+                    .previous = current
                 });
-                j++;
             }
-            for (uint32 index = 0; const auto& transform : transforms) {
-                auto result = glm::translate(glm::mat4(1.0f), transform.position);
-                result = glm::scale(result, transform.scale);
-                AM_LIKELY_IF(std::fpclassify(transform.rotation.angle) != FP_ZERO) {
-                    result = glm::rotate(result, glm::radians(transform.rotation.angle), transform.rotation.axis);
+        }
+        for (auto& stale : scene.stale_world) {
+            stale.resize(scene.world_transforms.size());
+            std::iota(stale.begin(), stale.end(), 0u);
+        }
+        return scene;
+    }
+
+    static inline void insert_submesh(SScene& scene, const std::vector<SDraw>& draws, SPendingSubMesh submesh) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto& [draw, mesh] = submesh;
+        const auto mesh_buffer = SScene::MeshBuffer {
+            mesh->geometry->vertices()->handle(),
+            mesh->geometry->indices()->handle()
+        };
+        scene.meshes[mesh_buffer].push_back({
+            .mesh = mesh,
+            // Heap slots are read when building the object data, a texture still loading resolves to the null slot
+            .textures = { mesh->albedo.get(), mesh->normal.get() },
+            .transform = { (uint32)scene.local_transforms.size(), scene.world_offsets[draw] },
+            .instances = (uint32)draws[draw].transform.size(),
+        });
+        scene.local_transforms.push_back({
+            .current = mesh->transform,
+            .previous = mesh->transform
+        });
+        scene.version++;
+    }
+
+    static inline void process_ready_event(SScene& scene, const std::vector<SDraw>& draws, SReadyEvent&& event) noexcept {
+        AM_PROFILE_SCOPED();
+        switch (event.type) {
+            case EAsyncResource::Mesh: {
+                scene.ready.insert(event.mesh.get());
+                const auto pending = scene.pending.find(event.mesh.get());
+                AM_LIKELY_IF(pending != scene.pending.end()) {
+                    for (const auto& submesh : pending->second) {
+                        insert_submesh(scene, draws, submesh);
+                    }
+                    scene.pending.erase(pending);
                 }
-                auto prev_transform = glm::mat4(1.0f);
-                AM_LIKELY_IF(index < old_instance_size) {
-                    prev_transform = old_scene.world_transforms[old_world_offset + index].current;
+            } break;
+
+            case EAsyncResource::Texture: {
+                // The texture's heap slot is final now, only the object data referencing it changes
+                scene.ready.insert(event.texture.get());
+                scene.version++;
+            } break;
+
+            case EAsyncResource::Model: {
+                scene.ready.insert(event.model.get());
+                for (uint32 draw = 0; draw < draws.size(); ++draw) {
+                    AM_LIKELY_IF(draws[draw].model != event.model.get()) {
+                        continue;
+                    }
+                    for (const auto& mesh : event.model->submeshes()) {
+                        const auto submesh = SPendingSubMesh { draw, &mesh };
+                        AM_LIKELY_IF(scene.ready.contains(mesh.geometry.get())) {
+                            insert_submesh(scene, draws, submesh);
+                        } else {
+                            scene.pending[mesh.geometry.get()].push_back(submesh);
+                        }
+                    }
                 }
-                scene.world_transforms.push_back({
-                    .current = result,
-                    .previous = prev_transform
-                });
+            } break;
+        }
+    }
+
+    static inline void update_transforms(SScene& scene, const std::vector<SDraw>& draws) noexcept {
+        AM_PROFILE_SCOPED();
+        // Instances moved last frame catch their previous transform up, everything else is left untouched
+        for (const auto index : scene.moved) {
+            scene.world_transforms[index].previous = scene.world_transforms[index].current;
+        }
+        for (auto& stale : scene.stale_world) {
+            stale.insert(stale.end(), scene.moved.begin(), scene.moved.end());
+        }
+        scene.moved.clear();
+        std::sort(scene.dirty_draws.begin(), scene.dirty_draws.end());
+        scene.dirty_draws.erase(std::unique(scene.dirty_draws.begin(), scene.dirty_draws.end()), scene.dirty_draws.end());
+        for (const auto draw : scene.dirty_draws) {
+            const auto offset = scene.world_offsets[draw];
+            for (uint32 index = 0; const auto& transform : draws[draw].transform) {
+                auto& world = scene.world_transforms[offset + index];
+                world.previous = world.current;
+                world.current = make_transform(transform);
+                scene.moved.push_back(offset + index);
                 index++;
             }
-            world_offset += (uint32)transforms.size();
-            i++;
         }
-        return scene;
+        for (auto& stale : scene.stale_world) {
+            stale.insert(stale.end(), scene.moved.begin(), scene.moved.end());
+        }
+        scene.dirty_draws.clear();
+    }
+
+    // Writes the transforms this frame's buffers are missing, the rest of their contents is still current
+    static inline void upload_transforms(SScene& scene,
+                                         uint32 frame,
+                                         CTypedBuffer<STransformData>& local,
+                                         CTypedBuffer<STransformData>& world) noexcept {
+        AM_PROFILE_SCOPED();
+        for (auto index = scene.uploaded_local[frame]; index < scene.local_transforms.size(); ++index) {
+            local.insert(index, scene.local_transforms[index]);
+        }
+        scene.uploaded_local[frame] = (uint32)scene.local_transforms.size();
+        auto& stale = scene.stale_world[frame];
+        std::sort(stale.begin(), stale.end());
+        stale.erase(std::unique(stale.begin(), stale.end()), stale.end());
+        for (const auto index : stale) {
+            world.insert(index, scene.world_transforms[index]);
+        }
+        stale.clear();
     }
 
     static inline std::array<SShadowCascade, AM_GLSL_MAX_CASCADES> compute_cascades(const CCamera& camera, glm::vec3 light_pos) noexcept {
@@ -260,7 +397,7 @@ namespace am::tst {
 static inline am::CPipeline::SGraphicsCreateInfo shadow_pipeline_info(const am::CFramebuffer* framebuffer) noexcept {
     AM_PROFILE_SCOPED();
     return {
-        .vertex = "../data/shaders/shadows/shadow.vert",
+        .vertex = AM_SHADER_ROOT "/shadows/shadow.vert",
         .fragment = {},
         .geometry = {},
         .attributes = {
@@ -285,8 +422,8 @@ static inline am::CPipeline::SGraphicsCreateInfo shadow_pipeline_info(const am::
 static inline am::CPipeline::SGraphicsCreateInfo visibility_pipeline_info(const am::CFramebuffer* framebuffer) noexcept {
     AM_PROFILE_SCOPED();
     return {
-        .vertex = "../data/shaders/shadows/visibility.vert",
-        .fragment = "../data/shaders/shadows/visibility.frag",
+        .vertex = AM_SHADER_ROOT "/shadows/visibility.vert",
+        .fragment = AM_SHADER_ROOT "/shadows/visibility.frag",
         .geometry = {},
         .attributes = {
             am::EVertexAttribute::Vec3,
@@ -310,8 +447,8 @@ static inline am::CPipeline::SGraphicsCreateInfo visibility_pipeline_info(const
 static inline am::CPipeline::SGraphicsCreateInfo final_pipeline_info(const am::CFramebuffer* framebuffer) noexcept {
     AM_PROFILE_SCOPED();
     return {
-        .vertex = "../data/shaders/shadows/final.vert",
-        .fragment = "../data/shaders/shadows/final.frag",
+        .vertex = AM_SHADER_ROOT "/shadows/final.vert",
+        .fragment = AM_SHADER_ROOT "/shadows/final.frag",
         .geometry = {},
         .attributes = {},
         .attachments = {},
@@ -330,14 +467,21 @@ static inline am::CPipeline::SGraphicsCreateInfo final_pipeline_info(const am::C
 static inline am::CPipeline::SComputeCreateInfo cull_pipeline_info() noexcept {
     AM_PROFILE_SCOPED();
     return {
-        .compute = "../data/shaders/shadows/cull.comp"
+        .compute = AM_SHADER_ROOT "/shadows/cull.comp"
+    };
+}
+
+static inline am::CPipeline::SComputeCreateInfo shadow_cull_pipeline_info() noexcept {
+    AM_PROFILE_SCOPED();
+    return {
+        .compute = AM_SHADER_ROOT "/shadows/shadow_cull.comp"
     };
 }
 
 static inline am::CPipeline::SComputeCreateInfo depth_reduce_pipeline_info() noexcept {
     AM_PROFILE_SCOPED();
     return {
-        .compute = "../data/shaders/shadows/depth_reduce.comp"
+        .compute = AM_SHADER_ROOT "/shadows/depth_reduce.comp"
     };
 }
 
@@ -366,14 +510,42 @@ struct SDepthPyramidData {
     am::CRcPtr<am::CDescriptorSet> set;
 };
 
+struct SFrameResources {
+    am::uint32 shadow_map;
+    am::uint32 visibility_color;
+    am::uint32 visibility_depth;
+    am::uint32 depth_pyramid;
+    am::uint32 final_color;
+    am::uint32 ui_color;
+    am::uint32 swapchain_image;
+    am::uint32 shadow_indirect;
+    am::uint32 shadow_draw_count;
+    am::uint32 shadow_object_remap;
+    am::uint32 shadow_instance_remap;
+    am::uint32 indirect_commands;
+    am::uint32 draw_count;
+    am::uint32 object_remap;
+    am::uint32 instance_remap;
+};
+
+// One graph per queue submission, the graphics work is split around the compute handoff
+struct SFrameGraphs {
+    am::CRcPtr<am::CRenderGraph> shadow;
+    am::CRcPtr<am::CRenderGraph> compute;
+    am::CRcPtr<am::CRenderGraph> main;
+};
+
 struct SEngineState {
     bool vsync = true;
     bool frustum_culling = true;
+    bool shadow_culling = true;
     bool occlusion_culling = true;
+    bool async_compute = true;
     glm::vec3 directional_light_position = { 0, 1000, 0 };
     std::vector<SPointLight> point_lights;
     std::deque<am::float64> delta_time_history;
     std::vector<am::uint64> pipeline_statistics;
+    am::float64 pipeline_startup_time = 0;
 };
 
 class Application {
@@ -397,8 +569,10 @@ public:
         });
         _device = am::CDevice::make(_context, {
             .extensions = {
-                am::EDeviceExtension::Swapchain
-            }
+                am::EDeviceExtension::Swapchain,
+                am::EDeviceExtension::GraphicsPipelineLibrary
+            },
+            .submission_thread = true
         });
         _swapchain = am::CSwapchain::make(_device, _window, {
             .vsync = _state.vsync,
@@ -437,7 +611,8 @@ public:
                 .dest_stage = am::EPipelineStage::FragmentShader,
                 .source_access = am::EResourceAccess::DepthStencilAttachmentWrite,
                 .dest_access = am::EResourceAccess::ShaderRead
-            } }
+            } },
+            .dynamic_rendering = true
         });
         _visibility_pass = am::CRenderPass::make(_device, {
             .attachments = { {
@@ -486,7 +661,8 @@ public:
                 .source_access = am::EResourceAccess::ColorAttachmentWrite |
                                  am::EResourceAccess::DepthStencilAttachmentWrite,
                 .dest_access = am::EResourceAccess::ShaderRead
-            } }
+            } },
+            .dynamic_rendering = true
         });
         _final_pass = am::CRenderPass::make(_device, {
             .attachments = { {
@@ -517,7 +693,8 @@ public:
                 .dest_stage = am::EPipelineStage::FragmentShader,
                 .source_access = am::EResourceAccess::ColorAttachmentWrite,
                 .dest_access = am::EResourceAccess::ShaderRead
-            } }
+            } },
+            .dynamic_rendering = true
         });
         _shadow_framebuffer = am::CFramebuffer::make(_device, {
             .width = 2048,
@@ -572,11 +749,30 @@ public:
             .load = false
         });
 
-        _shadow_pipeline = am::CPipeline::make(_device, shadow_pipeline_info(_shadow_framebuffer.get()));
-        _depth_reduce_pipeline = am::CPipeline::make(_device, depth_reduce_pipeline_info());
-        _cull_pipeline = am::CPipeline::make(_device, cull_pipeline_info());
-        _visibility_pipeline = am::CPipeline::make(_device, visibility_pipeline_info(_visibility_framebuffer.get()));
-        _final_pipeline = am::CPipeline::make(_device, final_pipeline_info(_final_framebuffer.get()));
+        // Compares cold and warm starts of the shader and pipeline caches
+        const auto pipelines_begin = _system->current_time();
+        _shadow_pipeline = am::CAsyncPipeline::make(_device, shadow_pipeline_info(_shadow_framebuffer.get()));
+        _depth_reduce_pipeline = am::CAsyncPipeline::make(_device, depth_reduce_pipeline_info());
+        _cull_pipeline = am::CAsyncPipeline::make(_device, cull_pipeline_info());
+        _shadow_cull_pipeline = am::CAsyncPipeline::make(_device, shadow_cull_pipeline_info());
+        _visibility_pipeline = am::CAsyncPipeline::make(_device, visibility_pipeline_info(_visibility_framebuffer.get()));
+        _final_pipeline = am::CAsyncPipeline::make(_device, final_pipeline_info(_final_framebuffer.get()));
+        // Built concurrently, the scene needs every one of them before the first frame
+        for (auto* each : _pipelines()) {
+            each->wait();
+        }
+        _state.pipeline_startup_time = (_system->current_time() - pipelines_begin) * 1000;
+        // Every culling variant the UI can toggle to, built on workers while the first frames use the defaults
+        for (const auto frustum : { false, true }) {
+            (void)_shadow_cull_pipeline->handle()->variant({ { 0, frustum } });
+            for (const auto occlusion : { false, true }) {
+                (void)_cull_pipeline->handle()->variant({ { 0, frustum }, { 1, occlusion }, { 2, 256u } });
+            }
+        }
+        _shader_watcher = am::CShaderWatcher::make(_device, AM_SHADER_ROOT);
+        for (auto* each : _pipelines()) {
+            _shader_watcher->watch(am::CRcPtr<am::CAsyncPipeline>::make(each));
+        }
         _pipeline_statistics = am::CQueryPool::make(_device, {
             .statistics =
                 am::EQueryPipelineStatistics::InputAssemblyVertices |
@@ -591,11 +787,21 @@ public:
             .type = am::EQueryType::PipelineStatistics,
             .count = 9
         });
-        _commands = am::CCommandBuffer::make(_device, am::frames_in_flight, {
-            .queue = am::EQueueType::Graphics,
-            .pool = am::ECommandPoolType::Main,
-            .index = 0
+        _commands = am::CCommandAllocator::make(_device, {
+            .queue = am::EQueueType::Graphics
         });
+        _recorder = am::CParallelRecorder::make(_device, _commands);
+        _compute_commands = am::CCommandAllocator::make(_device, {
+            .queue = am::EQueueType::Compute
+        });
+        _graphs.reserve(am::frames_in_flight);
+        for (am::uint32 i = 0; i < am::frames_in_flight; ++i) {
+            _graphs.push_back({
+                .shadow = am::CRenderGraph::make(_device),
+                .compute = am::CRenderGraph::make(_device),
+                .main = am::CRenderGraph::make(_device)
+            });
+        }
 
         _fences = am::CFence::make(_device, am::frames_in_flight);
         _image_acq = am::CSemaphore::make(_device, am::frames_in_flight);
@@ -640,41 +846,50 @@ public:
             } }
         } };
 
-        _default_texture = am::CAsyncTexture::sync_make(_device, {
-            .path = "../data/textures/default.ktx2",
-            .type = am::ETextureType::Color
-        });
+        _scene = am::tst::make_scene(_draws);
 
         _shadow_set = am::CDescriptorSet::make(_device, am::frames_in_flight, {
             .pool = _descriptor_pool,
-            .pipeline = _shadow_pipeline,
+            .pipeline = _shadow_pipeline->handle(),
             .index = 0
         });
         _cull_set = am::CDescriptorSet::make(_device, am::frames_in_flight, {
             .pool = _descriptor_pool,
-            .pipeline = _cull_pipeline,
+            .pipeline = _cull_pipeline->handle(),
+            .index = 0
+        });
+        _shadow_cull_set = am::CDescriptorSet::make(_device, am::frames_in_flight, {
+            .pool = _descriptor_pool,
+            .pipeline = _shadow_cull_pipeline->handle(),
             .index = 0
         });
         _visibility_set = am::CDescriptorSet::make(_device, am::frames_in_flight, {
             .pool = _descriptor_pool,
-            .pipeline = _visibility_pipeline,
+            .pipeline = _visibility_pipeline->handle(),
             .index = 0
         });
         _final_set = am::CDescriptorSet::make(_device, am::frames_in_flight, {
             .pool = _descriptor_pool,
-            .pipeline = _final_pipeline,
+            .pipeline = _final_pipeline->handle(),
             .index = 0
         });
         _light_set = am::CDescriptorSet::make(_device, am::frames_in_flight, {
             .pool = _descriptor_pool,
-            .pipeline = _final_pipeline,
+            .pipeline = _final_pipeline->handle(),
             .index = 1
         });
-        _ui_set = am::CDescriptorSet::make(_device, {
+        _ui_set = am::CDescriptorSet::make(_device, am::frames_in_flight, {
             .pool = _descriptor_pool,
             .layout = _ui_context->set_layout(),
-            .index = 0
+            .index = 0,
+            .bindings = { am::make_descriptor_binding(0, am::EDescriptorType::CombinedImageSampler) }
         });
+        _shadow_bindings = am::tst::SBindings::make(_shadow_pipeline->handle().get());
+        _cull_bindings = am::tst::SBindings::make(_cull_pipeline->handle().get());
+        _shadow_cull_bindings = am::tst::SBindings::make(_shadow_cull_pipeline->handle().get());
+        _visibility_bindings = am::tst::SBindings::make(_visibility_pipeline->handle().get());
+        _depth_reduce_bindings = am::tst::SBindings::make(_depth_reduce_pipeline->handle().get());
+        _final_bindings = am::tst::SBindings::make(_final_pipeline->handle().get());
         _make_depth_pyramid(_swapchain->width(), _swapchain->height());
         _shadow_cascade_uniform = am::CTypedBuffer<SShadowCascade>::make(_device, am::frames_in_flight, {
             .usage = am::EBufferUsage::UniformBuffer,
@@ -684,17 +899,20 @@ public:
         _camera_uniform = am::CTypedBuffer<SCameraData>::make(_device, am::frames_in_flight, {
             .usage = am::EBufferUsage::UniformBuffer,
             .memory = am::memory_auto,
-            .capacity = 2
+            .capacity = 2,
+            .shared = true
         });
         _local_transform_storage = am::CTypedBuffer<STransformData>::make(_device, am::frames_in_flight, {
             .usage = am::EBufferUsage::StorageBuffer,
             .memory = am::memory_auto,
-            .capacity = 64
+            .capacity = 64,
+            .shared = true
         });
         _world_transform_storage = am::CTypedBuffer<STransformData>::make(_device, am::frames_in_flight, {
             .usage = am::EBufferUsage::StorageBuffer,
             .memory = am::memory_auto,
-            .capacity = 64
+            .capacity = 64,
+            .shared = true
         });
         _point_light_storage = am::CTypedBuffer<SPointLight>::make(_device, am::frames_in_flight, {
             .usage = am::EBufferUsage::StorageBuffer,
@@ -709,11 +927,30 @@ public:
         _object_storage = am::CTypedBuffer<SObjectData>::make(_device, am::frames_in_flight, {
             .usage = am::EBufferUsage::StorageBuffer,
             .memory = am::memory_auto,
-            .capacity = 64
+            .capacity = 64,
+            .shared = true
         });
         _shadow_indirect_commands = am::CTypedBuffer<am::SDrawCommandIndexedIndirect>::make(_device, am::frames_in_flight, {
-            .usage = am::EBufferUsage::IndirectBuffer,
-            .memory = am::memory_auto,
+            .usage = am::EBufferUsage::StorageBuffer | am::EBufferUsage::IndirectBuffer,
+            .memory = { am::EMemoryProperty::DeviceLocal },
+            .capacity = 16384
+        });
+        _shadow_draw_count_storage = am::CTypedBuffer<am::uint32>::make(_device, am::frames_in_flight, {
+            .usage =
+                am::EBufferUsage::StorageBuffer |
+                am::EBufferUsage::IndirectBuffer |
+                am::EBufferUsage::TransferDST,
+            .memory = { am::EMemoryProperty::DeviceLocal },
+            .capacity = 1024
+        });
+        _shadow_object_remap_storage = am::CTypedBuffer<am::uint32>::make(_device, am::frames_in_flight, {
+            .usage = am::EBufferUsage::StorageBuffer,
+            .memory = { am::EMemoryProperty::DeviceLocal },
+            .capacity = 16384
+        });
+        _shadow_instance_remap_storage = am::CTypedBuffer<am::uint32>::make(_device, am::frames_in_flight, {
+            .usage = am::EBufferUsage::StorageBuffer,
+            .memory = { am::EMemoryProperty::DeviceLocal },
             .capacity = 16384
         });
         _indirect_commands = am::CTypedBuffer<am::SDrawCommandIndexedIndirect>::make(_device, {
@@ -724,12 +961,14 @@ public:
         _object_offset_storage = am::CTypedBuffer<am::uint32>::make(_device, am::frames_in_flight, {
             .usage = am::EBufferUsage::StorageBuffer,
             .memory = am::memory_auto,
-            .capacity = 16384
+            .capacity = 16384,
+            .shared = true
         });
         _instance_offset_storage = am::CTypedBuffer<am::uint32>::make(_device, am::frames_in_flight, {
             .usage = am::EBufferUsage::StorageBuffer,
             .memory = am::memory_auto,
-            .capacity = 16384
+            .capacity = 16384,
+            .shared = true
         });
         _draw_count_storage = am::CTypedBuffer<am::uint32>::make(_device, {
             .usage = am::EBufferUsage::StorageBuffer | am::EBufferUsage::IndirectBuffer,
@@ -754,6 +993,8 @@ public:
         AM_PROFILE_SCOPED();
         AM_LOG_INFO(_device->logger(), "terminating program");
         _device->wait_idle();
+        // Undrained events hold references to the loaders, which in turn hold the device
+        _device->ready_events()->drain([](am::SReadyEvent&&) noexcept {});
     }
 
     void update() noexcept {
@@ -772,28 +1013,59 @@ public:
         }
         _input->capture();
         _camera.update({ _viewport_size.x, _viewport_size.y }, (am::float32)_delta_time);
-        _scene = build_scene(_device.get(), _draws, _default_texture.get(), _scene);
+        _device->ready_events()->drain([this](am::SReadyEvent&& event) noexcept {
+            am::tst::process_ready_event(_scene, _draws, std::move(event));
+        });
+        am::tst::update_transforms(_scene, _draws);
         const auto cascades = am::tst::compute_cascades(_camera, _state.directional_light_position);
         _fences[_frame_index]->wait_and_reset();
+        _commands->begin_frame(_frame_index);
+        _compute_commands->begin_frame(_frame_index);
         _build_object_data();
 
+        // Only the pipelines depending on a saved file are rebuilt, R still forces every one of them
+        _shader_watcher->update();
         if (_input->is_key_pressed_once(am::Keyboard::kR)) {
-            _device->cleanup_after(
-                am::frames_in_flight + 1,
-                [p0 = std::move(_cull_pipeline),
-                 p1 = std::move(_visibility_pipeline),
-                 p2 = std::move(_final_pipeline)](const am::CDevice*) mutable noexcept {});
-            _shadow_pipeline = am::CPipeline::make(_device, shadow_pipeline_info(_shadow_framebuffer.get()));
-            _cull_pipeline = am::CPipeline::make(_device, cull_pipeline_info());
-            _visibility_pipeline = am::CPipeline::make(_device, visibility_pipeline_info(_visibility_framebuffer.get()));
-            _final_pipeline = am::CPipeline::make(_device, final_pipeline_info(_final_framebuffer.get()));
-
+            // The current pipelines stay bound until their replacements are built
+            for (auto* each : _pipelines()) {
+                each->reload();
+            }
+        }
+        if (_shadow_pipeline->update()) {
+            _shadow_bindings = am::tst::SBindings::make(_shadow_pipeline->handle().get());
             for (am::uint32 i = 0; i < am::frames_in_flight; ++i) {
-                _shadow_set[i]->update_pipeline(_shadow_pipeline);
-                _cull_set[i]->update_pipeline(_cull_pipeline);
-                _visibility_set[i]->update_pipeline(_visibility_pipeline);
-                _final_set[i]->update_pipeline(_final_pipeline);
-                _light_set[i]->update_pipeline(_final_pipeline);
+                _shadow_set[i]->update_pipeline(_shadow_pipeline->handle());
+            }
+        }
+        if (_cull_pipeline->update()) {
+            _cull_bindings = am::tst::SBindings::make(_cull_pipeline->handle().get());
+            for (am::uint32 i = 0; i < am::frames_in_flight; ++i) {
+                _cull_set[i]->update_pipeline(_cull_pipeline->handle());
+            }
+        }
+        if (_shadow_cull_pipeline->update()) {
+            _shadow_cull_bindings = am::tst::SBindings::make(_shadow_cull_pipeline->handle().get());
+            for (am::uint32 i = 0; i < am::frames_in_flight; ++i) {
+                _shadow_cull_set[i]->update_pipeline(_shadow_cull_pipeline->handle());
+            }
+        }
+        if (_visibility_pipeline->update()) {
+            _visibility_bindings = am::tst::SBindings::make(_visibility_pipeline->handle().get());
+            for (am::uint32 i = 0; i < am::frames_in_flight; ++i) {
+                _visibility_set[i]->update_pipeline(_visibility_pipeline->handle());
+            }
+        }
+        if (_depth_reduce_pipeline->update()) {
+            _depth_reduce_bindings = am::tst::SBindings::make(_depth_reduce_pipeline->handle().get());
+            for (auto& each : _depth_pyramid_data) {
+                each.set->update_pipeline(_depth_reduce_pipeline->handle());
+            }
+        }
+        if (_final_pipeline->update()) {
+            _final_bindings = am::tst::SBindings::make(_final_pipeline->handle().get());
+            for (am::uint32 i = 0; i < am::frames_in_flight; ++i) {
+                _final_set[i]->update_pipeline(_final_pipeline->handle());
+                _light_set[i]->update_pipeline(_final_pipeline->handle());
             }
         }
 
@@ -811,8 +1083,11 @@ public:
         _shadow_cascade_uniform[_frame_index]->insert(cascades.data(), am::size_bytes(cascades));
         _camera_uniform[_frame_index]->insert(camera_buffer, sizeof camera_buffer);
 
-        _local_transform_storage[_frame_index]->insert(_scene.local_transforms);
-        _world_transform_storage[_frame_index]->insert(_scene.world_transforms);
+        am::tst::upload_transforms(
+            _scene,
+            _frame_index,
+            *_local_transform_storage[_frame_index],
+            *_world_transform_storage[_frame_index]);
         _point_light_storage[_frame_index]->insert(_state.point_lights);
         _directional_light_storage[_frame_index]->insert({ {
             .direction = glm::normalize(_state.directional_light_position),
@@ -848,226 +1123,262 @@ public:
                     depth_sampler.layout = am::EImageLayout::General;
                     depth_source = _device->sample(_depth_pyramid_data[i].view.get(), depth_sampler);
                 }
-                _depth_pyramid_data[i].set->bind("u_scene_depth", depth_source);
+                _depth_pyramid_data[i].set->bind(_depth_reduce_bindings.scene_depth, depth_source);
             }
             for (am::uint32 i = 0; i < _depth_pyramid_views.size(); ++i) {
-                _depth_pyramid_data[i].set->bind("u_depth_pyramid", _depth_pyramid_views[i].get());
+                _depth_pyramid_data[i].set->bind(_depth_reduce_bindings.depth_pyramid, _depth_pyramid_views[i].get());
             }
         }
 
-        _shadow_set[_frame_index]->bind("BLocalTransforms", _local_transform_storage[_frame_index]->info());
-        _shadow_set[_frame_index]->bind("BWorldTransforms", _world_transform_storage[_frame_index]->info());
-        _shadow_set[_frame_index]->bind("BObjectData", _object_storage[_frame_index]->info());
-        _shadow_set[_frame_index]->bind("UShadowCascades", _shadow_cascade_uniform[_frame_index]->info());
-
-        _cull_set[_frame_index]->bind("BObjectData", _object_storage[_frame_index]->info());
-        _cull_set[_frame_index]->bind("UCamera", _camera_uniform[_frame_index]->info());
-        _cull_set[_frame_index]->bind("BLocalTransforms", _local_transform_storage[_frame_index]->info());
-        _cull_set[_frame_index]->bind("BWorldTransforms", _world_transform_storage[_frame_index]->info());
-        _cull_set[_frame_index]->bind("BCullingOutput", _indirect_commands->info());
-        _cull_set[_frame_index]->bind("BDrawCountOutput", _draw_count_storage->info());
-        _cull_set[_frame_index]->bind("BObjectOffsets", _object_offset_storage[_frame_index]->info());
-        _cull_set[_frame_index]->bind("BObjectIDRemap", _object_remap_storage->info());
-        _cull_set[_frame_index]->bind("BInstanceOffsets", _instance_offset_storage[_frame_index]->info());
-        _cull_set[_frame_index]->bind("BInstanceIDRemap", _instance_remap_storage->info());
-        _cull_set[_frame_index]->bind("u_depth_pyramid", _device->sample(_depth_pyramid.get(), depth_sampler));
-
-        _visibility_set[_frame_index]->bind("UCamera", _camera_uniform[_frame_index]->info());
-        _visibility_set[_frame_index]->bind("BLocalTransforms", _local_transform_storage[_frame_index]->info());
-        _visibility_set[_frame_index]->bind("BWorldTransforms", _world_transform_storage[_frame_index]->info());
-        _visibility_set[_frame_index]->bind("BObjectData", _object_storage[_frame_index]->info());
-        _visibility_set[_frame_index]->bind("BObjectOffsets", _object_offset_storage[_frame_index]->info());
-        _visibility_set[_frame_index]->bind("BObjectIDRemap", _object_remap_storage->info());
-        _visibility_set[_frame_index]->bind("BInstanceOffsets", _instance_offset_storage[_frame_index]->info());
-        _visibility_set[_frame_index]->bind("BInstanceIDRemap", _instance_remap_storage->info());
-
-        _final_set[_frame_index]->bind("UCamera", _camera_uniform[_frame_index]->info());
-        _final_set[_frame_index]->bind("BObjectData", _object_storage[_frame_index]->info());
-        _final_set[_frame_index]->bind("BLocalTransforms", _local_transform_storage[_frame_index]->info());
-        _final_set[_frame_index]->bind("BWorldTransforms", _world_transform_storage[_frame_index]->info());
-        _final_set[_frame_index]->bind("u_visibility", _visibility_framebuffer->image(0));
-        _final_set[_frame_index]->bind("u_textures", _scene.textures);
-
-        _light_set[_frame_index]->bind("BPointLights", _point_light_storage[_frame_index]->info());
-        _light_set[_frame_index]->bind("BDirectionalLights", _directional_light_storage[_frame_index]->info());
-        _light_set[_frame_index]->bind("UShadowCascades", _shadow_cascade_uniform[_frame_index]->info());
-        _light_set[_frame_index]->bind("u_shadow_map", _device->sample(_shadow_framebuffer->image(0), {
+        _shadow_set[_frame_index]->bind(_shadow_bindings.local_transforms, _local_transform_storage[_frame_index]->info());
+        _shadow_set[_frame_index]->bind(_shadow_bindings.world_transforms, _world_transform_storage[_frame_index]->info());
+        _shadow_set[_frame_index]->bind(_shadow_bindings.object_data, _object_storage[_frame_index]->info());
+        _shadow_set[_frame_index]->bind(_shadow_bindings.shadow_cascades, _shadow_cascade_uniform[_frame_index]->info());
+        _shadow_set[_frame_index]->bind(_shadow_bindings.object_remap, _shadow_object_remap_storage[_frame_index]->info());
+        _shadow_set[_frame_index]->bind(_shadow_bindings.instance_offsets, _instance_offset_storage[_frame_index]->info());
+        _shadow_set[_frame_index]->bind(_shadow_bindings.instance_remap, _shadow_instance_remap_storage[_frame_index]->info());
+
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.shadow_cascades, _shadow_cascade_uniform[_frame_index]->info());
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.object_data, _object_storage[_frame_index]->info());
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.local_transforms, _local_transform_storage[_frame_index]->info());
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.world_transforms, _world_transform_storage[_frame_index]->info());
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.object_offsets, _object_offset_storage[_frame_index]->info());
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.instance_offsets, _instance_offset_storage[_frame_index]->info());
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.draw_count_output, _shadow_draw_count_storage[_frame_index]->info());
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.culling_output, _shadow_indirect_commands[_frame_index]->info());
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.object_remap, _shadow_object_remap_storage[_frame_index]->info());
+        _shadow_cull_set[_frame_index]->bind(_shadow_cull_bindings.instance_remap, _shadow_instance_remap_storage[_frame_index]->info());
+
+        _cull_set[_frame_index]->bind(_cull_bindings.object_data, _object_storage[_frame_index]->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.camera, _camera_uniform[_frame_index]->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.local_transforms, _local_transform_storage[_frame_index]->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.world_transforms, _world_transform_storage[_frame_index]->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.culling_output, _indirect_commands->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.draw_count_output, _draw_count_storage->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.object_offsets, _object_offset_storage[_frame_index]->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.object_remap, _object_remap_storage->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.instance_offsets, _instance_offset_storage[_frame_index]->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.instance_remap, _instance_remap_storage->info());
+        _cull_set[_frame_index]->bind(_cull_bindings.depth_pyramid, _device->sample(_depth_pyramid.get(), depth_sampler));
+
+        _visibility_set[_frame_index]->bind(_visibility_bindings.camera, _camera_uniform[_frame_index]->info());
+        _visibility_set[_frame_index]->bind(_visibility_bindings.local_transforms, _local_transform_storage[_frame_index]->info());
+        _visibility_set[_frame_index]->bind(_visibility_bindings.world_transforms, _world_transform_storage[_frame_index]->info());
+        _visibility_set[_frame_index]->bind(_visibility_bindings.object_data, _object_storage[_frame_index]->info());
+        _visibility_set[_frame_index]->bind(_visibility_bindings.object_offsets, _object_offset_storage[_frame_index]->info());
+        _visibility_set[_frame_index]->bind(_visibility_bindings.object_remap, _object_remap_storage->info());
+        _visibility_set[_frame_index]->bind(_visibility_bindings.instance_offsets, _instance_offset_storage[_frame_index]->info());
+        _visibility_set[_frame_index]->bind(_visibility_bindings.instance_remap, _instance_remap_storage->info());
+
+        _final_set[_frame_index]->bind(_final_bindings.camera, _camera_uniform[_frame_index]->info());
+        _final_set[_frame_index]->bind(_final_bindings.object_data, _object_storage[_frame_index]->info());
+        _final_set[_frame_index]->bind(_final_bindings.local_transforms, _local_transform_storage[_frame_index]->info());
+        _final_set[_frame_index]->bind(_final_bindings.world_transforms, _world_transform_storage[_frame_index]->info());
+
+        _light_set[_frame_index]->bind(_final_bindings.point_lights, _point_light_storage[_frame_index]->info());
+        _light_set[_frame_index]->bind(_final_bindings.directional_lights, _directional_light_storage[_frame_index]->info());
+        _light_set[_frame_index]->bind(_final_bindings.shadow_cascades, _shadow_cascade_uniform[_frame_index]->info());
+        _light_set[_frame_index]->bind(_final_bindings.shadow_map, _device->sample(_shadow_framebuffer->image(0), {
             .filter = am::EFilter::Nearest,
             .mip_mode = am::EMipMode::Nearest,
             .border_color = am::EBorderColor::FloatOpaqueWhite,
             .address_mode = am::EAddressMode::ClampToBorder
         }));
+
+        // Every set is written once here, after all binds of the frame
+        _descriptor_writes = 0;
+        for (auto& each : _depth_pyramid_data) {
+            _descriptor_writes += each.set->flush();
+        }
+        for (auto* set : {
+            _shadow_set[_frame_index].get(),
+            _shadow_cull_set[_frame_index].get(),
+            _cull_set[_frame_index].get(),
+            _visibility_set[_frame_index].get(),
+            _final_set[_frame_index].get(),
+            _light_set[_frame_index].get()
+        }) {
+            _descriptor_writes += set->flush();
+        }
+        // Only the slots of textures that became ready or were destroyed since the last frame
+        AM_LIKELY_IF(auto* heap = _device->texture_heap()) {
+            _descriptor_writes += heap->flush();
+        }
     }
 
     void render() noexcept {
         AM_PROFILE_SCOPED();
-        auto& commands = *_commands[_frame_index];
-        const auto draw_count_size = (am::uint32)_draw_count_storage->size();
-        commands
-            .begin()
-            .begin_query(_pipeline_statistics.get(), 0)
-            .begin_render_pass(_shadow_framebuffer.get())
-            .bind_pipeline(_shadow_pipeline.get())
-            .bind_descriptor_set(_shadow_set[_frame_index].get())
-            .set_viewport(am::inverted_viewport_tag)
-            .set_scissor();
-        {
-            for (am::uint32 layer = 0; layer < AM_GLSL_MAX_CASCADES; ++layer) {
-                am::uint32 offset = 0;
-                for (am::uint32 index = 0; const auto& [mesh_buffer, meshes] : _scene.meshes) {
-                    const auto& [vertex_buffer, index_buffer] = mesh_buffer;
-                    const am::uint32 constants[] = { offset, layer };
-                    commands
-                        .bind_vertex_buffer(vertex_buffer->info())
-                        .bind_index_buffer(index_buffer->info())
-                        .push_constants(am::EShaderStage::Vertex, constants, sizeof constants)
-                        .draw_indexed_indirect(_shadow_indirect_commands[_frame_index]->info(offset), meshes.size());
-                    offset += meshes.size();
-                }
-            }
+        _mesh_batches.clear();
+        for (am::uint32 offset = 0; const auto& [mesh_buffer, meshes] : _scene.meshes) {
+            _mesh_batches.push_back({
+                .vertices = mesh_buffer.first,
+                .indices = mesh_buffer.second,
+                .offset = offset,
+                .count = (am::uint32)meshes.size()
+            });
+            offset += meshes.size();
         }
-        commands.end_render_pass();
-        if (_occlusion_cull && _state.occlusion_culling) {
-            for (am::uint32 i = 0; i < _depth_pyramid->mips(); ++i) {
-                const am::uint32 constants[] = {
-                    std::max(_depth_pyramid->width() >> i, 1u),
-                    std::max(_depth_pyramid->height() >> i, 1u)
-                };
+        _last_elided_calls = _elided_calls;
+        _elided_calls = 0;
+        // Hi-Z and culling run on the compute queue while the graphics queue renders the cascades, graphics only
+        // waits on them right before the visibility pass. Pointless if compute shares the graphics queue.
+        auto* graphics_queue = _device->graphics_queue();
+        auto* compute_queue = _device->compute_queue();
+        const auto async_compute = _state.async_compute && compute_queue != graphics_queue;
+        AM_UNLIKELY_IF(async_compute != _async_compute) {
+            // Ownership of the visibility depth doesn't match the new split, skip occlusion culling for one frame
+            _async_compute = async_compute;
+            _occlusion_cull = false;
+        }
+        auto& graphs = _graphs[_frame_index];
+        graphs.shadow->reset();
+        graphs.compute->reset();
+        graphs.main->reset();
+        auto& shadow_graph = async_compute ? *graphs.shadow : *graphs.main;
+        auto& compute_graph = async_compute ? *graphs.compute : *graphs.main;
+        auto& main_graph = *graphs.main;
+        const auto resources = _import_frame_resources(main_graph, async_compute);
+        AM_LIKELY_IF(async_compute) {
+            // Same import order, so the indices match across graphs
+            (void)_import_frame_resources(*graphs.shadow, async_compute);
+            (void)_import_frame_resources(*graphs.compute, async_compute);
+        }
+        _add_shadow_pass(shadow_graph, resources);
+        _add_cull_passes(compute_graph, resources, async_compute);
+        _add_main_passes(main_graph, resources, async_compute);
+        // Transient images only exist once compiled, the secondaries below inherit the framebuffers they end up in
+        for (auto* graph : { graphs.shadow.get(), graphs.compute.get(), graphs.main.get() }) {
+            graph->compile();
+        }
+        _bind_transient_images(main_graph, resources);
+
+        // Queries can't span the three command buffers of the async split
+        const auto statistics = _device->feature_support(am::EDeviceFeature::InheritedQueries) && !async_compute;
+        const auto inherited_statistics = statistics ? _pipeline_statistics->statistics() : am::EQueryPipelineStatistics();
+        // Draws are recorded into secondaries on the workers while this thread records the compute work
+        _recorder->reset();
+        _shadow_job = _recorder->record({
+            .framebuffer = _shadow_framebuffer.get(),
+            .count = AM_GLSL_MAX_CASCADES * (am::uint32)_mesh_batches.size(),
+            .batch = 8,
+            .statistics = inherited_statistics
+        }, [this](am::CCommandBuffer& commands, am::uint32 begin, am::uint32 end) noexcept {
+            commands
+                .bind_pipeline(_shadow_pipeline->handle().get())
+                .bind_descriptor_set(_shadow_set[_frame_index].get())
+                .set_viewport(am::inverted_viewport_tag)
+                .set_scissor();
+            const auto object_count = (am::uint32)_object_storage[_frame_index]->size();
+            const auto instance_count = (am::uint32)_shadow_instance_remap_storage[_frame_index]->size() / AM_GLSL_MAX_CASCADES;
+            const auto batch_count = (am::uint32)_mesh_batches.size();
+            for (am::uint32 i = begin; i < end; ++i) {
+                // The cascades of a batch are adjacent, its buffers are only bound once
+                const auto index = i / AM_GLSL_MAX_CASCADES;
+                const auto cascade = i % AM_GLSL_MAX_CASCADES;
+                const auto& batch = _mesh_batches[index];
+                const am::uint32 constants[] = { batch.offset, cascade, object_count, instance_count };
                 commands
-                    .bind_pipeline(_depth_reduce_pipeline.get())
-                    .bind_descriptor_set(_depth_pyramid_data[i].set.get())
-                    .push_constants(am::EShaderStage::Compute, constants, sizeof constants)
-                    .dispatch(
-                        (constants[0] + 16 - 1) / 16,
-                        (constants[1] + 16 - 1) / 16)
-                    .barrier({
-                        .image = _depth_pyramid.get(),
-                        .source_stage = am::EPipelineStage::ComputeShader,
-                        .dest_stage = am::EPipelineStage::ComputeShader,
-                        .source_access = am::EResourceAccess::ShaderWrite,
-                        .dest_access = am::EResourceAccess::ShaderRead,
-                        .old_layout = am::EImageLayout::General,
-                        .new_layout = am::EImageLayout::General,
-                        .mip = i
-                    });
+                    .bind_vertex_buffer(batch.vertices->info())
+                    .bind_index_buffer(batch.indices->info())
+                    .push_constants(am::EShaderStage::Vertex, constants, sizeof constants)
+                    .draw_indexed_indirect_count(
+                        _shadow_indirect_commands[_frame_index]->info(cascade * object_count + batch.offset),
+                        _shadow_draw_count_storage[_frame_index]->info(cascade * batch_count + index),
+                        batch.count);
             }
-        }
-        const am::uint32 cull_constants[] = {
-            draw_count_size,
-            _state.frustum_culling,
-            _occlusion_cull && _state.occlusion_culling
-        };
-        commands
-            .bind_pipeline(_cull_pipeline.get())
-            .bind_descriptor_set(_cull_set[_frame_index].get())
-            .push_constants(am::EShaderStage::Compute, cull_constants, sizeof cull_constants)
-            .dispatch((_object_storage[_frame_index]->size() / 256) + 1)
-            .barrier({
-                .buffer = _indirect_commands->info(),
-                .source_stage = am::EPipelineStage::ComputeShader,
-                .dest_stage = am::EPipelineStage::DrawIndirect,
-                .source_access = am::EResourceAccess::ShaderWrite,
-                .dest_access = am::EResourceAccess::IndirectCommandRead,
-            })
-            .barrier({
-                .buffer = _draw_count_storage->info(),
-                .source_stage = am::EPipelineStage::ComputeShader,
-                .dest_stage = am::EPipelineStage::DrawIndirect |
-                              am::EPipelineStage::Host,
-                .source_access = am::EResourceAccess::ShaderWrite,
-                .dest_access = am::EResourceAccess::IndirectCommandRead |
-                               am::EResourceAccess::HostRead,
-            })
-            .barrier({
-                .buffer = _object_remap_storage->info(),
-                .source_stage = am::EPipelineStage::ComputeShader,
-                .dest_stage = am::EPipelineStage::VertexShader |
-                              am::EPipelineStage::FragmentShader,
-                .source_access = am::EResourceAccess::ShaderWrite,
-                .dest_access = am::EResourceAccess::ShaderRead,
-            })
-            .barrier({
-                .buffer = _instance_remap_storage->info(),
-                .source_stage = am::EPipelineStage::ComputeShader,
-                .dest_stage = am::EPipelineStage::VertexShader |
-                              am::EPipelineStage::FragmentShader,
-                .source_access = am::EResourceAccess::ShaderWrite,
-                .dest_access = am::EResourceAccess::ShaderRead,
-            })
-            .begin_render_pass(_visibility_framebuffer.get())
-            .bind_pipeline(_visibility_pipeline.get())
-            .bind_descriptor_set(_visibility_set[_frame_index].get())
-            .set_viewport(am::inverted_viewport_tag)
-            .set_scissor();
-        {
-            am::uint32 offset = 0;
-            for (am::uint32 index = 0; const auto& [mesh_buffer, meshes] : _scene.meshes) {
-                const auto& [vertex_buffer, index_buffer] = mesh_buffer;
+        });
+        _visibility_job = _recorder->record({
+            .framebuffer = _visibility_framebuffer.get(),
+            .count = (am::uint32)_mesh_batches.size(),
+            .batch = 8,
+            .statistics = inherited_statistics
+        }, [this](am::CCommandBuffer& commands, am::uint32 begin, am::uint32 end) noexcept {
+            commands
+                .bind_pipeline(_visibility_pipeline->handle().get())
+                .bind_descriptor_set(_visibility_set[_frame_index].get())
+                .set_viewport(am::inverted_viewport_tag)
+                .set_scissor();
+            for (am::uint32 index = begin; index < end; ++index) {
+                const auto& batch = _mesh_batches[index];
                 commands
-                    .bind_vertex_buffer(vertex_buffer->info())
-                    .bind_index_buffer(index_buffer->info())
+                    .bind_vertex_buffer(batch.vertices->info())
+                    .bind_index_buffer(batch.indices->info())
                     .push_constants(am::EShaderStage::Vertex, &index, sizeof index)
                     .draw_indexed_indirect_count(
-                        _indirect_commands->info(offset),
+                        _indirect_commands->info(batch.offset),
                         _draw_count_storage->info(index),
-                        meshes.size() + 1);
-                offset += meshes.size();
-                index++;
+                        batch.count + 1);
+            }
+        });
+
+        const auto record = [this](am::CRenderGraph& graph, am::CCommandBuffer& commands) noexcept {
+            commands.begin();
+            graph.execute(commands);
+            commands.end();
+            _elided_calls += commands.elided_calls();
+        };
+        AM_LIKELY_IF(async_compute) {
+            auto& shadow_commands = _commands->acquire(0);
+            auto& compute_commands = _compute_commands->acquire(0);
+            record(shadow_graph, shadow_commands);
+            record(compute_graph, compute_commands);
+            graphics_queue->submit({ { .command = &shadow_commands } });
+            // The previous frame must be done with the cull outputs and must have released the visibility depth
+            const auto compute_value = compute_queue->submit({ {
+                .stage_mask = am::EPipelineStage::ComputeShader,
+                .command = &compute_commands,
+                .wait_queue = graphics_queue,
+                .wait_queue_value = _graphics_value
+            } });
+            auto& commands = _commands->acquire(0);
+            record(main_graph, commands);
+            _graphics_value = graphics_queue->submit({ {
+                .stage_mask = am::EPipelineStage::Transfer,
+                .command = &commands,
+                .wait = _image_acq[_frame_index].get(),
+                .signal = _graphics_done[_frame_index].get(),
+            }, {
+                .stage_mask =
+                    am::EPipelineStage::DrawIndirect |
+                    am::EPipelineStage::VertexShader |
+                    am::EPipelineStage::FragmentShader |
+                    am::EPipelineStage::EarlyFragmentTests |
+                    am::EPipelineStage::LateFragmentTests,
+                .wait_queue = compute_queue,
+                .wait_queue_value = compute_value
+            } }, _fences[_frame_index].get());
+        } else {
+            auto& commands = _commands->acquire(0);
+            commands.begin();
+            if (statistics) {
+                commands.begin_query(_pipeline_statistics.get(), 0);
+            }
+            main_graph.execute(commands);
+            if (statistics) {
+                commands.end_query(_pipeline_statistics.get(), 0);
             }
+            commands.end();
+            _elided_calls += commands.elided_calls();
+            _graphics_value = graphics_queue->submit({ {
+                .stage_mask = am::EPipelineStage::Transfer,
+                .command = &commands,
+                .wait = _image_acq[_frame_index].get(),
+                .signal = _graphics_done[_frame_index].get(),
+            } }, _fences[_frame_index].get());
         }
         AM_UNLIKELY_IF(!_occlusion_cull) {
             _occlusion_cull = true;
         }
-        const auto object_count = (am::uint32)_object_storage[_frame_index]->size();
-        commands
-            .end_render_pass()
-            .begin_render_pass(_final_framebuffer.get())
-            .bind_pipeline(_final_pipeline.get())
-            .bind_descriptor_set(_final_set[_frame_index].get())
-            .bind_descriptor_set(_light_set[_frame_index].get())
-            .set_viewport(am::inverted_viewport_tag)
-            .set_scissor()
-            .push_constants(am::EShaderStage::Fragment, &object_count, sizeof object_count)
-            .draw(3, 1, 0, 0)
-            .end_render_pass();
-        _draw_ui(commands);
-        commands
-            .transition_layout({
-                .image = _swapchain->image(_image_index),
-                .source_stage = am::EPipelineStage::TopOfPipe,
-                .dest_stage = am::EPipelineStage::Transfer,
-                .source_access = am::EResourceAccess::None,
-                .dest_access = am::EResourceAccess::TransferWrite,
-                .old_layout = am::EImageLayout::Undefined,
-                .new_layout = am::EImageLayout::TransferDSTOptimal
-            })
-            .copy_image(_ui_context->framebuffer()->image(0), _swapchain->image(_image_index))
-            .transition_layout({
-                .image = _swapchain->image(_image_index),
-                .source_stage = am::EPipelineStage::Transfer,
-                .dest_stage = am::EPipelineStage::BottomOfPipe,
-                .source_access = am::EResourceAccess::TransferWrite,
-                .dest_access = am::EResourceAccess::None,
-                .old_layout = am::EImageLayout::TransferDSTOptimal,
-                .new_layout = am::EImageLayout::PresentSRC
-            })
-            .end_query(_pipeline_statistics.get(), 0)
-            .end();
-
-        _device->graphics_queue()->submit({ {
-            .stage_mask = am::EPipelineStage::Transfer,
-            .command = &commands,
-            .wait = _image_acq[_frame_index].get(),
-            .signal = _graphics_done[_frame_index].get(),
-        } }, _fences[_frame_index].get());
-
-        _device->graphics_queue()->present({
+
+        graphics_queue->present({
             .image = _image_index,
             .swapchain = _swapchain.get(),
             .wait = _graphics_done[_frame_index].get(),
         });
 
-        _store_pipeline_statistics();
+        if (statistics) {
+            _store_pipeline_statistics();
+        }
         AM_UNLIKELY_IF(_swapchain->is_lost()) {
             _resize_resources();
         }
@@ -1088,28 +1399,31 @@ public:
 private:
     void _resize_resources() noexcept {
         AM_PROFILE_SCOPED();
+        // The UI target is a render graph transient sized from the swapchain, rebound every frame
         _swapchain->recreate({ .vsync = _state.vsync, .srgb = false });
-        _ui_context->resize_framebuffer(_swapchain->width(), _swapchain->height());
     }
 
     void _build_object_data() noexcept {
         AM_PROFILE_SCOPED();
+        AM_LIKELY_IF(_object_data_version[_frame_index] == _scene.version) {
+            return;
+        }
+        _object_data_version[_frame_index] = _scene.version;
         std::vector<SObjectData> object_data;
         object_data.reserve(1024);
         am::uint32 offset = 0;
         am::uint32 instances = 0;
         _object_offset_storage[_frame_index]->clear();
         _instance_offset_storage[_frame_index]->clear();
-        _shadow_indirect_commands[_frame_index]->clear();
         for (am::uint32 index = 0; const auto& [mesh_buffer, meshes] : _scene.meshes) {
             const auto& [vertex_buffer, index_buffer] = mesh_buffer;
             for (const auto& each : meshes) {
                 const auto& geometry = each.mesh->geometry;
                 object_data.push_back(SObjectData {
                     .transform_index = { each.transform[0], each.transform[1] },
-                    .albedo_index = each.textures[0],
-                    .normal_index = each.textures[1],
-                    .specular_index = each.textures[2],
+                    .albedo_index = each.textures[0] ? each.textures[0]->slot() : am::CTextureHeap::null_slot,
+                    .normal_index = each.textures[1] ? each.textures[1]->slot() : am::CTextureHeap::null_slot,
+                    .specular_index = each.textures[2] ? each.textures[2]->slot() : am::CTextureHeap::null_slot,
                     .vertex_address = vertex_buffer->address(),
                     .index_address = index_buffer->address(),
                     .vertex_offset = (am::int32)geometry->vertex_offset(),
@@ -1133,13 +1447,6 @@ private:
                     }
                 });
                 _instance_offset_storage[_frame_index]->push_back(instances);
-                _shadow_indirect_commands[_frame_index]->push_back({
-                    .indices = each.mesh->indices,
-                    .instances = each.instances,
-                    .first_index = (am::uint32)geometry->index_offset(),
-                    .vertex_offset = (am::int32)geometry->vertex_offset(),
-                    .first_instance = 0
-                });
                 instances += each.instances;
             }
             _object_offset_storage[_frame_index]->push_back(offset);
@@ -1151,6 +1458,11 @@ private:
         _object_remap_storage->resize(object_data.size());
         _instance_remap_storage->resize(instances);
         _draw_count_storage->resize(_scene.meshes.size());
+        // Every cascade gets its own compacted copy of the draws
+        _shadow_indirect_commands[_frame_index]->resize(object_data.size() * AM_GLSL_MAX_CASCADES);
+        _shadow_object_remap_storage[_frame_index]->resize(object_data.size() * AM_GLSL_MAX_CASCADES);
+        _shadow_instance_remap_storage[_frame_index]->resize(instances * AM_GLSL_MAX_CASCADES);
+        _shadow_draw_count_storage[_frame_index]->resize(_scene.meshes.size() * AM_GLSL_MAX_CASCADES);
     }
 
     void _make_depth_pyramid(am::uint32 width, am::uint32 height) noexcept {
@@ -1197,13 +1509,431 @@ private:
             if (!_depth_pyramid_data[i].set) {
                 _depth_pyramid_data[i].set = am::CDescriptorSet::make(_device, {
                     .pool = _descriptor_pool,
-                    .pipeline = _depth_reduce_pipeline,
+                    .pipeline = _depth_reduce_pipeline->handle(),
                     .index = 0
                 });
             }
         }
     }
 
+    std::array<am::CAsyncPipeline*, 6> _pipelines() noexcept {
+        AM_PROFILE_SCOPED();
+        return {
+            _shadow_pipeline.get(),
+            _depth_reduce_pipeline.get(),
+            _cull_pipeline.get(),
+            _shadow_cull_pipeline.get(),
+            _visibility_pipeline.get(),
+            _final_pipeline.get()
+        };
+    }
+
+    SFrameResources _import_frame_resources(am::CRenderGraph& graph, bool async_compute) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto fragment_tests = am::EPipelineStage::EarlyFragmentTests | am::EPipelineStage::LateFragmentTests;
+        SFrameResources result = {};
+        result.shadow_map = graph.import_image({
+            .image = _shadow_framebuffer->image(0),
+            .layout = am::EImageLayout::ShaderReadOnlyOptimal
+        });
+        // Only live within the frame, the visibility buffer shares its memory with the UI target
+        const auto viewport = _visibility_framebuffer->viewport();
+        result.visibility_color = graph.create_image({
+            .usage = am::EImageUsage::ColorAttachment | am::EImageUsage::Storage,
+            .format = am::EResourceFormat::R32G32Uint,
+            .width = viewport.width,
+            .height = viewport.height
+        });
+        // Written by the previous frame, the depth pyramid is built from it. With async compute the semaphore
+        // and the ownership transfer take care of it instead
+        result.visibility_depth = graph.import_image({
+            .image = _visibility_framebuffer->image(1),
+            .stage = async_compute ? am::EPipelineStage::None : fragment_tests,
+            .access = async_compute ? am::EResourceAccess::None : am::EResourceAccess::DepthStencilAttachmentWrite,
+            .layout = am::EImageLayout::ShaderReadOnlyOptimal
+        });
+        result.depth_pyramid = graph.import_image({
+            .image = _depth_pyramid.get(),
+            .layout = am::EImageLayout::General
+        });
+        result.final_color = graph.create_image({
+            .usage = am::EImageUsage::ColorAttachment | am::EImageUsage::Sampled,
+            .format = _swapchain->format(),
+            .width = viewport.width,
+            .height = viewport.height
+        });
+        result.ui_color = graph.create_image({
+            .usage = am::EImageUsage::ColorAttachment | am::EImageUsage::TransferSRC,
+            .format = _swapchain->format(),
+            .width = _swapchain->width(),
+            .height = _swapchain->height()
+        });
+        result.swapchain_image = graph.import_image({
+            .image = _swapchain->image(_image_index),
+            .final_stage = am::EPipelineStage::BottomOfPipe,
+            .final_layout = am::EImageLayout::PresentSRC
+        });
+        result.shadow_indirect = graph.import_buffer({ .buffer = _shadow_indirect_commands[_frame_index]->info() });
+        result.shadow_draw_count = graph.import_buffer({ .buffer = _shadow_draw_count_storage[_frame_index]->info() });
+        result.shadow_object_remap = graph.import_buffer({ .buffer = _shadow_object_remap_storage[_frame_index]->info() });
+        result.shadow_instance_remap = graph.import_buffer({ .buffer = _shadow_instance_remap_storage[_frame_index]->info() });
+        result.indirect_commands = graph.import_buffer({ .buffer = _indirect_commands->info() });
+        result.draw_count = graph.import_buffer({
+            .buffer = _draw_count_storage->info(),
+            .final_stage = async_compute ? am::EPipelineStage::None : am::EPipelineStage::Host,
+            .final_access = async_compute ? am::EResourceAccess::None : am::EResourceAccess::HostRead
+        });
+        result.object_remap = graph.import_buffer({ .buffer = _object_remap_storage->info() });
+        result.instance_remap = graph.import_buffer({ .buffer = _instance_remap_storage->info() });
+        return result;
+    }
+
+    // Framebuffers and descriptors take this frame's transient images, before anything is recorded against them
+    void _bind_transient_images(const am::CRenderGraph& graph, const SFrameResources& resources) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto* visibility = graph.image(resources.visibility_color);
+        _visibility_framebuffer->update_attachment(0, visibility);
+        _final_framebuffer->update_attachment(0, graph.image(resources.final_color));
+        _ui_context->bind_framebuffer(graph.image(resources.ui_color));
+        _final_set[_frame_index]->bind(_final_bindings.visibility, visibility);
+        _descriptor_writes += _final_set[_frame_index]->flush();
+    }
+
+    void _add_shadow_pass(am::CRenderGraph& graph, const SFrameResources& resources) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto cull_stages = am::EPipelineStage::Transfer | am::EPipelineStage::ComputeShader;
+        const auto cull_access =
+            am::EResourceAccess::TransferWrite |
+            am::EResourceAccess::ShaderRead |
+            am::EResourceAccess::ShaderWrite;
+        graph.add_pass({
+            .name = "shadow cull",
+            .writes = {
+                { resources.shadow_indirect, cull_stages, cull_access },
+                { resources.shadow_draw_count, cull_stages, cull_access },
+                { resources.shadow_object_remap, cull_stages, cull_access },
+                { resources.shadow_instance_remap, cull_stages, cull_access },
+            }
+        }, [this](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+            const auto object_count = (am::uint32)_object_storage[_frame_index]->size();
+            const am::uint32 constants[] = {
+                object_count,
+                (am::uint32)_shadow_instance_remap_storage[_frame_index]->size() / AM_GLSL_MAX_CASCADES,
+                (am::uint32)_mesh_batches.size()
+            };
+            const auto pipeline = _shadow_cull_pipeline->handle()->variant({ { 0, _state.shadow_culling } });
+            // Counts are accumulated with atomics, they start from zero every frame
+            const auto draw_count = _shadow_draw_count_storage[_frame_index]->info();
+            commands
+                .fill_buffer(draw_count)
+                .barrier({
+                    .buffer = draw_count,
+                    .source_stage = am::EPipelineStage::Transfer,
+                    .dest_stage = am::EPipelineStage::ComputeShader,
+                    .source_access = am::EResourceAccess::TransferWrite,
+                    .dest_access = am::EResourceAccess::ShaderRead | am::EResourceAccess::ShaderWrite
+                })
+                .bind_pipeline(pipeline.get())
+                .bind_descriptor_set(_shadow_cull_set[_frame_index].get())
+                .push_constants(am::EShaderStage::Compute, constants, sizeof constants)
+                .dispatch((object_count / 256) + 1, AM_GLSL_MAX_CASCADES);
+        });
+        graph.add_pass({
+            .name = "shadows",
+            .reads = {
+                { resources.shadow_indirect, am::EPipelineStage::DrawIndirect, am::EResourceAccess::IndirectCommandRead },
+                { resources.shadow_draw_count, am::EPipelineStage::DrawIndirect, am::EResourceAccess::IndirectCommandRead },
+                { resources.shadow_object_remap, am::EPipelineStage::VertexShader, am::EResourceAccess::ShaderRead },
+                { resources.shadow_instance_remap, am::EPipelineStage::VertexShader, am::EResourceAccess::ShaderRead },
+            },
+            .writes = { {
+                .resource = resources.shadow_map,
+                .stage = am::EPipelineStage::EarlyFragmentTests | am::EPipelineStage::LateFragmentTests,
+                .access = am::EResourceAccess::DepthStencilAttachmentWrite,
+                .final_layout = am::EImageLayout::ShaderReadOnlyOptimal
+            } }
+        }, [this](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+            commands
+                .begin_render_pass(_shadow_framebuffer.get(), am::secondary_commands_tag)
+                .execute(_count_elided_calls(_recorder->wait(_shadow_job)))
+                .end_render_pass();
+        });
+    }
+
+    void _add_cull_passes(am::CRenderGraph& graph, const SFrameResources& resources, bool async_compute) noexcept {
+        AM_PROFILE_SCOPED();
+        if (_occlusion_cull && _state.occlusion_culling) {
+            graph.add_pass({
+                .name = "depth pyramid",
+                .reads = { {
+                    .resource = resources.visibility_depth,
+                    .stage = am::EPipelineStage::ComputeShader,
+                    .access = am::EResourceAccess::ShaderRead,
+                    .layout = am::EImageLayout::ShaderReadOnlyOptimal
+                }, {
+                    .resource = resources.depth_pyramid,
+                    .stage = am::EPipelineStage::ComputeShader,
+                    .access = am::EResourceAccess::ShaderRead,
+                    .layout = am::EImageLayout::General
+                } },
+                .writes = { {
+                    .resource = resources.depth_pyramid,
+                    .stage = am::EPipelineStage::ComputeShader,
+                    .access = am::EResourceAccess::ShaderWrite,
+                    .layout = am::EImageLayout::General
+                } }
+            }, [this, async_compute](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+                if (async_compute) {
+                    // Matches the release recorded after last frame's visibility pass
+                    commands.transfer_ownership(*_device->graphics_queue(), *_device->compute_queue(), {
+                        .image = _visibility_framebuffer->image(1),
+                        .source_stage = am::EPipelineStage::TopOfPipe,
+                        .dest_stage = am::EPipelineStage::ComputeShader,
+                        .source_access = am::EResourceAccess::None,
+                        .dest_access = am::EResourceAccess::ShaderRead,
+                        .old_layout = am::EImageLayout::ShaderReadOnlyOptimal,
+                        .new_layout = am::EImageLayout::ShaderReadOnlyOptimal
+                    });
+                }
+                for (am::uint32 i = 0; i < _depth_pyramid->mips(); ++i) {
+                    const am::uint32 constants[] = {
+                        std::max(_depth_pyramid->width() >> i, 1u),
+                        std::max(_depth_pyramid->height() >> i, 1u)
+                    };
+                    commands
+                        .bind_pipeline(_depth_reduce_pipeline->handle().get())
+                        .bind_descriptor_set(_depth_pyramid_data[i].set.get())
+                        .push_constants(am::EShaderStage::Compute, constants, sizeof constants)
+                        .dispatch(
+                            (constants[0] + 16 - 1) / 16,
+                            (constants[1] + 16 - 1) / 16);
+                    // The graph orders the last mip against the culling pass
+                    if (i + 1 < _depth_pyramid->mips()) {
+                        commands.barrier({
+                            .image = _depth_pyramid.get(),
+                            .source_stage = am::EPipelineStage::ComputeShader,
+                            .dest_stage = am::EPipelineStage::ComputeShader,
+                            .source_access = am::EResourceAccess::ShaderWrite,
+                            .dest_access = am::EResourceAccess::ShaderRead,
+                            .old_layout = am::EImageLayout::General,
+                            .new_layout = am::EImageLayout::General,
+                            .mip = i
+                        });
+                    }
+                }
+            });
+        }
+        const auto cull_output = [](am::uint32 resource) noexcept {
+            return am::SRenderGraphAccess {
+                .resource = resource,
+                .stage = am::EPipelineStage::ComputeShader,
+                .access = am::EResourceAccess::ShaderWrite
+            };
+        };
+        graph.add_pass({
+            .name = "cull",
+            .reads = { {
+                .resource = resources.depth_pyramid,
+                .stage = am::EPipelineStage::ComputeShader,
+                .access = am::EResourceAccess::ShaderRead,
+                .layout = am::EImageLayout::General
+            } },
+            .writes = {
+                cull_output(resources.indirect_commands),
+                cull_output(resources.draw_count),
+                cull_output(resources.object_remap),
+                cull_output(resources.instance_remap),
+            }
+        }, [this](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+            // Toggling a culling mode swaps variants, the workgroup size is specialized along with them
+            constexpr auto group_size = 256u;
+            const auto pipeline = _cull_pipeline->handle()->variant({
+                { 0, _state.frustum_culling },
+                { 1, _occlusion_cull && _state.occlusion_culling },
+                { 2, group_size }
+            });
+            const am::uint32 cull_constants[] = {
+                (am::uint32)_draw_count_storage->size()
+            };
+            commands
+                .bind_pipeline(pipeline.get())
+                .bind_descriptor_set(_cull_set[_frame_index].get())
+                .push_constants(am::EShaderStage::Compute, cull_constants, sizeof cull_constants)
+                .dispatch((_object_storage[_frame_index]->size() / group_size) + 1);
+        });
+        AM_UNLIKELY_IF(!async_compute) {
+            return;
+        }
+        graph.add_pass({
+            .name = "release cull outputs",
+            .side_effects = true
+        }, [this](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+            am::CBarrierBatch barriers;
+            for (const auto& buffer : _cull_outputs()) {
+                barriers.transfer_ownership(*_device->compute_queue(), *_device->graphics_queue(), {
+                    .buffer = buffer,
+                    .source_stage = am::EPipelineStage::ComputeShader,
+                    .dest_stage = am::EPipelineStage::BottomOfPipe,
+                    .source_access = am::EResourceAccess::ShaderWrite,
+                    .dest_access = am::EResourceAccess::None
+                });
+            }
+            commands.barrier(barriers);
+        });
+    }
+
+    void _add_main_passes(am::CRenderGraph& graph, const SFrameResources& resources, bool async_compute) noexcept {
+        AM_PROFILE_SCOPED();
+        const auto fragment_tests = am::EPipelineStage::EarlyFragmentTests | am::EPipelineStage::LateFragmentTests;
+        const auto remap_stages = am::EPipelineStage::VertexShader | am::EPipelineStage::FragmentShader;
+        if (async_compute) {
+            graph.add_pass({
+                .name = "acquire cull outputs",
+                .side_effects = true
+            }, [this, remap_stages](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+                am::CBarrierBatch barriers;
+                for (am::uint32 index = 0; const auto& buffer : _cull_outputs()) {
+                    // The first two are consumed by the indirect draws, the remap tables by the shaders
+                    const auto indirect = index++ < 2;
+                    barriers.transfer_ownership(*_device->compute_queue(), *_device->graphics_queue(), {
+                        .buffer = buffer,
+                        .source_stage = am::EPipelineStage::TopOfPipe,
+                        .dest_stage = indirect ? am::EPipelineStage::DrawIndirect : remap_stages,
+                        .source_access = am::EResourceAccess::None,
+                        .dest_access = indirect ? am::EResourceAccess::IndirectCommandRead : am::EResourceAccess::ShaderRead
+                    });
+                }
+                commands.barrier(barriers);
+            });
+        }
+        graph.add_pass({
+            .name = "visibility",
+            .reads = {
+                { resources.indirect_commands, am::EPipelineStage::DrawIndirect, am::EResourceAccess::IndirectCommandRead },
+                { resources.draw_count, am::EPipelineStage::DrawIndirect, am::EResourceAccess::IndirectCommandRead },
+                { resources.object_remap, remap_stages, am::EResourceAccess::ShaderRead },
+                { resources.instance_remap, remap_stages, am::EResourceAccess::ShaderRead },
+            },
+            .writes = { {
+                .resource = resources.visibility_color,
+                .stage = am::EPipelineStage::ColorAttachmentOutput,
+                .access = am::EResourceAccess::ColorAttachmentWrite,
+                .final_layout = am::EImageLayout::General
+            }, {
+                .resource = resources.visibility_depth,
+                .stage = fragment_tests,
+                .access = am::EResourceAccess::DepthStencilAttachmentWrite,
+                .final_layout = am::EImageLayout::ShaderReadOnlyOptimal
+            } }
+        }, [this](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+            commands
+                .begin_render_pass(_visibility_framebuffer.get(), am::secondary_commands_tag)
+                .execute(_count_elided_calls(_recorder->wait(_visibility_job)))
+                .end_render_pass();
+        });
+        if (async_compute) {
+            graph.add_pass({
+                .name = "release visibility depth",
+                .side_effects = true
+            }, [this, fragment_tests](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+                commands.transfer_ownership(*_device->graphics_queue(), *_device->compute_queue(), {
+                    .image = _visibility_framebuffer->image(1),
+                    .source_stage = fragment_tests,
+                    .dest_stage = am::EPipelineStage::BottomOfPipe,
+                    .source_access = am::EResourceAccess::DepthStencilAttachmentWrite,
+                    .dest_access = am::EResourceAccess::None,
+                    .old_layout = am::EImageLayout::ShaderReadOnlyOptimal,
+                    .new_layout = am::EImageLayout::ShaderReadOnlyOptimal
+                });
+            });
+        }
+        graph.add_pass({
+            .name = "final",
+            .reads = { {
+                .resource = resources.visibility_color,
+                .stage = am::EPipelineStage::FragmentShader,
+                .access = am::EResourceAccess::ShaderRead,
+                .layout = am::EImageLayout::General
+            }, {
+                .resource = resources.shadow_map,
+                .stage = am::EPipelineStage::FragmentShader,
+                .access = am::EResourceAccess::ShaderRead,
+                .layout = am::EImageLayout::ShaderReadOnlyOptimal
+            } },
+            .writes = { {
+                .resource = resources.final_color,
+                .stage = am::EPipelineStage::ColorAttachmentOutput,
+                .access = am::EResourceAccess::ColorAttachmentWrite,
+                .final_layout = am::EImageLayout::ShaderReadOnlyOptimal
+            } }
+        }, [this](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+            const auto object_count = (am::uint32)_object_storage[_frame_index]->size();
+            commands
+                .begin_render_pass(_final_framebuffer.get())
+                .bind_pipeline(_final_pipeline->handle().get())
+                .bind_descriptor_set(_final_set[_frame_index].get())
+                .bind_descriptor_set(_light_set[_frame_index].get())
+                .bind_texture_heap()
+                .set_viewport(am::inverted_viewport_tag)
+                .set_scissor()
+                .push_constants(am::EShaderStage::Fragment, &object_count, sizeof object_count)
+                .draw(3, 1, 0, 0)
+                .end_render_pass();
+        });
+        graph.add_pass({
+            .name = "ui",
+            .reads = { {
+                .resource = resources.final_color,
+                .stage = am::EPipelineStage::FragmentShader,
+                .access = am::EResourceAccess::ShaderRead,
+                .layout = am::EImageLayout::ShaderReadOnlyOptimal
+            } },
+            .writes = { {
+                .resource = resources.ui_color,
+                .stage = am::EPipelineStage::ColorAttachmentOutput,
+                .access = am::EResourceAccess::ColorAttachmentWrite,
+                .final_layout = am::EImageLayout::TransferSRCOptimal
+            } }
+        }, [this](am::CCommandBuffer& commands, const am::CRenderGraph&) noexcept {
+            _draw_ui(commands);
+        });
+        graph.add_pass({
+            .name = "present",
+            .reads = { {
+                .resource = resources.ui_color,
+                .stage = am::EPipelineStage::Transfer,
+                .access = am::EResourceAccess::TransferRead,
+                .layout = am::EImageLayout::TransferSRCOptimal
+            } },
+            .writes = { {
+                .resource = resources.swapchain_image,
+                .stage = am::EPipelineStage::Transfer,
+                .access = am::EResourceAccess::TransferWrite,
+                .layout = am::EImageLayout::TransferDSTOptimal
+            } }
+        }, [ui_color = resources.ui_color, swapchain_image = resources.swapchain_image](am::CCommandBuffer& commands, const am::CRenderGraph& graph) noexcept {
+            commands.copy_image(graph.image(ui_color), graph.image(swapchain_image));
+        });
+    }
+
+    const std::vector<am::CCommandBuffer*>& _count_elided_calls(const std::vector<am::CCommandBuffer*>& commands) noexcept {
+        AM_PROFILE_SCOPED();
+        for (const auto* each : commands) {
+            _elided_calls += each->elided_calls();
+        }
+        return commands;
+    }
+
+    std::array<am::SBufferInfo, 4> _cull_outputs() const noexcept {
+        AM_PROFILE_SCOPED();
+        return {
+            _indirect_commands->info(),
+            _draw_count_storage->info(),
+            _object_remap_storage->info(),
+            _instance_remap_storage->info()
+        };
+    }
+
     void _draw_ui(am::CCommandBuffer& commands) noexcept {
         AM_PROFILE_SCOPED();
         _ui_context->render_frame(commands, [this]() noexcept {
@@ -1240,15 +1970,17 @@ private:
             if (!ImGui::IsAnyMouseDown()) {
                 _viewport_size = ImGui::GetContentRegionAvail();
             }
-            _ui_set->bind(
-                am::make_descriptor_binding(0, am::EDescriptorType::CombinedImageSampler),
+            // The final image is a transient of this frame's graph, so is the set sampling it
+            _ui_set[_frame_index]->bind(
+                _ui_set[_frame_index]->handle(0),
                 _device->sample(_final_framebuffer->image(0), {
                     .filter = am::EFilter::Nearest,
                     .mip_mode = am::EMipMode::Nearest,
                     .border_color = am::EBorderColor::FloatOpaqueBlack,
                     .address_mode = am::EAddressMode::Repeat
                 }));
-            ImGui::Image((ImTextureID)_ui_set->native(), _viewport_size);
+            _descriptor_writes += _ui_set[_frame_index]->flush();
+            ImGui::Image((ImTextureID)_ui_set[_frame_index]->native(), _viewport_size);
             ImGui::End();
 
             ImGui::Begin("settings");
@@ -1268,6 +2000,92 @@ private:
                 }
                 ImGui::Separator();
             }
+            {
+                const auto stats = _device->completion_poller()->stats();
+                if (ImGui::CollapsingHeader("async uploads", ImGuiTreeNodeFlags_DefaultOpen)) {
+                    ImGui::Text(" - in flight: %llu", stats.pending);
+                    ImGui::Text(" - completed: %llu", stats.completed);
+                    ImGui::Text(" - pending graphics acquires: %u", _device->graphics_queue()->pending_acquires());
+                    ImGui::Text(" - upload wait not spent on workers: %.3fs", stats.wait_time);
+                    const auto recycled = _device->recycler()->stats();
+                    ImGui::Text(" - recycled command buffers: %llu/%llu", recycled.commands.hits, recycled.commands.hits + recycled.commands.creations);
+                    ImGui::Text(" - recycled semaphores: %llu/%llu", recycled.semaphores.hits, recycled.semaphores.hits + recycled.semaphores.creations);
+                    ImGui::Text(" - recycled fences: %llu/%llu", recycled.fences.hits, recycled.fences.hits + recycled.fences.creations);
+                }
+                ImGui::Separator();
+            }
+            {
+                // The current frame's graphs are still executing, show the last complete ones
+                const auto& graphs = _graphs[(_frame_index + am::frames_in_flight - 1) % am::frames_in_flight];
+                am::SRenderGraphStats stats = {};
+                for (const auto* graph : { graphs.shadow.get(), graphs.compute.get(), graphs.main.get() }) {
+                    const auto& each = graph->stats();
+                    stats.passes += each.passes;
+                    stats.culled += each.culled;
+                    stats.barriers += each.barriers;
+                    stats.batches += each.batches;
+                    stats.transient_images += each.transient_images;
+                    stats.transient_bytes += each.transient_bytes;
+                    stats.allocated_bytes += each.allocated_bytes;
+                }
+                if (ImGui::CollapsingHeader("render graph", ImGuiTreeNodeFlags_DefaultOpen)) {
+                    ImGui::Text(" - passes: %d (%d culled)", stats.passes, stats.culled);
+                    ImGui::Text(" - barriers: %d in %d batches", stats.barriers, stats.batches);
+                    ImGui::Text(" - redundant binds skipped: %d", _last_elided_calls);
+                    ImGui::Text(" - descriptor writes: %d", _descriptor_writes);
+                    AM_LIKELY_IF(const auto* heap = _device->texture_heap()) {
+                        const auto heap_stats = heap->stats();
+                        ImGui::Text(" - texture heap slots: %u/%u", heap_stats.live_slots, heap_stats.capacity);
+                    }
+                    ImGui::Text(" - transient images: %d", stats.transient_images);
+                    ImGui::Text(" - transient memory: %llukB", stats.allocated_bytes / 1024);
+                    ImGui::Text(" - saved by aliasing: %llukB", (stats.transient_bytes - stats.allocated_bytes) / 1024);
+                }
+                ImGui::Separator();
+            }
+            {
+                const auto stats = _device->image_pool()->stats();
+                if (ImGui::CollapsingHeader("render targets", ImGuiTreeNodeFlags_DefaultOpen)) {
+                    ImGui::Text(" - dynamic rendering: %s", _visibility_pass->is_dynamic() ? "yes" : "no");
+                    ImGui::Text(" - live images: %d", stats.live_images);
+                    ImGui::Text(" - reused blocks: %llu/%llu", stats.hits, stats.hits + stats.allocations);
+                    ImGui::Text(" - idle blocks: %d", stats.idle_blocks);
+                    ImGui::Text(" - pooled memory: %llukB", stats.allocated_bytes / 1024);
+                }
+                ImGui::Separator();
+            }
+            {
+                const auto stats = _device->shader_cache()->stats();
+                if (ImGui::CollapsingHeader("shader cache", ImGuiTreeNodeFlags_DefaultOpen)) {
+                    ImGui::Text(" - hits: %llu/%llu", stats.hits, stats.hits + stats.misses);
+                    ImGui::Text(" - compile time: %.2fms", stats.compile_ms);
+                    ImGui::Text(" - time saved: %.2fms", stats.saved_ms);
+                    ImGui::Text(" - startup pipelines: %.2fms", _state.pipeline_startup_time);
+                }
+                ImGui::Separator();
+            }
+            {
+                auto* profiler = _device->gpu_profiler();
+                if (profiler->is_supported() && ImGui::CollapsingHeader("gpu timings", ImGuiTreeNodeFlags_DefaultOpen)) {
+                    const char* queue_names[] = { "graphics", "transfer", "compute" };
+                    for (const auto& zone : profiler->zones()) {
+                        ImGui::Text(
+                            " - %*s%s (%s): %.3fms (avg: %.3fms, max: %.3fms)",
+                            (int)zone.depth * 2, "",
+                            zone.name,
+                            queue_names[(am::uint32)zone.queue],
+                            zone.last_ms,
+                            zone.average_ms,
+                            zone.max_ms);
+                    }
+                    const auto stats = profiler->stats();
+                    ImGui::Text(" - dropped frames: %llu, dropped zones: %llu", stats.dropped_frames, stats.dropped_zones);
+                    if (ImGui::Button("export chrome trace")) {
+                        (void)profiler->write_chrome_trace("gpu_trace.json");
+                    }
+                }
+                ImGui::Separator();
+            }
             {
                 if (ImGui::CollapsingHeader("frame time plot", ImGuiTreeNodeFlags_DefaultOpen)) {
                     if (ImPlot::BeginPlot("frame time", { -1, 0 }, ImPlotFlags_Crosshairs)) {
@@ -1308,7 +2126,9 @@ private:
                 _swapchain->set_lost();
             }
             ImGui::Checkbox("frustum culling", &_state.frustum_culling);
+            ImGui::Checkbox("shadow cascade culling", &_state.shadow_culling);
             ImGui::Checkbox("occlusion culling", &_state.occlusion_culling);
+            ImGui::Checkbox("async compute", &_state.async_compute);
             ImGui::End();
 
             ImGui::Begin("scene");
@@ -1362,10 +2182,14 @@ private:
                             std::snprintf(t_label, 32, "instance %d", t_idx);
                             if (ImGui::CollapsingHeader(t_label)) {
                                 ImGui::PushID(t_label);
-                                ImGui::InputFloat3("position", &transform.position.x);
-                                ImGui::InputFloat3("rotation axis", &transform.rotation.axis.x);
-                                ImGui::InputFloat("rotation angle", &transform.rotation.angle);
-                                ImGui::InputFloat3("scale", &transform.scale.x);
+                                bool edited = false;
+                                edited |= ImGui::InputFloat3("position", &transform.position.x);
+                                edited |= ImGui::InputFloat3("rotation axis", &transform.rotation.axis.x);
+                                edited |= ImGui::InputFloat("rotation angle", &transform.rotation.angle);
+                                edited |= ImGui::InputFloat3("scale", &transform.scale.x);
+                                AM_UNLIKELY_IF(edited) {
+                                    _scene.dirty_draws.push_back(m_idx);
+                                }
                                 ImGui::PopID();
                             }
                             t_idx++;
@@ -1412,22 +2236,37 @@ private:
     am::CRcPtr<am::CFramebuffer> _shadow_framebuffer;
     am::CRcPtr<am::CFramebuffer> _visibility_framebuffer;
     am::CRcPtr<am::CFramebuffer> _final_framebuffer;
-    am::CRcPtr<am::CPipeline> _shadow_pipeline;
-    am::CRcPtr<am::CPipeline> _depth_reduce_pipeline;
-    am::CRcPtr<am::CPipeline> _cull_pipeline;
-    am::CRcPtr<am::CPipeline> _visibility_pipeline;
-    am::CRcPtr<am::CPipeline> _final_pipeline;
+    am::CRcPtr<am::CAsyncPipeline> _shadow_pipeline;
+    am::CRcPtr<am::CAsyncPipeline> _depth_reduce_pipeline;
+    am::CRcPtr<am::CAsyncPipeline> _cull_pipeline;
+    am::CRcPtr<am::CAsyncPipeline> _shadow_cull_pipeline;
+    am::CRcPtr<am::CAsyncPipeline> _visibility_pipeline;
+    am::CRcPtr<am::CAsyncPipeline> _final_pipeline;
+    am::CRcPtr<am::CShaderWatcher> _shader_watcher;
     am::CRcPtr<am::CQueryPool> _pipeline_statistics;
     std::unique_ptr<am::CUIContext> _ui_context;
-    std::vector<am::CRcPtr<am::CCommandBuffer>> _commands;
+    am::CRcPtr<am::CCommandAllocator> _commands;
+    am::CRcPtr<am::CParallelRecorder> _recorder;
+    am::uint32 _shadow_job = 0;
+    am::uint32 _visibility_job = 0;
+    am::CRcPtr<am::CCommandAllocator> _compute_commands;
+    std::vector<SFrameGraphs> _graphs;
+    std::vector<am::tst::SMeshBatch> _mesh_batches;
 
     // Descriptors
+    am::tst::SBindings _shadow_bindings;
+    am::tst::SBindings _cull_bindings;
+    am::tst::SBindings _shadow_cull_bindings;
+    am::tst::SBindings _visibility_bindings;
+    am::tst::SBindings _depth_reduce_bindings;
+    am::tst::SBindings _final_bindings;
     std::vector<am::CRcPtr<am::CDescriptorSet>> _shadow_set;
     std::vector<am::CRcPtr<am::CDescriptorSet>> _cull_set;
+    std::vector<am::CRcPtr<am::CDescriptorSet>> _shadow_cull_set;
     std::vector<am::CRcPtr<am::CDescriptorSet>> _visibility_set;
     std::vector<am::CRcPtr<am::CDescriptorSet>> _final_set;
     std::vector<am::CRcPtr<am::CDescriptorSet>> _light_set;
-    am::CRcPtr<am::CDescriptorSet> _ui_set;
+    std::vector<am::CRcPtr<am::CDescriptorSet>> _ui_set;
     ImVec2 _viewport_size = {};
 
     // Data
@@ -1442,6 +2281,9 @@ private:
     std::vector<am::CRcPtr<am::CTypedBuffer<SDirectionalLight>>> _directional_light_storage;
     std::vector<am::CRcPtr<am::CTypedBuffer<SObjectData>>> _object_storage;
     std::vector<am::CRcPtr<am::CTypedBuffer<am::SDrawCommandIndexedIndirect>>> _shadow_indirect_commands;
+    std::vector<am::CRcPtr<am::CTypedBuffer<am::uint32>>> _shadow_draw_count_storage;
+    std::vector<am::CRcPtr<am::CTypedBuffer<am::uint32>>> _shadow_object_remap_storage;
+    std::vector<am::CRcPtr<am::CTypedBuffer<am::uint32>>> _shadow_instance_remap_storage;
     am::CRcPtr<am::CTypedBuffer<am::SDrawCommandIndexedIndirect>> _indirect_commands;
     std::vector<am::CRcPtr<am::CTypedBuffer<am::uint32>>> _object_offset_storage;
     std::vector<am::CRcPtr<am::CTypedBuffer<am::uint32>>> _instance_offset_storage;
@@ -1451,10 +2293,10 @@ private:
 
     // Scene data
     am::tst::SScene _scene;
+    std::array<am::uint64, am::frames_in_flight> _object_data_version = {};
     am::tst::CCamera _camera;
     SCameraData _old_camera;
     std::vector<am::tst::SDraw> _draws;
-    am::CRcPtr<am::CAsyncTexture> _default_texture;
     std::vector<am::CRcPtr<am::CAsyncModel>> _models;
 
     // Synchronization
@@ -1473,6 +2315,11 @@ private:
     // State config
     SEngineState _state = {};
     bool _occlusion_cull = false;
+    bool _async_compute = false;
+    am::uint64 _graphics_value = 0;
+    am::uint32 _elided_calls = 0;
+    am::uint32 _last_elided_calls = 0;
+    am::uint32 _descriptor_writes = 0;
 };
 
 int main() {
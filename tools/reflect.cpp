@@ -0,0 +1,30 @@
+#include <amethyst/graphics/shader_reflection.hpp>
+
+#include <fstream>
+#include <cstdio>
+
+// Build-time half of "SShaderReflection": reflects a SPIR-V module produced by the "amethyst_shaders" target and writes
+// the result next to it, so the runtime never has to parse the module.
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: %s <input.spv> <output.refl>\n", argv[0]);
+        return 1;
+    }
+    std::ifstream file(argv[1], std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::fprintf(stderr, "cannot open \"%s\"\n", argv[1]);
+        return 1;
+    }
+    std::vector<am::uint32> binary((am::uint64)file.tellg() / sizeof(am::uint32));
+    file.seekg(0);
+    file.read((char*)binary.data(), am::size_bytes(binary));
+    if (!file || binary.empty() || binary[0] != 0x07230203) {
+        std::fprintf(stderr, "\"%s\" is not a SPIR-V module\n", argv[1]);
+        return 1;
+    }
+    if (!am::SShaderReflection::make(binary).save(argv[2])) {
+        std::fprintf(stderr, "cannot write \"%s\"\n", argv[2]);
+        return 1;
+    }
+    return 0;
+}